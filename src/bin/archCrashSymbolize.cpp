@@ -0,0 +1,70 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+// Writes a symbolized report of crash records written by
+// ArchWriteCrashRecord() or by the in-process crash reporter.
+
+#include <pxr/arch/crashRecord.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace pxr;
+
+static int
+_Usage(const char* program)
+{
+    std::cerr
+        << "Usage: " << program << " [-d DIR]... RECORD...\n\n"
+        << "Symbolize crash records.  Modules are looked up at their\n"
+        << "recorded path and then by name in each DIR.\n";
+    return 2;
+}
+
+int
+main(int argc, char** argv)
+{
+    std::vector<std::string> searchPaths;
+    std::vector<std::string> records;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-d") == 0) {
+            if (++i == argc) {
+                return _Usage(argv[0]);
+            }
+            searchPaths.push_back(argv[i]);
+        }
+        else if (strcmp(argv[i], "-h") == 0 ||
+                 strcmp(argv[i], "--help") == 0) {
+            _Usage(argv[0]);
+            return 0;
+        }
+        else {
+            records.push_back(argv[i]);
+        }
+    }
+    if (records.empty()) {
+        return _Usage(argv[0]);
+    }
+
+    int result = 0;
+    for (size_t i = 0; i != records.size(); ++i) {
+        ArchCrashRecord record;
+        std::string error;
+        if (!ArchReadCrashRecord(records[i], &record, &error)) {
+            std::cerr << argv[0] << ": " << error << '\n';
+            result = 1;
+            continue;
+        }
+        if (i != 0) {
+            std::cout << '\n';
+        }
+        ArchSymbolizeCrashRecord(record, std::cout, searchPaths);
+    }
+    return result;
+}
@@ -20,6 +20,9 @@
 #include "./defines.h"
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
 
 namespace pxr {
 
@@ -74,6 +77,98 @@ ARCH_API
 void
 ArchAlignedFree(void* ptr);
 
+/// \class ArchAlignedAllocator
+///
+/// STL-compatible allocator returning storage aligned to \p Alignment bytes.
+///
+/// Storage is obtained from \c ArchAlignedAlloc() and released with
+/// \c ArchAlignedFree().  The default alignment is a cache line, which keeps
+/// buffers shared between threads from straddling lines and suits SIMD loads:
+///
+/// \code
+/// std::vector<float, ArchAlignedAllocator<float>> samples;
+/// \endcode
+///
+/// The effective alignment is never less than \c alignof(T), so rebinding
+/// to an over-aligned node type in a container remains correct.  Allocation
+/// sizes are rounded up to a multiple of the alignment, as some
+/// \c aligned_alloc() implementations require.  All instances with the same
+/// alignment compare equal.
+///
+template <class T, size_t Alignment = ARCH_CACHE_LINE_SIZE>
+class ArchAlignedAllocator
+{
+    static_assert(Alignment != 0 && (Alignment & (Alignment - 1)) == 0,
+                  "Alignment must be a power of two");
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    template <class U>
+    struct rebind {
+        using other = ArchAlignedAllocator<U, Alignment>;
+    };
+
+    /// The alignment in bytes of every allocation.
+    static constexpr size_t alignment =
+        Alignment < alignof(T) ? alignof(T) : Alignment;
+
+    ArchAlignedAllocator() noexcept = default;
+
+    template <class U>
+    ArchAlignedAllocator(const ArchAlignedAllocator<U, Alignment>&) noexcept
+    {
+    }
+
+    /// Allocate uninitialized storage for \p n objects of type \c T.
+    /// Throws \c std::bad_alloc on failure.
+    T* allocate(size_t n)
+    {
+        if (n > max_size()) {
+            throw std::bad_array_new_length();
+        }
+        // Round up to a non-zero multiple of the alignment.
+        const size_t bytes =
+            (n * sizeof(T) + alignment - 1 + (n == 0)) & ~(alignment - 1);
+        if (void* ptr = ArchAlignedAlloc(alignment, bytes)) {
+            return static_cast<T*>(ptr);
+        }
+        throw std::bad_alloc();
+    }
+
+    /// Release storage returned by allocate().
+    void deallocate(T* ptr, size_t) noexcept
+    {
+        ArchAlignedFree(ptr);
+    }
+
+    /// Return the largest number of objects allocate() may succeed for.
+    static constexpr size_t max_size() noexcept
+    {
+        return (std::numeric_limits<size_t>::max() - alignment) / sizeof(T);
+    }
+};
+
+template <class T, class U, size_t Alignment>
+constexpr bool
+operator==(const ArchAlignedAllocator<T, Alignment>&,
+           const ArchAlignedAllocator<U, Alignment>&) noexcept
+{
+    return true;
+}
+
+template <class T, class U, size_t Alignment>
+constexpr bool
+operator!=(const ArchAlignedAllocator<T, Alignment>&,
+           const ArchAlignedAllocator<U, Alignment>&) noexcept
+{
+    return false;
+}
+
 }  // namespace pxr
 
 #endif	// PXR_ARCH_ALIGN_H
@@ -0,0 +1,483 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include "./appendLog.h"
+#include "./defines.h"
+#include "./errno.h"
+#include "./systemInfo.h"
+#include "./threads.h"
+#include "./virtualMemory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if !defined(ARCH_OS_WINDOWS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace pxr {
+
+#if !defined(ARCH_OS_WINDOWS)
+
+namespace {
+
+size_t
+_RoundUp(size_t value, size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+} // anonymous namespace
+
+class ArchAppendLog::_Impl {
+public:
+    // Takes ownership of fd.  Returns nullptr and sets *error on failure.
+    static _Impl* New(int fd, uint64_t length, size_t extentSize,
+                      size_t maxSize, std::string* error);
+
+    ~_Impl()
+    {
+        std::string error;
+        Close(&error);
+    }
+
+    char* Reserve(size_t size, uint64_t* offset);
+    bool Commit(uint64_t offset, size_t size);
+    bool Flush();
+    bool Close(std::string* error);
+
+    uint64_t GetCommittedSize() const
+    {
+        return _committed.load(std::memory_order_acquire);
+    }
+
+    std::string GetError()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _error;
+    }
+
+private:
+    _Impl(int fd, char* base, uint64_t length, size_t extentSize,
+          size_t maxSize)
+        : _fd(fd), _base(base), _extentSize(extentSize), _maxSize(maxSize)
+        , _reserved(length), _committed(length), _mapped(0)
+        , _failedAt(UINT64_MAX), _flushed(length), _synced(length)
+    {
+    }
+
+    bool _Grow(uint64_t end);
+    bool _GrowLocked(uint64_t end, bool recordErrors = true);
+    void _Fail(const char* what, int err);
+    void _FlushThread();
+
+    int _fd;
+    char* _base;
+    const size_t _extentSize;
+    const size_t _maxSize;
+
+    // End of the reserved, committed and mapped parts of the file.
+    std::atomic<uint64_t> _reserved;
+    std::atomic<uint64_t> _committed;
+    std::atomic<uint64_t> _mapped;
+    // Offset of the first reservation that couldn't be mapped.
+    std::atomic<uint64_t> _failedAt;
+
+    // Guards growing, the error and the members below.
+    std::mutex _mutex;
+    std::string _error;
+    std::condition_variable _wake;
+    bool _stop = false;
+    // End of the data written back by the flush thread and by Flush().
+    uint64_t _flushed;
+    uint64_t _synced;
+    std::thread _flushThread;
+};
+
+ArchAppendLog::_Impl*
+ArchAppendLog::_Impl::New(int fd, uint64_t length, size_t extentSize,
+                          size_t maxSize, std::string* error)
+{
+    char* base = static_cast<char*>(ArchReserveVirtualMemory(maxSize));
+    if (!base) {
+        *error = "unable to reserve address space: " + ArchStrerror();
+        close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<_Impl> impl(
+        new _Impl(fd, base, length, extentSize, maxSize));
+    if (!impl->_Grow(length + 1)) {
+        *error = impl->GetError();
+        return nullptr;
+    }
+    impl->_flushThread = std::thread(&_Impl::_FlushThread, impl.get());
+    return impl.release();
+}
+
+// Records the first error.  The caller must hold the mutex.
+void
+ArchAppendLog::_Impl::_Fail(const char* what, int err)
+{
+    if (_error.empty()) {
+        _error = std::string(what) + ": " + ArchStrerror(err);
+    }
+}
+
+bool
+ArchAppendLog::_Impl::_Grow(uint64_t end)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _GrowLocked(end);
+}
+
+// Maps the file up to at least \p end.  Failures are recorded as the log's
+// error only if \p recordErrors is true.
+bool
+ArchAppendLog::_Impl::_GrowLocked(uint64_t end, bool recordErrors)
+{
+    const auto fail = [this, recordErrors](const char* what, int err) {
+        if (recordErrors) {
+            _Fail(what, err);
+        }
+        return false;
+    };
+
+    uint64_t mapped = _mapped.load(std::memory_order_relaxed);
+    while (mapped < end) {
+        const uint64_t offset = mapped;
+        const size_t length = static_cast<size_t>(
+            std::min<uint64_t>(_extentSize, _maxSize - offset));
+        if (length == 0) {
+            return fail("log exceeds its maximum size", EFBIG);
+        }
+
+        // Allocate the extent so stores to the mapping can't fail with
+        // SIGBUS for lack of space.  Fall back to extending the file on
+        // file systems that can't preallocate.
+        int err = 0;
+#if defined(ARCH_OS_LINUX)
+        if (fallocate(_fd, 0, offset, length) != 0) {
+            err = errno;
+        }
+#else
+        err = EOPNOTSUPP;
+#endif
+        if (err == EOPNOTSUPP || err == ENOSYS) {
+            struct stat st;
+            err = 0;
+            if (fstat(_fd, &st) != 0) {
+                err = errno;
+            }
+            else if (static_cast<uint64_t>(st.st_size) < offset + length &&
+                     ftruncate(_fd, offset + length) != 0) {
+                err = errno;
+            }
+        }
+        if (err != 0) {
+            return fail("unable to grow log", err);
+        }
+
+        if (mmap(_base + offset, length, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_FIXED, _fd, offset) == MAP_FAILED) {
+            return fail("unable to map log", errno);
+        }
+        mapped = offset + length;
+        _mapped.store(mapped, std::memory_order_release);
+    }
+    return true;
+}
+
+char*
+ArchAppendLog::_Impl::Reserve(size_t size, uint64_t* offset)
+{
+    uint64_t start = _reserved.load(std::memory_order_relaxed);
+    do {
+        if (_failedAt.load(std::memory_order_relaxed) != UINT64_MAX ||
+            start > _maxSize || size > _maxSize - start) {
+            return nullptr;
+        }
+    } while (!_reserved.compare_exchange_weak(
+                 start, start + size, std::memory_order_relaxed));
+
+    if (start + size > _mapped.load(std::memory_order_acquire) &&
+        !_Grow(start + size)) {
+        // Stop taking reservations and commit this one anyway so later
+        // ones aren't blocked.  The file is truncated to the first failed
+        // reservation when the log is closed.
+        uint64_t failedAt = _failedAt.load(std::memory_order_relaxed);
+        while (start < failedAt && !_failedAt.compare_exchange_weak(
+                   failedAt, start, std::memory_order_release)) {
+        }
+        Commit(start, size);
+        return nullptr;
+    }
+
+    // An earlier reservation may have failed after this one was made, in
+    // which case this range would be truncated away too.
+    if (_failedAt.load(std::memory_order_acquire) <= start) {
+        Commit(start, size);
+        return nullptr;
+    }
+    *offset = start;
+    return _base + start;
+}
+
+bool
+ArchAppendLog::_Impl::Commit(uint64_t offset, size_t size)
+{
+    // Earlier reservations are normally just finishing their copies.
+    for (unsigned int spins = 0;
+         _committed.load(std::memory_order_acquire) != offset; ++spins) {
+        if (spins < 64) {
+            ARCH_SPIN_PAUSE();
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+    _committed.store(offset + size, std::memory_order_release);
+
+    // A failed reservation sets _failedAt before committing, so once the
+    // earlier ranges are committed it's known whether this one is kept.
+    return _failedAt.load(std::memory_order_acquire) > offset;
+}
+
+void
+ArchAppendLog::_Impl::_FlushThread()
+{
+    const size_t pageSize = ArchGetPageSize();
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_stop) {
+        _wake.wait_for(lock, std::chrono::milliseconds(FlushIntervalMs));
+
+        // Map the next extent once half of the current one is reserved so
+        // producers rarely have to.  This is best effort: if it fails, the
+        // producer whose reservation needs the extent retries and records
+        // the error.
+        const uint64_t mapped = _mapped.load(std::memory_order_relaxed);
+        if (mapped < _maxSize &&
+            _failedAt.load(std::memory_order_relaxed) == UINT64_MAX &&
+            _reserved.load(std::memory_order_relaxed) + _extentSize / 2 >
+                mapped) {
+            _GrowLocked(mapped + 1, /* recordErrors = */ false);
+        }
+
+        // Start writing back committed data without waiting for it.
+        const uint64_t committed = std::min(
+            _committed.load(std::memory_order_acquire),
+            _mapped.load(std::memory_order_relaxed));
+        if (committed > _flushed) {
+            const uint64_t start = _flushed / pageSize * pageSize;
+            lock.unlock();
+#if defined(ARCH_OS_LINUX)
+            sync_file_range(_fd, start, committed - start,
+                            SYNC_FILE_RANGE_WRITE);
+#else
+            msync(_base + start, committed - start, MS_ASYNC);
+#endif
+            lock.lock();
+            _flushed = std::max(_flushed, committed);
+        }
+    }
+}
+
+bool
+ArchAppendLog::_Impl::Flush()
+{
+    const size_t pageSize = ArchGetPageSize();
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint64_t committed = std::min(
+        _committed.load(std::memory_order_acquire),
+        _mapped.load(std::memory_order_relaxed));
+    if (committed > _synced) {
+        const uint64_t start = _synced / pageSize * pageSize;
+        if (msync(_base + start, committed - start, MS_SYNC) != 0) {
+            _Fail("unable to flush log", errno);
+            return false;
+        }
+        _synced = committed;
+    }
+    return true;
+}
+
+bool
+ArchAppendLog::_Impl::Close(std::string* error)
+{
+    if (_fd == -1) {
+        return true;
+    }
+
+    // Wait for outstanding reservations.  Reservations can't be made once
+    // the log is closing, so this doesn't wait on new ones.
+    const uint64_t reserved =
+        _reserved.exchange(_maxSize + 1, std::memory_order_acq_rel);
+    while (_committed.load(std::memory_order_acquire) != reserved) {
+        std::this_thread::yield();
+    }
+
+    if (_flushThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_one();
+        _flushThread.join();
+    }
+
+    bool ok = Flush();
+    ArchFreeVirtualMemory(_base, _maxSize);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    const uint64_t size = std::min(
+        reserved, _failedAt.load(std::memory_order_relaxed));
+    if (ftruncate(_fd, size) != 0) {
+        _Fail("unable to truncate log", errno);
+        ok = false;
+    }
+    if (close(_fd) != 0) {
+        _Fail("unable to close log", errno);
+        ok = false;
+    }
+    _fd = -1;
+    *error = _error;
+    return ok && _error.empty();
+}
+
+ArchAppendLog::ArchAppendLog(const std::string& path, size_t extentSize,
+                             size_t maxSize)
+{
+    const size_t pageSize = ArchGetPageSize();
+    extentSize = _RoundUp(std::max<size_t>(extentSize, 1), pageSize);
+    maxSize = _RoundUp(std::max<size_t>(maxSize, 1), pageSize);
+
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd == -1) {
+        _error = "unable to open " + path + ": " + ArchStrerror();
+        return;
+    }
+
+    // Append after any existing contents.
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        _error = "unable to stat " + path + ": " + ArchStrerror();
+        close(fd);
+        return;
+    }
+    const uint64_t length = st.st_size;
+    if (length >= maxSize) {
+        _error = path + " exceeds the maximum log size";
+        close(fd);
+        return;
+    }
+
+    _impl.reset(_Impl::New(fd, length, extentSize, maxSize, &_error));
+}
+
+#else
+
+class ArchAppendLog::_Impl {
+public:
+    char* Reserve(size_t, uint64_t*) { return nullptr; }
+    bool Commit(uint64_t, size_t) { return false; }
+    bool Flush() { return false; }
+    bool Close(std::string*) { return true; }
+    uint64_t GetCommittedSize() const { return 0; }
+    std::string GetError() { return std::string(); }
+};
+
+ArchAppendLog::ArchAppendLog(const std::string& path, size_t, size_t)
+{
+    _error = "append logs are not supported on this platform";
+}
+
+#endif
+
+ArchAppendLog::ArchAppendLog() = default;
+
+ArchAppendLog::ArchAppendLog(ArchAppendLog&&) noexcept = default;
+
+ArchAppendLog&
+ArchAppendLog::operator=(ArchAppendLog&& other) noexcept
+{
+    if (this != &other) {
+        Close();
+        _error = std::move(other._error);
+        _impl = std::move(other._impl);
+    }
+    return *this;
+}
+
+ArchAppendLog::~ArchAppendLog() = default;
+
+ArchAppendLog::operator bool() const
+{
+    return bool(_impl);
+}
+
+std::string
+ArchAppendLog::GetError() const
+{
+    return _impl ? _impl->GetError() : _error;
+}
+
+char*
+ArchAppendLog::Reserve(size_t size, uint64_t* offset)
+{
+    return _impl ? _impl->Reserve(size, offset) : nullptr;
+}
+
+bool
+ArchAppendLog::Commit(uint64_t offset, size_t size)
+{
+    return _impl && _impl->Commit(offset, size);
+}
+
+bool
+ArchAppendLog::Append(const void* data, size_t size)
+{
+    uint64_t offset;
+    char* slot = Reserve(size, &offset);
+    if (!slot) {
+        return false;
+    }
+    memcpy(slot, data, size);
+    return Commit(offset, size);
+}
+
+uint64_t
+ArchAppendLog::GetCommittedSize() const
+{
+    return _impl ? _impl->GetCommittedSize() : 0;
+}
+
+bool
+ArchAppendLog::Flush()
+{
+    return _impl && _impl->Flush();
+}
+
+bool
+ArchAppendLog::Close()
+{
+    if (!_impl) {
+        return true;
+    }
+    const bool ok = _impl->Close(&_error);
+    _impl.reset();
+    return ok;
+}
+
+}  // namespace pxr
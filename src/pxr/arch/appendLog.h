@@ -0,0 +1,131 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#ifndef PXR_ARCH_APPEND_LOG_H
+#define PXR_ARCH_APPEND_LOG_H
+
+/// \file arch/appendLog.h
+/// Memory-mapped append-only log files.
+
+#include "./api.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pxr {
+
+/// \class ArchAppendLog
+///
+/// Appends records to a file through a shared memory mapping, so that
+/// writing a record is a copy into memory rather than a system call.
+///
+/// The log reserves \c maxSize bytes of address space when it's opened and
+/// maps the file into it in extents of \c extentSize bytes, allocating each
+/// extent on disk before mapping it.  Records therefore never need to be
+/// split at extent boundaries.  A background thread maps the next extent
+/// before it's needed and starts writing committed data back to the file
+/// every FlushIntervalMs milliseconds.
+///
+/// Any number of threads may append concurrently.  Each reserves a range
+/// with Reserve(), fills it in and hands it back with Commit():
+/// \code
+///  uint64_t offset;
+///  if (char* slot = log.Reserve(sizeof(Event), &offset)) {
+///      memcpy(slot, &event, sizeof(Event));
+///      log.Commit(offset, sizeof(Event));
+///  }
+/// \endcode
+/// Ranges are committed in the order they were reserved, so the committed
+/// part of the log is always a complete prefix.  Commit() waits until every
+/// earlier reservation has been committed, which means every successful
+/// reservation must be committed, and promptly.
+///
+/// If the file can't be grown, the log stops taking reservations and is
+/// truncated before the failed one when it's closed.  Reservations made
+/// after it are discarded as well, and Commit() reports it.
+///
+/// Writing to an existing file appends to its contents.  When the log is
+/// closed the file is truncated to the committed size.
+///
+/// This is not implemented on Windows, where opening a log always fails.
+///
+class ArchAppendLog {
+public:
+    /// Default size of each extent the file grows by.
+    static constexpr size_t DefaultExtentSize = size_t(64) << 20;
+
+    /// Default limit on the size of the file.
+    static constexpr size_t DefaultMaxSize = size_t(64) << 30;
+
+    /// Interval between background write backs of committed data.
+    static constexpr unsigned int FlushIntervalMs = 100;
+
+    /// Create a closed log.
+    ARCH_API ArchAppendLog();
+
+    /// Open the log file at \p path, creating it if necessary.  The file
+    /// grows in extents of \p extentSize bytes and can't exceed \p maxSize
+    /// bytes.  Both are rounded up to a multiple of the page size.
+    ARCH_API explicit ArchAppendLog(const std::string& path,
+                                    size_t extentSize = DefaultExtentSize,
+                                    size_t maxSize = DefaultMaxSize);
+
+    ARCH_API ArchAppendLog(ArchAppendLog&&) noexcept;
+
+    /// Closes this log and takes over \p other.
+    ARCH_API ArchAppendLog& operator=(ArchAppendLog&&) noexcept;
+
+    /// Destructor.  Closes the log.
+    ARCH_API ~ArchAppendLog();
+
+    /// Returns \c true if the log is open.
+    ARCH_API explicit operator bool() const;
+
+    /// Returns the reason the log could not be opened or the first error
+    /// encountered while writing it, or the empty string if there was none.
+    ARCH_API std::string GetError() const;
+
+    /// Reserves \p size bytes at the end of the log and returns a pointer to
+    /// them, storing their offset in the file in \p offset.  Returns
+    /// \c nullptr if the log isn't open, the log would exceed its maximum
+    /// size, or the file could not be grown.
+    ARCH_API char* Reserve(size_t size, uint64_t* offset);
+
+    /// Commits the \p size bytes at \p offset returned by Reserve(), waiting
+    /// for earlier reservations to be committed first.  Returns \c false if
+    /// the range will be discarded because an earlier reservation failed.
+    ARCH_API bool Commit(uint64_t offset, size_t size);
+
+    /// Appends the \p size bytes at \p data to the log.  Returns \c false if
+    /// they couldn't be reserved or will be discarded.
+    ARCH_API bool Append(const void* data, size_t size);
+
+    /// Returns the number of bytes committed to the log, including any
+    /// contents the file had when it was opened.
+    ARCH_API uint64_t GetCommittedSize() const;
+
+    /// Writes committed data to disk, waiting for it to complete.  Returns
+    /// \c false in case of an error.
+    ARCH_API bool Flush();
+
+    /// Waits for outstanding reservations to be committed, writes committed
+    /// data to disk, truncates the file to the committed size and closes it.
+    /// Returns \c false in case of an error.  Returns \c true if the log
+    /// wasn't open.
+    ARCH_API bool Close();
+
+private:
+    class _Impl;
+    std::string _error;
+    std::unique_ptr<_Impl> _impl;
+};
+
+}  // namespace pxr
+
+#endif // PXR_ARCH_APPEND_LOG_H
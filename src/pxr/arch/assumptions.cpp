@@ -12,6 +12,7 @@
 #include "./export.h"
 #include "./math.h"
 
+#include <atomic>
 #include <cstdio>
 #include <cstdint>
 #include <cstring>
@@ -151,4 +152,18 @@ Arch_ValidateAssumptions()
     }    
 }
 
+// Validates assumptions the first time it's called.  Arch_InitConfig() only
+// calls Arch_ValidateAssumptions() directly if ARCH_EAGER_INIT is set, so
+// this is called when other process configuration is lazily initialized to
+// ensure the validation gets performed at some point.
+ARCH_HIDDEN
+void
+Arch_ValidateAssumptionsOnce()
+{
+    static std::atomic<bool> validated(false);
+    if (!validated.exchange(true)) {
+        Arch_ValidateAssumptions();
+    }
+}
+
 }  // namespace pxr
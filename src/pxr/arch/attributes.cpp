@@ -193,7 +193,8 @@ AddImage(const struct mach_header* mh, intptr_t slide)
     for (size_t i = 0, n = entries.size(); i != n; ++i) {
         if (entries[i].function &&
             entries[i].version == static_cast<unsigned>(PXR_VERSION)) {
-            entries[i].function();
+            Arch_RunInitializer(entries[i].function, nullptr,
+                                entries[i].priority, false);
         }
     }
 }
@@ -209,7 +210,8 @@ RemoveImage(const struct mach_header* mh, intptr_t slide)
     for (size_t i = entries.size(); i-- != 0; ) {
         if (entries[i].function &&
             entries[i].version == static_cast<unsigned>(PXR_VERSION)) {
-            entries[i].function();
+            Arch_RunInitializer(entries[i].function, nullptr,
+                                entries[i].priority, true);
         }
     }
 }
@@ -354,7 +356,8 @@ RunConstructors(HMODULE hModule)
         for (size_t i = 0, n = entries.size(); i != n; ++i) {
             if (entries[i].function &&
                 entries[i].version == static_cast<unsigned>(PXR_VERSION)) {
-                entries[i].function();
+                Arch_RunInitializer(entries[i].function, nullptr,
+                                    entries[i].priority, false);
             }
         }
     }
@@ -374,7 +377,8 @@ RunDestructors(HMODULE hModule)
         for (size_t i = entries.size(); i-- != 0; ) {
             if (entries[i].function &&
                 entries[i].version == static_cast<unsigned>(PXR_VERSION)) {
-                entries[i].function();
+                Arch_RunInitializer(entries[i].function, nullptr,
+                                    entries[i].priority, true);
             }
         }
     }
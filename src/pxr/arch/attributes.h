@@ -14,6 +14,7 @@
 /// This file allows you to define architecture-specific or compiler-specific
 /// options to be used outside lib/arch.
 
+#include "./api.h"
 #include "./export.h"
 
 namespace pxr {
@@ -211,6 +212,14 @@ StaticInit Arch_PerLibInit<StaticInit>::init;
 #define _ARCH_ENSURE_PER_LIB_INIT(T, prefix) \
     static pxr::Arch_PerLibInit<T> _ARCH_CAT(prefix, __COUNTER__)
 
+/// \private
+/// Run the ARCH_CONSTRUCTOR or ARCH_DESTRUCTOR function \p function, timing
+/// it when initializer profiling is enabled.  \p name may be null, in which
+/// case it's looked up from the function's address if needed.
+ARCH_API
+void Arch_RunInitializer(void (*function)(), const char* name,
+                         int priority, bool isDestructor);
+
 #if defined(doxygen)
 
 // The macros are already defined above in doxygen.
@@ -249,14 +258,28 @@ struct Arch_ConstructorEntry {
 
 #elif defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
 
-// The used attribute is required to prevent these apparently unused functions
-// from being removed by the linker.
-#   define ARCH_CONSTRUCTOR(_name, _priority, ...) \
-        __attribute__((used, section(".pxrctor"), constructor((_priority) + 100))) \
-        static void _name(__VA_ARGS__)
-#   define ARCH_DESTRUCTOR(_name, _priority, ...) \
-        __attribute__((used, section(".pxrdtor"), destructor((_priority) + 100))) \
-        static void _name(__VA_ARGS__)
+// The loader calls a trampoline that runs the function by way of
+// Arch_RunInitializer() so it can be profiled.  The used attribute is
+// required to prevent these apparently unused functions from being removed
+// by the linker.
+#   define ARCH_CONSTRUCTOR(_name, _priority, ...)                                  \
+    static void _name(__VA_ARGS__);                                                 \
+    __attribute__((used, section(".pxrctor"), constructor((_priority) + 100)))      \
+    static void _ARCH_CAT_NOEXPAND(arch_ctor_, _name)()                             \
+    {                                                                               \
+        pxr::Arch_RunInitializer(                                                   \
+            reinterpret_cast<void (*)()>(&_name), #_name, _priority, false);        \
+    }                                                                               \
+    static void _name(__VA_ARGS__)
+#   define ARCH_DESTRUCTOR(_name, _priority, ...)                                   \
+    static void _name(__VA_ARGS__);                                                 \
+    __attribute__((used, section(".pxrdtor"), destructor((_priority) + 100)))       \
+    static void _ARCH_CAT_NOEXPAND(arch_dtor_, _name)()                             \
+    {                                                                               \
+        pxr::Arch_RunInitializer(                                                   \
+            reinterpret_cast<void (*)()>(&_name), #_name, _priority, true);         \
+    }                                                                               \
+    static void _name(__VA_ARGS__)
 
 #elif defined(ARCH_OS_WINDOWS)
     
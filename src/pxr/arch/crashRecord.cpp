@@ -0,0 +1,564 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include "./crashRecord.h"
+#include "./demangle.h"
+#include "./vsnprintf.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+namespace pxr {
+
+namespace {
+
+// ELF machine numbers of the platforms whose registers we can name.
+constexpr uint32_t _elfMachineX86_64 = 62;
+constexpr uint32_t _elfMachineAArch64 = 183;
+
+// Little cursor over the bytes of a crash record or an ELF file.  Reads
+// past the end fail rather than crash.
+class _Reader {
+public:
+    _Reader(const char* data, size_t size) : _data(data), _size(size) {}
+
+    size_t Remaining() const { return _size - _offset; }
+
+    template <class T>
+    bool Read(T* value)
+    {
+        if (Remaining() < sizeof(T)) {
+            return false;
+        }
+        memcpy(value, _data + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return true;
+    }
+
+    bool ReadBytes(size_t size, std::string* value)
+    {
+        if (Remaining() < size) {
+            return false;
+        }
+        value->assign(_data + _offset, size);
+        _offset += size;
+        return true;
+    }
+
+private:
+    const char* _data;
+    size_t _size;
+    size_t _offset = 0;
+};
+
+bool
+_ReadFile(const std::string& path, std::string* contents)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    contents->assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+std::string
+_ToHex(const std::string& bytes)
+{
+    static const char digit[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes) {
+        result += digit[c >> 4];
+        result += digit[c & 0xf];
+    }
+    return result;
+}
+
+std::string
+_GetBaseName(const std::string& path)
+{
+    const std::string::size_type slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool
+_ReadKeyValue(_Reader& reader,
+              std::vector<std::pair<std::string, std::string>>* entries)
+{
+    uint32_t keySize, valueSize;
+    std::string key, value;
+    if (!reader.Read(&keySize) || !reader.Read(&valueSize) ||
+        !reader.ReadBytes(keySize, &key) ||
+        !reader.ReadBytes(valueSize, &value)) {
+        return false;
+    }
+    entries->emplace_back(std::move(key), std::move(value));
+    return true;
+}
+
+bool
+_ReadSection(uint32_t type, _Reader& reader, ArchCrashRecord* record)
+{
+    switch (type) {
+    case ArchCrashRecordSectionReason:
+        return reader.ReadBytes(reader.Remaining(), &record->reason);
+
+    case ArchCrashRecordSectionThread: {
+        ArchCrashRecord::Thread thread;
+        uint32_t numRegisters, numFrames, padding;
+        if (!reader.Read(&thread.tid) || !reader.Read(&thread.flags) ||
+            !reader.Read(&numRegisters) || !reader.Read(&numFrames) ||
+            !reader.Read(&padding) ||
+            reader.Remaining() !=
+                (size_t(numRegisters) + numFrames) * sizeof(uint64_t)) {
+            return false;
+        }
+        thread.registers.resize(numRegisters);
+        for (uint64_t& value : thread.registers) {
+            reader.Read(&value);
+        }
+        thread.frames.resize(numFrames);
+        for (uint64_t& value : thread.frames) {
+            reader.Read(&value);
+        }
+        record->threads.push_back(std::move(thread));
+        return true;
+    }
+
+    case ArchCrashRecordSectionModule: {
+        ArchCrashRecord::Module module;
+        uint32_t buildIdSize, pathSize;
+        std::string buildId;
+        if (!reader.Read(&module.loadBias) || !reader.Read(&module.start) ||
+            !reader.Read(&module.end) || !reader.Read(&buildIdSize) ||
+            !reader.Read(&pathSize) ||
+            !reader.ReadBytes(buildIdSize, &buildId) ||
+            !reader.ReadBytes(pathSize, &module.path)) {
+            return false;
+        }
+        module.buildId = _ToHex(buildId);
+        record->modules.push_back(std::move(module));
+        return true;
+    }
+
+    case ArchCrashRecordSectionProgramInfo:
+        return _ReadKeyValue(reader, &record->programInfo);
+
+    case ArchCrashRecordSectionExtraLogInfo:
+        return _ReadKeyValue(reader, &record->extraLogInfo);
+
+    default:
+        // Unknown section, skip it.
+        return true;
+    }
+}
+
+// ELF64 structures, declared here so symbolization does not depend on the
+// system headers of the machine it runs on.
+struct _Elf64Header {
+    unsigned char ident[16];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct _Elf64SectionHeader {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t addralign;
+    uint64_t entsize;
+};
+
+struct _Elf64Symbol {
+    uint32_t name;
+    unsigned char info;
+    unsigned char other;
+    uint16_t shndx;
+    uint64_t value;
+    uint64_t size;
+};
+
+constexpr uint32_t _elfSectionSymtab = 2;
+constexpr uint32_t _elfSectionNote = 7;
+constexpr uint32_t _elfSectionDynsym = 11;
+constexpr unsigned char _elfSymbolFunc = 2;
+constexpr unsigned char _elfSymbolIFunc = 10;
+constexpr uint32_t _elfNoteGnuBuildId = 3;
+
+// Function symbols of an ELF file, sorted by address.
+struct _ElfSymbols {
+    struct Symbol {
+        uint64_t address;
+        uint64_t size;
+        std::string name;
+
+        bool operator<(const Symbol& other) const {
+            return address < other.address;
+        }
+    };
+
+    std::string path;
+    std::string buildId;
+    std::vector<Symbol> symbols;
+
+    const Symbol* Find(uint64_t address) const
+    {
+        auto it = std::upper_bound(
+            symbols.begin(), symbols.end(), Symbol{ address, 0, {} });
+        if (it == symbols.begin()) {
+            return nullptr;
+        }
+        --it;
+        if (it->size && address >= it->address + it->size) {
+            return nullptr;
+        }
+        return &*it;
+    }
+};
+
+bool
+_LoadElfSymbols(const std::string& path, _ElfSymbols* result)
+{
+    std::string contents;
+    if (!_ReadFile(path, &contents)) {
+        return false;
+    }
+
+    _Elf64Header header;
+    _Reader reader(contents.data(), contents.size());
+    if (!reader.Read(&header) ||
+        memcmp(header.ident, "\x7f" "ELF", 4) != 0 ||
+        header.ident[4] != 2 /* ELFCLASS64 */ ||
+        header.shentsize != sizeof(_Elf64SectionHeader) ||
+        header.shoff > contents.size() ||
+        (contents.size() - header.shoff) / sizeof(_Elf64SectionHeader) <
+            header.shnum) {
+        return false;
+    }
+
+    std::vector<_Elf64SectionHeader> sections(header.shnum);
+    memcpy(sections.data(), contents.data() + header.shoff,
+           sections.size() * sizeof(_Elf64SectionHeader));
+
+    auto inFile = [&contents](uint64_t offset, uint64_t size) {
+        return offset <= contents.size() && size <= contents.size() - offset;
+    };
+
+    result->path = path;
+    for (const _Elf64SectionHeader& section : sections) {
+        if (!inFile(section.offset, section.size)) {
+            continue;
+        }
+
+        if (section.type == _elfSectionNote && result->buildId.empty()) {
+            _Reader notes(contents.data() + section.offset, section.size);
+            uint32_t nameSize, descSize, type;
+            while (notes.Read(&nameSize) && notes.Read(&descSize) &&
+                   notes.Read(&type)) {
+                std::string name, desc;
+                if (!notes.ReadBytes((nameSize + 3) & ~3u, &name) ||
+                    !notes.ReadBytes((descSize + 3) & ~3u, &desc)) {
+                    break;
+                }
+                if (type == _elfNoteGnuBuildId && nameSize == 4 &&
+                    name.compare(0, 4, std::string("GNU\0", 4)) == 0) {
+                    result->buildId = _ToHex(desc.substr(0, descSize));
+                    break;
+                }
+            }
+        }
+
+        if ((section.type != _elfSectionSymtab &&
+             section.type != _elfSectionDynsym) ||
+            section.link >= sections.size()) {
+            continue;
+        }
+        const _Elf64SectionHeader& strings = sections[section.link];
+        if (!inFile(strings.offset, strings.size)) {
+            continue;
+        }
+
+        _Reader symbols(contents.data() + section.offset, section.size);
+        _Elf64Symbol symbol;
+        while (symbols.Read(&symbol)) {
+            const unsigned char type = symbol.info & 0xf;
+            if ((type != _elfSymbolFunc && type != _elfSymbolIFunc) ||
+                !symbol.value || symbol.name >= strings.size) {
+                continue;
+            }
+            const char* name = contents.data() + strings.offset + symbol.name;
+            result->symbols.push_back({
+                symbol.value, symbol.size,
+                std::string(name, strnlen(name, strings.size - symbol.name))
+            });
+        }
+    }
+
+    // Both symbol tables usually hold the exported functions, keep one.
+    std::sort(result->symbols.begin(), result->symbols.end());
+    result->symbols.erase(
+        std::unique(result->symbols.begin(), result->symbols.end(),
+                    [](const _ElfSymbols::Symbol& a,
+                       const _ElfSymbols::Symbol& b) {
+                        return a.address == b.address;
+                    }),
+        result->symbols.end());
+    return true;
+}
+
+const char* const*
+_GetRegisterNames(uint32_t machine, size_t* count)
+{
+    static const char* const x86_64[] = {
+        "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15",
+        "rdi", "rsi", "rbp", "rbx", "rdx", "rax", "rcx", "rsp",
+        "rip", "eflags", "csgsfs", "err", "trapno", "oldmask", "cr2"
+    };
+    static const char* const aarch64[] = {
+        "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7",
+        "x8", "x9", "x10", "x11", "x12", "x13", "x14", "x15",
+        "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
+        "x24", "x25", "x26", "x27", "x28", "x29", "x30",
+        "sp", "pc", "pstate"
+    };
+    switch (machine) {
+    case _elfMachineX86_64:
+        *count = std::size(x86_64);
+        return x86_64;
+    case _elfMachineAArch64:
+        *count = std::size(aarch64);
+        return aarch64;
+    default:
+        *count = 0;
+        return nullptr;
+    }
+}
+
+} // anonymous namespace
+
+bool
+ArchReadCrashRecord(const std::string& path, ArchCrashRecord* record,
+                    std::string* error)
+{
+    auto fail = [error](const std::string& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    std::string contents;
+    if (!_ReadFile(path, &contents)) {
+        return fail("Cannot read " + path);
+    }
+
+    ArchCrashRecordHeader header;
+    _Reader reader(contents.data(), contents.size());
+    if (!reader.Read(&header) ||
+        memcmp(header.magic, ARCH_CRASH_RECORD_MAGIC,
+               sizeof(header.magic)) != 0) {
+        return fail(path + " is not a crash record");
+    }
+    if (header.version > ARCH_CRASH_RECORD_VERSION) {
+        return fail(ArchStringPrintf(
+            "%s has unsupported version %u", path.c_str(), header.version));
+    }
+
+    *record = ArchCrashRecord();
+    record->version = header.version;
+    record->machine = header.machine;
+    record->pid = header.pid;
+    record->time = header.time;
+
+    ArchCrashRecordSectionHeader section;
+    while (reader.Read(&section)) {
+        std::string payload;
+        if (!reader.ReadBytes(section.size, &payload)) {
+            return fail(path + " is truncated");
+        }
+        _Reader sectionReader(payload.data(), payload.size());
+        if (!_ReadSection(section.type, sectionReader, record)) {
+            return fail(ArchStringPrintf(
+                "%s has a malformed section of type %u",
+                path.c_str(), section.type));
+        }
+    }
+    if (reader.Remaining()) {
+        return fail(path + " is truncated");
+    }
+    return true;
+}
+
+void
+ArchSymbolizeCrashRecord(const ArchCrashRecord& record, std::ostream& out,
+                         const std::vector<std::string>& searchPaths)
+{
+    // Load the symbols of each module, looking for a copy with the
+    // recorded build ID first.
+    std::vector<_ElfSymbols> symbols(record.modules.size());
+    for (size_t i = 0; i != record.modules.size(); ++i) {
+        const ArchCrashRecord::Module& module = record.modules[i];
+        std::vector<std::string> candidates;
+        if (!module.path.empty()) {
+            candidates.push_back(module.path);
+            for (const std::string& dir : searchPaths) {
+                candidates.push_back(dir + "/" + _GetBaseName(module.path));
+            }
+        }
+        for (const std::string& candidate : candidates) {
+            _ElfSymbols loaded;
+            if (_LoadElfSymbols(candidate, &loaded)) {
+                const bool matches = loaded.buildId == module.buildId;
+                if (symbols[i].path.empty() || matches) {
+                    symbols[i] = std::move(loaded);
+                }
+                if (matches) {
+                    break;
+                }
+            }
+        }
+    }
+
+    auto findModule = [&record](uint64_t address) -> int {
+        for (size_t i = 0; i != record.modules.size(); ++i) {
+            const ArchCrashRecord::Module& module = record.modules[i];
+            if (address >= module.start && address < module.end) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    };
+
+    const time_t time = static_cast<time_t>(record.time);
+    char timeBuffer[64] = "";
+    if (const struct tm* local = localtime(&time)) {
+        strftime(timeBuffer, sizeof(timeBuffer), "%Y-%m-%d %H:%M:%S", local);
+    }
+    out << "Crash record of process " << record.pid << " written "
+        << timeBuffer << '\n';
+    if (!record.reason.empty()) {
+        out << "Reason: " << record.reason << '\n';
+    }
+
+    if (!record.programInfo.empty()) {
+        out << "\nProgram info:\n";
+        for (const auto& entry : record.programInfo) {
+            out << "  " << entry.first << ": " << entry.second << '\n';
+        }
+    }
+
+    size_t numRegisterNames;
+    const char* const* registerNames =
+        _GetRegisterNames(record.machine, &numRegisterNames);
+
+    for (const ArchCrashRecord::Thread& thread : record.threads) {
+        out << "\nThread " << thread.tid;
+        if (thread.flags & ArchCrashRecordThreadReporting) {
+            out << " (reporting)";
+        }
+        out << ":\n";
+        if (thread.flags & ArchCrashRecordThreadNoResponse) {
+            out << "<no response>\n";
+            continue;
+        }
+
+        for (size_t i = 0; i != thread.frames.size(); ++i) {
+            const uint64_t frame = thread.frames[i];
+            ArchFormatBuffer line;
+            line.Append(" #").AppendUnsigned(i, -3)
+                .Append(" 0x").AppendHex(frame, 16);
+
+            const int index = findModule(frame);
+            if (index < 0) {
+                out << line.GetData() << '\n';
+                continue;
+            }
+            const ArchCrashRecord::Module& module = record.modules[index];
+            const uint64_t offset = frame - module.loadBias;
+
+            // Every frame but the innermost holds a return address, which
+            // may belong to the next function if the call was the last
+            // instruction of the caller.
+            const _ElfSymbols::Symbol* symbol =
+                symbols[index].Find(i == 0 ? offset : offset - 1);
+            if (symbol) {
+                std::string name = symbol->name;
+                Arch_DemangleFunctionName(&name);
+                line.Append(" in ").Append(name)
+                    .Append("+0x").AppendHex(offset - symbol->address);
+            }
+            line.Append(" (").Append(_GetBaseName(module.path))
+                .Append("+0x").AppendHex(offset).Append(")\n");
+            out << line.GetData();
+        }
+
+        for (size_t i = 0; i != thread.registers.size(); ++i) {
+            if (i % 4 == 0) {
+                out << (i == 0 ? "Registers:\n" : "\n");
+            }
+            const std::string name = i < numRegisterNames ?
+                registerNames[i] : "r" + std::to_string(i);
+            ArchFormatBuffer line;
+            line.AppendPrintf("  %7s", name.c_str())
+                .Append(" 0x").AppendHex(thread.registers[i], 16);
+            out << line.GetData();
+        }
+        if (!thread.registers.empty()) {
+            out << '\n';
+        }
+    }
+
+    out << "\nModules:\n";
+    for (size_t i = 0; i != record.modules.size(); ++i) {
+        const ArchCrashRecord::Module& module = record.modules[i];
+        ArchFormatBuffer line;
+        line.Append("  0x").AppendHex(module.start, 16)
+            .Append("-0x").AppendHex(module.end, 16).Append(' ');
+        out << line.GetData() << module.path;
+        if (!module.buildId.empty()) {
+            out << " [" << module.buildId << "]";
+        }
+        if (symbols[i].path.empty()) {
+            out << " (not found)";
+        }
+        else if (symbols[i].buildId != module.buildId) {
+            out << " (build ID mismatch: " << symbols[i].path << ")";
+        }
+        out << '\n';
+    }
+
+    for (const auto& entry : record.extraLogInfo) {
+        out << '\n' << entry.first << ":\n" << entry.second;
+        if (!entry.second.empty() && entry.second.back() != '\n') {
+            out << '\n';
+        }
+    }
+}
+
+}  // namespace pxr
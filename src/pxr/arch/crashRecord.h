@@ -0,0 +1,158 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#ifndef PXR_ARCH_CRASH_RECORD_H
+#define PXR_ARCH_CRASH_RECORD_H
+
+/// \file arch/crashRecord.h
+/// Compact binary crash records and their offline symbolization.
+///
+/// A crash record starts with an \c ArchCrashRecordHeader and is followed by
+/// a sequence of sections.  Each section starts with an
+/// \c ArchCrashRecordSectionHeader giving its type and the size of its
+/// payload, so readers can skip sections they do not know about.  All
+/// integers are stored in the byte order of the machine that wrote the
+/// record.  The payload of each section type is:
+///
+/// \li \c ArchCrashRecordSectionReason: the reason text.
+/// \li \c ArchCrashRecordSectionThread: uint64 thread id, uint32 flags,
+///     uint32 register count, uint32 frame count, uint32 padding, followed
+///     by the registers and the frame addresses as uint64 values.
+/// \li \c ArchCrashRecordSectionModule: uint64 load bias, uint64 start and
+///     uint64 end of the executable code, uint32 build ID size, uint32 path
+///     size, followed by the build ID bytes and the path.
+/// \li \c ArchCrashRecordSectionProgramInfo and
+///     \c ArchCrashRecordSectionExtraLogInfo: uint32 key size, uint32 value
+///     size, followed by the key and the value.
+///
+/// Registers are stored in the order of the machine context of the platform
+/// identified by the ELF machine number in the header, that is the order of
+/// \c gregs on x86-64 and \c regs, \c sp, \c pc and \c pstate on AArch64.
+
+#include "./api.h"
+#include "./defines.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pxr {
+
+/// Magic bytes at the start of every crash record.
+#define ARCH_CRASH_RECORD_MAGIC "ARCHCRSH"
+
+/// Version of the crash record format written by this library.
+#define ARCH_CRASH_RECORD_VERSION 1
+
+/// Header at the start of a crash record.
+struct ArchCrashRecordHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t machine;
+    uint64_t pid;
+    int64_t time;
+};
+
+/// Header at the start of each section of a crash record.
+struct ArchCrashRecordSectionHeader {
+    uint32_t type;
+    uint32_t size;
+};
+
+/// Types of the sections of a crash record.
+enum ArchCrashRecordSectionType : uint32_t {
+    ArchCrashRecordSectionReason = 1,
+    ArchCrashRecordSectionThread = 2,
+    ArchCrashRecordSectionModule = 3,
+    ArchCrashRecordSectionProgramInfo = 4,
+    ArchCrashRecordSectionExtraLogInfo = 5,
+};
+
+/// Flags of a thread section of a crash record.
+enum ArchCrashRecordThreadFlags : uint32_t {
+    /// The thread that wrote the record.
+    ArchCrashRecordThreadReporting = 1,
+    /// The thread did not unwind its stack in time.
+    ArchCrashRecordThreadNoResponse = 2,
+};
+
+/// Contents of a crash record, as read by \c ArchReadCrashRecord().
+struct ArchCrashRecord {
+    struct Thread {
+        uint64_t tid = 0;
+        uint32_t flags = 0;
+        std::vector<uint64_t> registers;
+        std::vector<uint64_t> frames;
+    };
+
+    struct Module {
+        uint64_t loadBias = 0;
+        uint64_t start = 0;
+        uint64_t end = 0;
+        std::string buildId;
+        std::string path;
+    };
+
+    uint32_t version = 0;
+    uint32_t machine = 0;
+    uint64_t pid = 0;
+    int64_t time = 0;
+    std::string reason;
+    std::vector<Thread> threads;
+    std::vector<Module> modules;
+    std::vector<std::pair<std::string, std::string>> programInfo;
+    std::vector<std::pair<std::string, std::string>> extraLogInfo;
+};
+
+/// Writes a crash record for the current process to \p fd.
+///
+/// The stacks and registers of all threads are captured as described in
+/// \c ArchSetInProcessCrashReporting(), which must have been enabled.  The
+/// module list is the one captured by the last call enabling it.  The
+/// values set with \c ArchSetProgramInfoForErrors() and
+/// \c ArchSetExtraLogInfoForErrors() are included.
+///
+/// If this is called from a signal handler, the machine context it received
+/// may be passed as \p context to record the registers at the point of the
+/// signal for the calling thread.
+///
+/// This function is async-safe.  It returns \c false if the in-process crash
+/// reporter is not enabled or not supported, if another report is still
+/// being written after a bounded wait, or if writing failed.
+ARCH_API
+bool ArchWriteCrashRecord(int fd, const char* reason,
+                          const void* context = nullptr);
+
+/// Reads the crash record at \p path into \p record.
+///
+/// Returns \c false and sets \p error if the file cannot be read or is not
+/// a valid crash record.  Sections of unknown types are skipped.
+ARCH_API
+bool ArchReadCrashRecord(const std::string& path, ArchCrashRecord* record,
+                         std::string* error = nullptr);
+
+/// Writes a human-readable report of \p record to \p out, with every frame
+/// symbolized from the symbol tables of the recorded modules.
+///
+/// Modules are looked up at their recorded path first and then by file name
+/// in each directory of \p searchPaths, which allows symbolizing a record
+/// on another machine or with unstripped copies of the binaries.  A warning
+/// is written next to modules whose build ID does not match the recorded
+/// one.  Frames that cannot be symbolized are written as the module name
+/// and offset.
+///
+/// Symbolization is only supported for ELF binaries.
+ARCH_API
+void ArchSymbolizeCrashRecord(const ArchCrashRecord& record, std::ostream& out,
+                              const std::vector<std::string>& searchPaths =
+                                  std::vector<std::string>());
+
+}  // namespace pxr
+
+#endif // PXR_ARCH_CRASH_RECORD_H
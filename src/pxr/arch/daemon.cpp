@@ -19,9 +19,184 @@
 #include <sys/stat.h>
 #include <sys/resource.h>
 #endif
+#if defined(ARCH_OS_LINUX)
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#endif
 
 namespace pxr {
 
+#if defined(ARCH_OS_LINUX) || defined(ARCH_OS_DARWIN)
+
+namespace {
+
+// The most exceptions the fast paths handle.  They need the exceptions
+// sorted and we can't use the heap because we might get called from
+// precarious situations, e.g. signal handlers.  Callers with more
+// exceptions than this get the slow path.
+constexpr int _maxSortedExcept = 64;
+
+// Copies the valid descriptors in exceptFds to sorted, sorted and without
+// duplicates, and returns how many there are or -1 if there are too many.
+int
+_SortExceptions(int nExcept, const int* exceptFds, int* sorted)
+{
+    int n = 0;
+    for (int i = 0; i < nExcept; ++i) {
+        const int fd = exceptFds[i];
+        if (fd < 0) {
+            continue;
+        }
+
+        // Insertion sort.
+        int j = n;
+        while (j > 0 && sorted[j - 1] > fd) {
+            --j;
+        }
+        if (j > 0 && sorted[j - 1] == fd) {
+            continue;
+        }
+        if (n == _maxSortedExcept) {
+            return -1;
+        }
+        for (int k = n; k > j; --k) {
+            sorted[k] = sorted[k - 1];
+        }
+        sorted[j] = fd;
+        ++n;
+    }
+    return n;
+}
+
+bool
+_IsException(int fd, int nExcept, const int* sorted)
+{
+    for (int i = 0; i < nExcept && sorted[i] <= fd; ++i) {
+        if (sorted[i] == fd) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Closes fd, retrying if interrupted.  Records any error other than EBADF
+// in retStatus and retErrno.
+void
+_Close(int fd, int* retStatus, int* retErrno)
+{
+    int status;
+    do {
+        // Close the file, repeat if interrupted.
+        //
+        errno = 0;
+        status = close(fd);
+    } while (status != 0 && errno == EINTR);
+
+    if (status != 0 &&
+        errno  != EBADF)
+    {
+        // We got some real error.  Remember it but keep going.
+        //
+        *retStatus = status;
+        *retErrno  = errno;
+    }
+}
+
+#if defined(ARCH_OS_LINUX)
+
+// Closes all descriptors but the sorted exceptions with close_range(2),
+// one call per gap between exceptions.  Returns false if close_range() is
+// not available, in which case the caller should fall back to another
+// method.
+bool
+_CloseAllWithCloseRange(int nExcept, const int* sorted)
+{
+#if defined(SYS_close_range)
+    unsigned int first = 0;
+    for (int i = 0; i < nExcept; ++i) {
+        const unsigned int fd = static_cast<unsigned int>(sorted[i]);
+        if (first < fd && syscall(SYS_close_range, first, fd - 1, 0) != 0) {
+            return false;
+        }
+        first = fd + 1;
+    }
+    return syscall(SYS_close_range, first, ~0U, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+// The layout of a record returned by getdents64(2), which glibc doesn't
+// declare.
+struct _LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Closes all descriptors listed in /proc/self/fd but the sorted
+// exceptions.  This uses getdents64(2) directly because opendir()
+// allocates.  Returns false if the directory can't be read, in which case
+// the caller should fall back to another method.
+bool
+_CloseAllWithProcFd(int nExcept, const int* sorted,
+                    int* retStatus, int* retErrno)
+{
+    const int dirFd = open("/proc/self/fd", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd == -1) {
+        return false;
+    }
+
+    alignas(_LinuxDirent64) char buffer[4096];
+    bool ok = true;
+    for (;;) {
+        const long n = syscall(SYS_getdents64, dirFd, buffer, sizeof(buffer));
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        for (long offset = 0; offset < n; ) {
+            const _LinuxDirent64* entry =
+                reinterpret_cast<const _LinuxDirent64*>(buffer + offset);
+            offset += entry->d_reclen;
+
+            // Parse the name, skipping "." and "..".
+            int fd = 0;
+            const char* c = entry->d_name;
+            if (*c < '0' || *c > '9') {
+                continue;
+            }
+            for (; *c >= '0' && *c <= '9'; ++c) {
+                fd = fd * 10 + (*c - '0');
+            }
+            if (fd != dirFd && !_IsException(fd, nExcept, sorted)) {
+                _Close(fd, retStatus, retErrno);
+            }
+        }
+    }
+
+    int status;
+    do {
+        status = close(dirFd);
+    } while (status != 0 && errno == EINTR);
+    return ok;
+}
+
+#endif
+
+}
+
+#endif
+
 // Fork the current process and close all undesired file descriptors.
 //
 int
@@ -29,13 +204,33 @@ ArchCloseAllFiles(int nExcept, const int* exceptFds)
 {
 #if defined(ARCH_OS_LINUX) || defined(ARCH_OS_DARWIN)
 
-    int status, retStatus, retErrno;
     int i, j, maxfd, maxExcept = -1;
+    int retStatus = 0, retErrno = 0;
     struct rlimit limits;
 
+#if defined(ARCH_OS_LINUX)
+    // Closing each possible descriptor is very slow with a high limit on
+    // open files so prefer to close them in ranges or to only close the
+    // open ones.
+    int sorted[_maxSortedExcept];
+    const int nSorted = _SortExceptions(nExcept, exceptFds, sorted);
+    if (nSorted != -1) {
+        if (_CloseAllWithCloseRange(nSorted, sorted)) {
+            errno = 0;
+            return 0;
+        }
+        if (_CloseAllWithProcFd(nSorted, sorted, &retStatus, &retErrno)) {
+            errno = retErrno;
+            return retStatus;
+        }
+        retStatus = 0;
+        retErrno  = 0;
+    }
+#endif
+
     // Figure out how many file descriptors there are.
     //
-    status = getrlimit(RLIMIT_NOFILE, &limits);
+    getrlimit(RLIMIT_NOFILE, &limits);
 
     if (limits.rlim_cur == RLIM_INFINITY)
     {
@@ -53,9 +248,6 @@ ArchCloseAllFiles(int nExcept, const int* exceptFds)
         }
     }
 
-    retStatus = 0;
-    retErrno  = 0;
-
     for (i = 0; i < maxfd; ++i)
     {
         // Check if we should skip this file descriptor.
@@ -76,21 +268,7 @@ ArchCloseAllFiles(int nExcept, const int* exceptFds)
             }
         }
 
-        do {
-            // Close the file, repeat if interrupted.
-            //
-            errno = 0;
-            status = close(i);
-        } while (status != 0 && errno == EINTR);
-
-        if (status != 0 &&
-            errno  != EBADF)
-        {
-            // We got some real error.  Remember it but keep going.
-            //
-            retStatus = status;
-            retErrno  = errno;
-        }
+        _Close(i, &retStatus, &retErrno);
     }
 
     // Restore errno to the last encountered real error.  In
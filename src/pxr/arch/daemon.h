@@ -27,6 +27,12 @@ namespace pxr {
 /// \p nExcept should be the number of elements in the \p exceptFds array.
 /// Invalid file descriptors in exceptFds are ignored.
 ///
+/// On Linux this uses \c close_range(2) if available and otherwise closes
+/// only the descriptors listed in \c /proc/self/fd, so it does not take
+/// time proportional to the limit on open files.  Elsewhere, or if neither
+/// works, every descriptor up to that limit is closed.  This function does
+/// not allocate and is async-signal-safe.
+///
 /// \note Be \b very careful when using this routine.  It is intended
 /// to be used after a \c fork(2) call to close \b all unwanted file
 /// descriptors.  However, it does not flush stdio buffers, wait for
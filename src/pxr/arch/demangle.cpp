@@ -8,10 +8,17 @@
 #include "./demangle.h"
 #include "./defines.h"
 #include "./error.h"
+#include "./hash.h"
+#include <algorithm>
 #include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <typeinfo>
 #include <string>
 #include <string.h>
+#include <unordered_map>
+#include <vector>
 
 using std::string;
 
@@ -201,6 +208,8 @@ ArchDemangle(string* mangledTypeName)
 #endif // _PARANOID_CHECK_MODE
 }
 
+static std::string_view _GetDemangledFunctionNameCached(std::string_view);
+
 void
 Arch_DemangleFunctionName(string* mangledFunctionName)
 {
@@ -208,7 +217,11 @@ Arch_DemangleFunctionName(string* mangledFunctionName)
         (*mangledFunctionName)[0] == '_' && (*mangledFunctionName)[1] == 'Z') {
         // Note: _DemangleNew isn't doing the correct thing with
         //       function names, use the old codepath. 
-        _DemangleOld(mangledFunctionName);
+        const std::string_view demangled =
+            _GetDemangledFunctionNameCached(*mangledFunctionName);
+        if (!demangled.empty()) {
+            mangledFunctionName->assign(demangled.data(), demangled.size());
+        }
     }
 }
 
@@ -235,6 +248,1356 @@ Arch_DemangleFunctionName(string* mangledFunctionName)
 
 #endif // _AT_LEAST_GCC_THREE_ONE_OR_CLANG
 
+namespace {
+
+// Append-only storage for the demangled names.  Strings stored here are
+// never moved or freed.
+class _DemangleArena
+{
+public:
+    std::string_view Store(std::string_view str)
+    {
+        if (str.empty()) {
+            return std::string_view();
+        }
+        if (_blocks.empty() || _used + str.size() > _blockSize) {
+            _blockSize = std::max(_defaultBlockSize, str.size());
+            _blocks.emplace_back(new char[_blockSize]);
+            _used = 0;
+        }
+        char* result = _blocks.back().get() + _used;
+        memcpy(result, str.data(), str.size());
+        _used += str.size();
+        return std::string_view(result, str.size());
+    }
+
+private:
+    static constexpr size_t _defaultBlockSize = 16384;
+
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    size_t _blockSize = 0;
+    size_t _used = 0;
+};
+
+// Thread-safe cache of demangled names.  Entries are spread over shards
+// by hash to limit contention, and each shard owns the arena its keys and
+// values are stored in.
+class _DemangleCache
+{
+public:
+    using DemangleFn = bool (*)(string*);
+
+    explicit _DemangleCache(DemangleFn demangle) : _demangle(demangle) {}
+
+    // Return the demangled name of mangled, which may be empty if it
+    // cannot be demangled.
+    std::string_view Get(std::string_view mangled)
+    {
+        _Shard& shard = _GetShard(ArchHash64(mangled.data(), mangled.size()));
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.byName.find(mangled);
+            if (it != shard.byName.end()) {
+                return it->second;
+            }
+        }
+
+        // Demangle outside the lock.  Another thread may race us to it, in
+        // which case its result is kept.
+        string demangled(mangled);
+        if (!_demangle(&demangled)) {
+            demangled.clear();
+        }
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.byName.find(mangled);
+        if (it == shard.byName.end()) {
+            it = shard.byName.emplace(
+                shard.arena.Store(mangled),
+                shard.arena.Store(demangled)).first;
+        }
+        return it->second;
+    }
+
+    // Return the demangled name of the string at mangled, which must remain
+    // valid and unchanged for the lifetime of the process.
+    std::string_view GetStatic(const char* mangled)
+    {
+        _Shard& shard = _GetShard(reinterpret_cast<uintptr_t>(mangled) >> 3);
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            auto it = shard.byPointer.find(mangled);
+            if (it != shard.byPointer.end()) {
+                return it->second;
+            }
+        }
+
+        const std::string_view result = Get(mangled);
+
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.byPointer.emplace(mangled, result);
+        return result;
+    }
+
+private:
+    struct _Shard {
+        std::shared_mutex mutex;
+        std::unordered_map<std::string_view, std::string_view> byName;
+        std::unordered_map<const char*, std::string_view> byPointer;
+        _DemangleArena arena;
+    };
+
+    static constexpr size_t _numShards = 16;
+
+    _Shard& _GetShard(uint64_t hash)
+    {
+        return _shards[(hash ^ (hash >> 32)) % _numShards];
+    }
+
+    DemangleFn _demangle;
+    _Shard _shards[_numShards];
+};
+
+_DemangleCache&
+_GetTypeNameCache()
+{
+    static _DemangleCache* cache = new _DemangleCache(ArchDemangle);
+    return *cache;
+}
+
+} // anonymous namespace
+
+#if defined(_AT_LEAST_GCC_THREE_ONE_OR_CLANG)
+
+static std::string_view
+_GetDemangledFunctionNameCached(std::string_view mangledFunctionName)
+{
+    static _DemangleCache* cache = new _DemangleCache(_DemangleOld);
+    return cache->Get(mangledFunctionName);
+}
+
+#endif // _AT_LEAST_GCC_THREE_ONE_OR_CLANG
+
+std::string_view
+ArchGetDemangledCached(std::string_view typeName)
+{
+    return _GetTypeNameCache().Get(typeName);
+}
+
+std::string_view
+ArchGetDemangledCached(const std::type_info& typeInfo)
+{
+    return _GetTypeNameCache().GetStatic(typeInfo.name());
+}
+
+namespace {
+
+bool _IsDigit(char c) { return c >= '0' && c <= '9'; }
+bool _IsUpper(char c) { return c >= 'A' && c <= 'Z'; }
+bool _IsLower(char c) { return c >= 'a' && c <= 'z'; }
+
+const char*
+_GetBuiltinTypeName(char code)
+{
+    switch (code) {
+    case 'v': return "void";
+    case 'w': return "wchar_t";
+    case 'b': return "bool";
+    case 'c': return "char";
+    case 'a': return "signed char";
+    case 'h': return "unsigned char";
+    case 's': return "short";
+    case 't': return "unsigned short";
+    case 'i': return "int";
+    case 'j': return "unsigned int";
+    case 'l': return "long";
+    case 'm': return "unsigned long";
+    case 'x': return "long long";
+    case 'y': return "unsigned long long";
+    case 'n': return "__int128";
+    case 'o': return "unsigned __int128";
+    case 'f': return "float";
+    case 'd': return "double";
+    case 'e': return "long double";
+    case 'g': return "__float128";
+    case 'z': return "...";
+    default: return nullptr;
+    }
+}
+
+struct _OperatorName {
+    char code[3];
+    const char* name;
+};
+
+constexpr _OperatorName _operatorNames[] = {
+    {"nw", "new"}, {"na", "new[]"}, {"dl", "delete"}, {"da", "delete[]"},
+    {"ps", "+"}, {"ng", "-"}, {"ad", "&"}, {"de", "*"}, {"co", "~"},
+    {"pl", "+"}, {"mi", "-"}, {"ml", "*"}, {"dv", "/"}, {"rm", "%"},
+    {"an", "&"}, {"or", "|"}, {"eo", "^"}, {"aS", "="}, {"pL", "+="},
+    {"mI", "-="}, {"mL", "*="}, {"dV", "/="}, {"rM", "%="}, {"aN", "&="},
+    {"oR", "|="}, {"eO", "^="}, {"ls", "<<"}, {"rs", ">>"}, {"lS", "<<="},
+    {"rS", ">>="}, {"eq", "=="}, {"ne", "!="}, {"lt", "<"}, {"gt", ">"},
+    {"le", "<="}, {"ge", ">="}, {"ss", "<=>"}, {"nt", "!"}, {"aa", "&&"},
+    {"oo", "||"}, {"pp", "++"}, {"mm", "--"}, {"cm", ","}, {"pm", "->*"},
+    {"pt", "->"}, {"cl", "()"}, {"ix", "[]"}, {"qu", "?"},
+};
+
+// Demangler for the common subset of the Itanium C++ ABI that writes its
+// output directly into a fixed buffer.  Substitution candidates and
+// template arguments are remembered as ranges of the output written so far
+// and copied when they are referenced, so nothing is ever allocated.
+class _BufferDemangler
+{
+public:
+    _BufferDemangler(const char* mangled, char* buffer, size_t size)
+        : _in(mangled), _out(buffer), _size(size) {}
+
+    bool Demangle()
+    {
+        bool ok;
+        if (_in[0] == '_' && _in[1] == 'Z') {
+            _in += 2;
+            ok = _ParseEncoding(false) && _ParseCloneSuffixes();
+        }
+        else {
+            ok = _ParseType();
+        }
+        ok = ok && *_in == '\0';
+        _out[ok ? _len : 0] = '\0';
+        return ok;
+    }
+
+private:
+    // A range of the output, with the properties of the type it holds that
+    // matter when it's referenced again.  Function types need the
+    // declarator syntax when they're decorated, and packSize is the number
+    // of elements of a template argument pack or -1 for other arguments.
+    struct _Range {
+        size_t begin;
+        size_t end;
+        bool isFunction = false;
+        int packSize = -1;
+    };
+
+    // Marks ranges whose text has been erased.
+    static constexpr size_t _erased = size_t(-1);
+
+    // A comma separated list being parsed.  As in the libiberty demangler,
+    // empty elements, from empty argument packs, are separated like any
+    // other unless every element after them is empty.
+    struct _List {
+        size_t count = 0;
+        bool hasEmptyTail = false;
+        size_t emptyTail = 0;
+    };
+
+    // Properties of a name that affect how the enclosing encoding is
+    // printed.
+    struct _NameInfo {
+        bool isTemplate = false;
+        bool isCtorDtorConv = false;
+        int cvQualifiers = 0;
+        int refQualifier = 0;
+    };
+
+    enum {
+        _Const = 1,
+        _Volatile = 2,
+        _Restrict = 4
+    };
+
+    // Bounds the recursion so hostile input cannot exhaust the stack.
+    class _DepthGuard
+    {
+    public:
+        explicit _DepthGuard(_BufferDemangler* d) : _d(d) { ++_d->_depth; }
+        ~_DepthGuard() { --_d->_depth; }
+        explicit operator bool() const { return _d->_depth <= _maxDepth; }
+    private:
+        _BufferDemangler* _d;
+    };
+
+    bool _Append(const char* str, size_t n)
+    {
+        // Always keep room for the terminating NUL.
+        if (n >= _size - _len) {
+            return false;
+        }
+        memcpy(_out + _len, str, n);
+        _len += n;
+        return true;
+    }
+
+    bool _Append(const char* str)
+    {
+        return _Append(str, strlen(str));
+    }
+
+    bool _AppendRange(const _Range& range)
+    {
+        if (range.begin == _erased) {
+            return false;
+        }
+        const size_t n = range.end - range.begin;
+        if (n >= _size - _len) {
+            return false;
+        }
+        memmove(_out + _len, _out + range.begin, n);
+        _len += n;
+        return true;
+    }
+
+    bool _AppendNumber(size_t value)
+    {
+        char digits[24];
+        size_t n = 0;
+        do {
+            digits[sizeof(digits) - ++n] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        return _Append(digits + sizeof(digits) - n, n);
+    }
+
+    bool _AppendCvQualifiers(int cv)
+    {
+        return (!(cv & _Const) || _Append(" const")) &&
+               (!(cv & _Volatile) || _Append(" volatile")) &&
+               (!(cv & _Restrict) || _Append(" restrict"));
+    }
+
+    bool _AddSubstitution(size_t begin, bool isFunction = false)
+    {
+        if (_numSubs == _maxSubstitutions) {
+            return false;
+        }
+        _subs[_numSubs++] = {begin, _len, isFunction};
+        return true;
+    }
+
+    // Applies f to every recorded range.
+    template <class Fn>
+    void _ForEachRange(Fn f)
+    {
+        std::for_each(_subs, _subs + _numSubs, f);
+        std::for_each(_templateArgs, _templateArgs + _numTemplateArgs, f);
+        std::for_each(_argStack, _argStack + _argTop, f);
+    }
+
+    // Moves the output from middle to the end in front of the output from
+    // start to middle, keeping the recorded ranges pointing at their text.
+    void _Rotate(size_t start, size_t middle)
+    {
+        std::rotate(_out + start, _out + middle, _out + _len);
+        const size_t head = middle - start;
+        const size_t tail = _len - middle;
+        auto adjust = [=](_Range& range) {
+            if (range.begin == _erased) {
+                return;
+            }
+            if (range.begin >= middle) {
+                range.begin -= head;
+                range.end -= head;
+            }
+            else if (range.begin >= start) {
+                range.begin += tail;
+                range.end += tail;
+            }
+        };
+        _ForEachRange(adjust);
+    }
+
+    // Removes the output from begin to end.  Ranges in it can no longer be
+    // referenced.
+    void _Erase(size_t begin, size_t end)
+    {
+        memmove(_out + begin, _out + end, _len - end);
+        _len -= end - begin;
+        _ForEachRange([=](_Range& range) {
+            if (range.begin == _erased) {
+                return;
+            }
+            if (range.begin >= end) {
+                range.begin -= end - begin;
+                range.end -= end - begin;
+            }
+            else if (range.begin >= begin) {
+                range.begin = range.end = _erased;
+            }
+        });
+    }
+
+    // Returns the last component of the qualified name between begin and
+    // end, without its ABI tags and template arguments.
+    _Range _GetLastComponent(size_t begin, size_t end) const
+    {
+        if (end > begin && _out[end - 1] == '>') {
+            int nesting = 0;
+            while (end > begin) {
+                const char c = _out[--end];
+                if (c == '>') {
+                    ++nesting;
+                }
+                else if (c == '<' && --nesting == 0) {
+                    break;
+                }
+            }
+        }
+        while (end > begin && _out[end - 1] == ']') {
+            size_t tag = end - 1;
+            while (tag > begin && _out[tag] != '[') {
+                --tag;
+            }
+            if (end - tag < 6 || strncmp(_out + tag, "[abi:", 5) != 0) {
+                break;
+            }
+            end = tag;
+        }
+        size_t first = end;
+        while (first > begin &&
+               !(_out[first - 1] == ':' && first - 1 > begin &&
+                 _out[first - 2] == ':')) {
+            --first;
+        }
+        return {first, end};
+    }
+
+    bool _ParseNumber(size_t* value)
+    {
+        if (!_IsDigit(*_in)) {
+            return false;
+        }
+        size_t result = 0;
+        while (_IsDigit(*_in)) {
+            result = result * 10 + (*_in++ - '0');
+            if (result > (1u << 20)) {
+                return false;
+            }
+        }
+        *value = result;
+        return true;
+    }
+
+    // Parses an optionally negative number followed by '_', as found in
+    // call offsets.
+    bool _SkipOffset()
+    {
+        size_t value;
+        if (*_in == 'n') {
+            ++_in;
+        }
+        return _ParseNumber(&value) && *_in++ == '_';
+    }
+
+    bool _AtEncodingEnd() const
+    {
+        return *_in == '\0' || *_in == 'E' || *_in == '.';
+    }
+
+    int _ParseCvQualifiers()
+    {
+        int cv = 0;
+        if (*_in == 'r') {
+            cv |= _Restrict;
+            ++_in;
+        }
+        if (*_in == 'V') {
+            cv |= _Volatile;
+            ++_in;
+        }
+        if (*_in == 'K') {
+            cv |= _Const;
+            ++_in;
+        }
+        return cv;
+    }
+
+    // Parses an encoding.  The return type of a function template is
+    // omitted when the encoding is the scope of a local name.
+    bool _ParseEncoding(bool isScope)
+    {
+        _DepthGuard guard(this);
+        if (!guard) {
+            return false;
+        }
+
+        if (*_in == 'T' || *_in == 'G') {
+            return _ParseSpecialName();
+        }
+
+        const size_t start = _len;
+        _NameInfo info;
+        if (!_ParseName(&info)) {
+            return false;
+        }
+        if (_AtEncodingEnd()) {
+            return true;
+        }
+
+        // Template functions other than constructors, destructors and
+        // conversion operators have their return type mangled first.
+        size_t returnSize = 0;
+        if (info.isTemplate && !info.isCtorDtorConv) {
+            const size_t returnStart = _len;
+            if (!_ParseType() || !_Append(" ")) {
+                return false;
+            }
+            returnSize = _len - returnStart;
+            _Rotate(start, returnStart);
+        }
+
+        if (!_ParseParameters() ||
+            !_AppendCvQualifiers(info.cvQualifiers)) {
+            return false;
+        }
+        if (info.refQualifier &&
+            !_Append(info.refQualifier == 1 ? " &" : " &&")) {
+            return false;
+        }
+        if (isScope && returnSize) {
+            _Erase(start, start + returnSize);
+        }
+        return true;
+    }
+
+    bool _ParseSpecialName()
+    {
+        _NameInfo info;
+        if (*_in == 'G') {
+            if (_in[1] != 'V') {
+                return false;
+            }
+            _in += 2;
+            return _Append("guard variable for ") && _ParseName(&info);
+        }
+
+        ++_in;
+        switch (*_in++) {
+        case 'V':
+            return _Append("vtable for ") && _ParseType();
+        case 'T':
+            return _Append("VTT for ") && _ParseType();
+        case 'I':
+            return _Append("typeinfo for ") && _ParseType();
+        case 'S':
+            return _Append("typeinfo name for ") && _ParseType();
+        case 'W':
+            return _Append("TLS wrapper function for ") && _ParseName(&info);
+        case 'H':
+            return _Append("TLS init function for ") && _ParseName(&info);
+        case 'h':
+            return _SkipOffset() &&
+                _Append("non-virtual thunk to ") && _ParseEncoding(false);
+        case 'v':
+            return _SkipOffset() && _SkipOffset() &&
+                _Append("virtual thunk to ") && _ParseEncoding(false);
+        default:
+            return false;
+        }
+    }
+
+    bool _ParseCloneSuffixes()
+    {
+        while (*_in == '.') {
+            const char* begin = _in;
+            if (_IsLower(_in[1]) || _IsDigit(_in[1]) || _in[1] == '_') {
+                _in += 2;
+                while (_IsLower(*_in) || _IsDigit(*_in) || *_in == '_') {
+                    ++_in;
+                }
+            }
+            while (_in[0] == '.' && _IsDigit(_in[1])) {
+                _in += 2;
+                while (_IsDigit(*_in)) {
+                    ++_in;
+                }
+            }
+            if (_in == begin) {
+                return false;
+            }
+            if (!_Append(" [clone ") || !_Append(begin, _in - begin) ||
+                !_Append("]")) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Parses parameter types up to the end of the enclosing production.
+    bool _ParseParameters()
+    {
+        if (!_Append("(")) {
+            return false;
+        }
+        auto atEnd = [this]() {
+            return _AtEncodingEnd() ||
+                ((*_in == 'R' || *_in == 'O') && _in[1] == 'E');
+        };
+        if (*_in == 'v') {
+            // A lone void means there are no parameters.
+            ++_in;
+            if (!atEnd()) {
+                return false;
+            }
+        }
+        _List list;
+        while (!atEnd()) {
+            if (!_ParseListElement(&list, &_BufferDemangler::_ParseTypeOnly)) {
+                return false;
+            }
+        }
+        _CloseList(list);
+        return _Append(")");
+    }
+
+    bool _ParseTypeOnly()
+    {
+        return _ParseType();
+    }
+
+    // Parses one element of a comma separated list.
+    bool _ParseListElement(_List* list, bool (_BufferDemangler::*parse)(),
+                           _Range* element = nullptr)
+    {
+        const size_t separator = _len;
+        if (list->count++ && !_Append(", ")) {
+            return false;
+        }
+        const size_t begin = _len;
+        if (!(this->*parse)()) {
+            return false;
+        }
+        if (_len != begin) {
+            list->hasEmptyTail = false;
+        }
+        else if (separator != begin && !list->hasEmptyTail) {
+            list->hasEmptyTail = true;
+            list->emptyTail = separator;
+        }
+        if (element) {
+            *element = {begin, _len};
+        }
+        return true;
+    }
+
+    // Drops the separators of the empty elements ending a list.
+    void _CloseList(const _List& list)
+    {
+        if (list.hasEmptyTail) {
+            _len = list.emptyTail;
+            _droppedSeparator = _len;
+        }
+    }
+
+    bool _ParseName(_NameInfo* info)
+    {
+        _DepthGuard guard(this);
+        if (!guard) {
+            return false;
+        }
+
+        if (*_in == 'N') {
+            return _ParseNestedName(info);
+        }
+        if (*_in == 'Z') {
+            return _ParseLocalName(info);
+        }
+
+        const size_t start = _len;
+        if (_in[0] == 'S' && _in[1] != 't') {
+            // An unscoped template name may be a substitution, which must
+            // then be followed by its template arguments.
+            return _ParseSubstitution(false) && *_in == 'I' &&
+                _ParseTemplateArgs(info);
+        }
+        if (_in[0] == 'S') {
+            _in += 2;
+            if (!_Append("std::")) {
+                return false;
+            }
+        }
+        if (!_ParseUnqualifiedName(info, start)) {
+            return false;
+        }
+        if (*_in == 'I') {
+            return _AddSubstitution(start) && _ParseTemplateArgs(info);
+        }
+        return true;
+    }
+
+    bool _ParseNestedName(_NameInfo* info)
+    {
+        ++_in;
+        info->cvQualifiers = _ParseCvQualifiers();
+        if (*_in == 'R' || *_in == 'O') {
+            info->refQualifier = *_in++ == 'R' ? 1 : 2;
+        }
+
+        // Every prefix is a substitution candidate, except for the ones
+        // that are substitutions themselves and std.
+        const size_t start = _len;
+        bool first = true;
+        while (*_in != 'E') {
+            if (*_in == 'I') {
+                if (first || !_ParseTemplateArgs(info)) {
+                    return false;
+                }
+            }
+            else {
+                if (!first && !_Append("::")) {
+                    return false;
+                }
+                info->isTemplate = false;
+                info->isCtorDtorConv = false;
+                if (_in[0] == 'S') {
+                    if (!first) {
+                        return false;
+                    }
+                    first = false;
+                    if (_in[1] == 't') {
+                        _in += 2;
+                        if (!_Append("std")) {
+                            return false;
+                        }
+                    }
+                    else if (!_ParseSubstitution(true)) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (*_in == 'T') {
+                    if (!_ParseTemplateParam()) {
+                        return false;
+                    }
+                }
+                else if (!_ParseUnqualifiedName(info, start)) {
+                    return false;
+                }
+            }
+            first = false;
+            if (*_in != 'E' && !_AddSubstitution(start)) {
+                return false;
+            }
+        }
+        ++_in;
+        return !first;
+    }
+
+    bool _ParseLocalName(_NameInfo* info)
+    {
+        ++_in;
+        if (!_ParseEncoding(true) || *_in++ != 'E' || !_Append("::")) {
+            return false;
+        }
+
+        *info = _NameInfo();
+        if (*_in == 's') {
+            ++_in;
+            if (!_Append("string literal")) {
+                return false;
+            }
+        }
+        else if (*_in == 'd' || !_ParseName(info)) {
+            return false;
+        }
+
+        // The discriminator is not printed.
+        size_t discriminator;
+        if (*_in == '_') {
+            ++_in;
+            if (*_in == '_') {
+                ++_in;
+                return _ParseNumber(&discriminator) && *_in++ == '_';
+            }
+            return _ParseNumber(&discriminator);
+        }
+        return true;
+    }
+
+    bool _ParseUnqualifiedName(_NameInfo* info, size_t prefixStart)
+    {
+        // Names with internal linkage are printed like any other.
+        if (_in[0] == 'L' && _IsDigit(_in[1])) {
+            ++_in;
+        }
+
+        const char c = *_in;
+        if (_IsDigit(c)) {
+            if (!_ParseSourceName()) {
+                return false;
+            }
+        }
+        else if (c == 'C' || c == 'D') {
+            if (c == 'C' ? (_in[1] < '1' || _in[1] > '5') :
+                (_in[1] != '0' && _in[1] != '1' && _in[1] != '2' &&
+                 _in[1] != '4' && _in[1] != '5')) {
+                return false;
+            }
+            _in += 2;
+
+            // Constructors and destructors are named after their class,
+            // which is the last component of the prefix just written.
+            if (_len < prefixStart + 2 || _out[_len - 1] != ':') {
+                return false;
+            }
+            // Those of lambdas and unnamed types are printed inconsistently,
+            // so they're not supported.
+            const _Range name = _GetLastComponent(prefixStart, _len - 2);
+            if (name.begin == name.end || _out[name.begin] == '{' ||
+                (c == 'D' && !_Append("~")) || !_AppendRange(name)) {
+                return false;
+            }
+            info->isCtorDtorConv = true;
+        }
+        else if (c == 'U') {
+            if (_in[1] == 'l') {
+                _in += 2;
+                if (!_Append("{lambda") || !_ParseParameters() ||
+                    *_in++ != 'E' || !_ParseUnnamedNumber()) {
+                    return false;
+                }
+            }
+            else if (_in[1] == 't') {
+                _in += 2;
+                if (!_Append("{unnamed type") || !_ParseUnnamedNumber()) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+        }
+        else if (_IsLower(c)) {
+            if (!_ParseOperatorName(info)) {
+                return false;
+            }
+        }
+        else {
+            return false;
+        }
+
+        while (*_in == 'B') {
+            ++_in;
+            size_t n;
+            if (!_ParseNumber(&n) || strnlen(_in, n) < n ||
+                !_Append("[abi:") || !_Append(_in, n) || !_Append("]")) {
+                return false;
+            }
+            _in += n;
+        }
+        return true;
+    }
+
+    // Parses the number of a lambda or unnamed type and closes its name.
+    bool _ParseUnnamedNumber()
+    {
+        size_t n = 0;
+        if (_IsDigit(*_in)) {
+            if (!_ParseNumber(&n)) {
+                return false;
+            }
+            ++n;
+        }
+        return *_in++ == '_' &&
+            _Append("#") && _AppendNumber(n + 1) && _Append("}");
+    }
+
+    bool _ParseSourceName()
+    {
+        size_t n;
+        if (!_ParseNumber(&n) || strnlen(_in, n) < n) {
+            return false;
+        }
+        const char* name = _in;
+        _in += n;
+        if (n >= 10 && strncmp(name, "_GLOBAL_", 8) == 0 &&
+            (name[8] == '.' || name[8] == '_' || name[8] == '$') &&
+            name[9] == 'N') {
+            return _Append("(anonymous namespace)");
+        }
+        return _Append(name, n);
+    }
+
+    bool _ParseOperatorName(_NameInfo* info)
+    {
+        if (_in[0] == 'c' && _in[1] == 'v') {
+            // Template parameters in the type of a conversion operator
+            // template refer to its own arguments, which follow, so they're
+            // not supported.
+            _in += 2;
+            info->isCtorDtorConv = true;
+            const size_t numParams = _numParamsParsed;
+            return _Append("operator ") && _ParseType() &&
+                (*_in != 'I' || _numParamsParsed == numParams);
+        }
+        if (_in[0] == 'l' && _in[1] == 'i') {
+            _in += 2;
+            return _Append("operator\"\" ") && _ParseSourceName();
+        }
+        for (const _OperatorName& op : _operatorNames) {
+            if (_in[0] == op.code[0] && _in[1] == op.code[1]) {
+                _in += 2;
+                return _Append("operator") &&
+                    (!_IsLower(op.name[0]) || _Append(" ")) &&
+                    _Append(op.name);
+            }
+        }
+        return false;
+    }
+
+    bool _ParseSubstitution(bool inPrefix, bool* isFunction = nullptr)
+    {
+        ++_in;
+        const char c = *_in;
+        if (c == '_' || _IsDigit(c) || _IsUpper(c)) {
+            size_t index = 0;
+            if (c != '_') {
+                while (*_in != '_') {
+                    const char d = *_in++;
+                    if (_IsDigit(d)) {
+                        index = index * 36 + (d - '0');
+                    }
+                    else if (_IsUpper(d)) {
+                        index = index * 36 + (d - 'A' + 10);
+                    }
+                    else {
+                        return false;
+                    }
+                    if (index >= _maxSubstitutions) {
+                        return false;
+                    }
+                }
+                ++index;
+            }
+            ++_in;
+            if (index >= _numSubs) {
+                return false;
+            }
+            if (isFunction) {
+                *isFunction = _subs[index].isFunction;
+            }
+            return _AppendRange(_subs[index]);
+        }
+
+        const char* abbreviation;
+        const char* expansion;
+        switch (c) {
+        case 'a':
+            ++_in;
+            return _Append("std::allocator");
+        case 'b':
+            ++_in;
+            return _Append("std::basic_string");
+        case 's':
+            abbreviation = "std::string";
+            expansion = "std::basic_string<char, std::char_traits<char>, "
+                "std::allocator<char> >";
+            break;
+        case 'i':
+            abbreviation = "std::istream";
+            expansion = "std::basic_istream<char, std::char_traits<char> >";
+            break;
+        case 'o':
+            abbreviation = "std::ostream";
+            expansion = "std::basic_ostream<char, std::char_traits<char> >";
+            break;
+        case 'd':
+            abbreviation = "std::iostream";
+            expansion = "std::basic_iostream<char, std::char_traits<char> >";
+            break;
+        default:
+            return false;
+        }
+        ++_in;
+
+        // The full name is needed to name constructors and destructors.
+        return _Append(inPrefix && (*_in == 'C' || *_in == 'D') ?
+                       expansion : abbreviation);
+    }
+
+    bool _ParseTemplateParam(bool* isFunction = nullptr)
+    {
+        ++_in;
+        size_t index = 0;
+        if (*_in != '_') {
+            if (!_ParseNumber(&index)) {
+                return false;
+            }
+            ++index;
+        }
+        if (*_in++ != '_' || index >= _numTemplateArgs) {
+            return false;
+        }
+        ++_numParamsParsed;
+
+        // A pack expansion whose pattern decorates a pack would have to
+        // print the pattern for every element, so only packs of one element
+        // are supported there.
+        const _Range& arg = _templateArgs[index];
+        if (_packExpansionDepth && arg.packSize >= 0 && arg.packSize != 1) {
+            return false;
+        }
+        if (isFunction) {
+            *isFunction = arg.isFunction;
+        }
+        return _AppendRange(arg);
+    }
+
+    bool _ParseTemplateArgs(_NameInfo* info)
+    {
+        ++_in;
+        if (_len && _out[_len - 1] == '<' && !_Append(" ")) {
+            return false;
+        }
+        if (!_Append("<")) {
+            return false;
+        }
+
+        // The arguments of the outermost template argument list of the
+        // encoded name are the ones template parameters refer to.
+        const bool record = _templateArgsDepth == 0 && _typeDepth == 0;
+        const size_t argBase = _argTop;
+        _List list;
+        ++_templateArgsDepth;
+        while (*_in != 'E') {
+            if (*_in == '\0' || _argTop == _maxArgStack) {
+                return false;
+            }
+            _Range& arg = _argStack[_argTop];
+            if (!_ParseListElement(&list, &_BufferDemangler::_ParseTemplateArg,
+                                   &arg)) {
+                return false;
+            }
+            arg.isFunction = _argIsFunction;
+            arg.packSize = _argPackSize;
+            ++_argTop;
+        }
+        ++_in;
+        --_templateArgsDepth;
+        _CloseList(list);
+
+        if (record) {
+            _numTemplateArgs = std::min(_argTop - argBase, _maxTemplateArgs);
+            std::copy(_argStack + argBase, _argStack + argBase +
+                      _numTemplateArgs, _templateArgs);
+        }
+        _argTop = argBase;
+
+        // The libiberty demangler looks at the last character it wrote
+        // rather than the last one kept, so a dropped separator suppresses
+        // the space.
+        if (_out[_len - 1] == '>' && _len != _droppedSeparator &&
+            !_Append(" ")) {
+            return false;
+        }
+        if (info) {
+            info->isTemplate = true;
+        }
+        return _Append(">");
+    }
+
+    bool _ParseTemplateArg()
+    {
+        _DepthGuard guard(this);
+        if (!guard) {
+            return false;
+        }
+
+        bool function = false;
+        int packSize = -1;
+        switch (*_in) {
+        case 'L':
+            if (!_ParseLiteral()) {
+                return false;
+            }
+            break;
+        case 'J': {
+            // Argument packs are printed as their elements.
+            ++_in;
+            _List list;
+            while (*_in != 'E') {
+                if (*_in == '\0' || !_ParseListElement(
+                        &list, &_BufferDemangler::_ParseTemplateArg)) {
+                    return false;
+                }
+            }
+            ++_in;
+            _CloseList(list);
+            packSize = static_cast<int>(list.count);
+            break;
+        }
+        case 'X':
+            return false;
+        default:
+            if (!_ParseType(&function)) {
+                return false;
+            }
+            break;
+        }
+        _argIsFunction = function;
+        _argPackSize = packSize;
+        return true;
+    }
+
+    bool _ParseLiteral()
+    {
+        ++_in;
+        const char* suffix = nullptr;
+        switch (*_in) {
+        case 'b':
+            if ((_in[1] != '0' && _in[1] != '1') || _in[2] != 'E') {
+                return false;
+            }
+            _in += 3;
+            return _Append(_in[-2] == '1' ? "true" : "false");
+        case 'i': suffix = ""; break;
+        case 'j': suffix = "u"; break;
+        case 'l': suffix = "l"; break;
+        case 'm': suffix = "ul"; break;
+        case 'x': suffix = "ll"; break;
+        case 'y': suffix = "ull"; break;
+        case 'a': case 'c': case 'h': case 's': case 't':
+            break;
+        default:
+            // Enumerators, floating point values, null pointers and
+            // external names are not supported.
+            return false;
+        }
+
+        if (suffix) {
+            ++_in;
+        }
+        else if (!_Append("(") || !_ParseType() || !_Append(")")) {
+            return false;
+        }
+        if (*_in == 'n') {
+            ++_in;
+            if (!_Append("-")) {
+                return false;
+            }
+        }
+        const char* digits = _in;
+        while (_IsDigit(*_in)) {
+            ++_in;
+        }
+        return _in != digits && *_in++ == 'E' &&
+            _Append(digits, _in - 1 - digits) && (!suffix || _Append(suffix));
+    }
+
+    bool _ParseType(bool* isFunction = nullptr)
+    {
+        _DepthGuard guard(this);
+        if (!guard) {
+            return false;
+        }
+        ++_typeDepth;
+        const bool result = _ParseTypeImpl(isFunction);
+        --_typeDepth;
+        return result;
+    }
+
+    bool _ParseTypeImpl(bool* isFunction)
+    {
+        if (const char* builtin = _GetBuiltinTypeName(*_in)) {
+            ++_in;
+            return _Append(builtin);
+        }
+
+        const size_t start = _len;
+        bool function = false;
+        switch (*_in) {
+        case 'D':
+            _in += 2;
+            switch (_in[-1]) {
+            case 'n': return _Append("decltype(nullptr)");
+            case 'i': return _Append("char32_t");
+            case 's': return _Append("char16_t");
+            case 'u': return _Append("char8_t");
+            case 'a': return _Append("auto");
+            case 'c': return _Append("decltype(auto)");
+            case 'p': {
+                // A pack expansion prints as the expanded pack, which is
+                // only right as is when the pattern is the pack itself.
+                if (*_in == 'T') {
+                    return _ParseTemplateParam() && *_in != 'I' &&
+                        _AddSubstitution(start) && _AddSubstitution(start);
+                }
+                ++_packExpansionDepth;
+                const bool result = _ParseType();
+                --_packExpansionDepth;
+                return result && _AddSubstitution(start);
+            }
+            default:
+                return false;
+            }
+
+        case 'r':
+        case 'V':
+        case 'K': {
+            // Qualifiers on references through template parameters are
+            // dropped, which is not supported.
+            const int cv = _ParseCvQualifiers();
+            return _ParseType(&function) && !function && _len != start &&
+                _out[_len - 1] != '&' &&
+                _AppendCvQualifiers(cv) && _AddSubstitution(start);
+        }
+
+        case 'P':
+        case 'R':
+        case 'O': {
+            // Pointers and references to functions need the declarator
+            // syntax, which is not supported.
+            const char code = *_in++;
+            if (!_ParseType(&function) || function || _len == start) {
+                return false;
+            }
+
+            // References to references, through template parameters,
+            // collapse to an lvalue reference unless both are rvalue
+            // references.
+            if (_out[_len - 1] == '&') {
+                if (code == 'P') {
+                    return false;
+                }
+                if (code == 'R' && _out[_len - 2] == '&') {
+                    --_len;
+                }
+                return _AddSubstitution(start);
+            }
+            return _Append(code == 'P' ? "*" : code == 'R' ? "&" : "&&") &&
+                _AddSubstitution(start);
+        }
+
+        case 'F':
+            ++_in;
+            if (*_in == 'Y') {
+                ++_in;
+            }
+            if (!_ParseType() || !_Append(" ") || !_ParseParameters()) {
+                return false;
+            }
+            if (*_in == 'R' || *_in == 'O') {
+                if (!_Append(*_in++ == 'R' ? " &" : " &&")) {
+                    return false;
+                }
+            }
+            if (isFunction) {
+                *isFunction = true;
+            }
+            return *_in++ == 'E' && _AddSubstitution(start, true);
+
+        case 'T':
+            if (!_ParseTemplateParam(&function) ||
+                !_AddSubstitution(start, function)) {
+                return false;
+            }
+            if (*_in == 'I') {
+                return _ParseTemplateArgs(nullptr) && _AddSubstitution(start);
+            }
+            if (isFunction) {
+                *isFunction = function;
+            }
+            return true;
+
+        case 'S':
+            if (_in[1] != 't') {
+                if (!_ParseSubstitution(false, &function)) {
+                    return false;
+                }
+                if (isFunction && *_in != 'I') {
+                    *isFunction = function;
+                }
+                if (*_in == 'I') {
+                    return _ParseTemplateArgs(nullptr) &&
+                        _AddSubstitution(start);
+                }
+                return true;
+            }
+            break;
+
+        case 'N':
+        case 'Z':
+        case 'U':
+            break;
+
+        default:
+            if (!_IsDigit(*_in)) {
+                return false;
+            }
+            break;
+        }
+
+        _NameInfo info;
+        return _ParseName(&info) && _AddSubstitution(start);
+    }
+
+    static constexpr int _maxDepth = 64;
+    static constexpr size_t _maxSubstitutions = 128;
+    static constexpr size_t _maxTemplateArgs = 32;
+    static constexpr size_t _maxArgStack = 64;
+
+    const char* _in;
+    char* _out;
+    const size_t _size;
+    size_t _len = 0;
+
+    int _depth = 0;
+    int _typeDepth = 0;
+    int _templateArgsDepth = 0;
+    int _packExpansionDepth = 0;
+    size_t _numParamsParsed = 0;
+
+    // Where the separator of empty elements ending a list was last dropped.
+    size_t _droppedSeparator = _erased;
+
+    // Properties of the template argument last parsed.
+    bool _argIsFunction = false;
+    int _argPackSize = -1;
+
+    _Range _subs[_maxSubstitutions];
+    size_t _numSubs = 0;
+
+    // The arguments template parameters refer to.
+    _Range _templateArgs[_maxTemplateArgs];
+    size_t _numTemplateArgs = 0;
+
+    // The arguments of the template argument lists being parsed.
+    _Range _argStack[_maxArgStack];
+    size_t _argTop = 0;
+};
+
+} // anonymous namespace
+
+bool
+ArchDemangleToBuffer(const char* mangled, char* buffer, size_t size,
+                     bool fallback)
+{
+    if (!mangled || !buffer || size == 0) {
+        return false;
+    }
+    if (_BufferDemangler(mangled, buffer, size).Demangle()) {
+        return true;
+    }
+
+#if defined(_AT_LEAST_GCC_THREE_ONE_OR_CLANG)
+    if (fallback) {
+        int status = 0;
+        if (char* demangled =
+                abi::__cxa_demangle(mangled, nullptr, nullptr, &status)) {
+            const size_t length = strlen(demangled);
+            const bool fits = length < size;
+            if (fits) {
+                memcpy(buffer, demangled, length + 1);
+            }
+            free(demangled);
+            return fits;
+        }
+    }
+#endif
+
+    return false;
+}
+
 string
 ArchGetDemangled(const string& typeName)
 {
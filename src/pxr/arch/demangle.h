@@ -16,7 +16,13 @@
 /// Demangle C++ typenames generated by the \c typeid() facility.
 
 #include "./api.h"
+#include "./defines.h"
+#include "./functionLite.h"
+#include <cstddef>
+#include <iterator>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <typeinfo>
 #include <typeindex>
 
@@ -49,15 +55,59 @@ ArchGetDemangled(const std::string& typeName);
 ARCH_API std::string
 ArchGetDemangled(const char *typeName);
 
+/// Return demangled RTTI-generated type name from a process-wide cache.
+///
+/// The first call for a given \c typeName demangles it like
+/// \c ArchGetDemangled(); later calls only cost a hash lookup.  The result
+/// refers to memory owned by the cache, which remains valid for the
+/// lifetime of the process.  If \c typeName cannot be demangled, an empty
+/// string view is returned.  This function is thread-safe.
+///
+/// \see ArchGetDemangled()
+ARCH_API std::string_view
+ArchGetDemangledCached(std::string_view typeName);
+
+/// Return demangled RTTI-generated type name from a process-wide cache.
+///
+/// Since the name of a \c std::type_info has static storage duration, the
+/// cache is keyed by its address and repeated lookups do not even need to
+/// hash the name.
+///
+/// \see ArchGetDemangledCached()
+/// \overload
+ARCH_API std::string_view
+ArchGetDemangledCached(const std::type_info& typeInfo);
+
+/// Return demangled RTTI-generated type name from a process-wide cache.
+///
+/// \see ArchGetDemangledCached()
+/// \overload
+inline std::string_view
+ArchGetDemangledCached(const std::type_index& typeIndex) {
+    return ArchGetDemangledCached(typeIndex.name());
+}
+
+/// Return demangled RTTI-generated type name from a process-wide cache.
+///
+/// \see ArchGetDemangledCached()
+/// \overload
+template <typename T>
+inline std::string_view
+ArchGetDemangledCached() {
+    return ArchGetDemangledCached(typeid(T));
+}
+
 /// Return demangled RTTI-generated type name.
 ///
 /// Returns the demangled name associated with typeInfo (i.e. typeInfo.name()).
+/// The name is only demangled the first time, see
+/// \c ArchGetDemangledCached().
 ///
 /// \see ArchDemangle()
 /// \overload
 inline std::string
 ArchGetDemangled(const std::type_info& typeInfo) {
-    return ArchGetDemangled(typeInfo.name());
+    return std::string(ArchGetDemangledCached(typeInfo));
 }
 
 /// Return demangled RTTI-generated type name.
@@ -68,7 +118,7 @@ ArchGetDemangled(const std::type_info& typeInfo) {
 /// \overload
 inline std::string
 ArchGetDemangled(const std::type_index& typeIndex) {
-    return ArchGetDemangled(typeIndex.name());
+    return std::string(ArchGetDemangledCached(typeIndex));
 }
 
 /// Return demangled RTTI generated-type name.
@@ -80,9 +130,296 @@ ArchGetDemangled(const std::type_index& typeIndex) {
 template <typename T>
 inline std::string
 ArchGetDemangled() {
-    return ArchGetDemangled(typeid(T).name());
+    return std::string(ArchGetDemangledCached<T>());
 }
 
+/// \private
+/// Rewrites type names found in compiler generated function names to the
+/// form produced by \c ArchDemangle().
+class Arch_TypeNameNormalizer
+{
+public:
+    /// Writes the result to \p out, or only computes its size if \p out is
+    /// null.
+    constexpr explicit Arch_TypeNameNormalizer(char* out) : _out(out) {}
+
+    constexpr size_t GetSize() const { return _size; }
+
+    constexpr void Append(std::string_view name)
+    {
+        // Spellings of std::string by the supported compilers.
+        constexpr std::string_view stringNames[] = {
+            "std::__cxx11::basic_string<char>",
+            "std::__1::basic_string<char>",
+            "std::basic_string<char>",
+            "class std::basic_string<char,struct std::char_traits<char>,"
+                "class std::allocator<char> >",
+        };
+        // Spellings of builtin types and names that the demangler writes
+        // differently.
+        constexpr std::string_view builtinNames[][2] = {
+            {"{anonymous}", "(anonymous namespace)"},
+            {"std::nullptr_t", "decltype(nullptr)"},
+            {"long long unsigned int", "unsigned long long"},
+            {"long long int", "long long"},
+            {"long unsigned int", "unsigned long"},
+            {"long int", "long"},
+            {"short unsigned int", "unsigned short"},
+            {"short int", "short"},
+            {"__int128 unsigned", "unsigned __int128"},
+        };
+        // Prefixes that the demangled names do not have.
+        constexpr std::string_view prefixes[] = {
+            "std::",
+#if defined(ARCH_COMPILER_MSVC)
+            "class ", "struct ", "enum ",
+#endif
+        };
+
+        size_t i = 0;
+        while (i < name.size()) {
+            const std::string_view rest = name.substr(i);
+            const bool atToken = i == 0 || !_IsIdentifierChar(name[i - 1]);
+
+            bool matched = false;
+            for (const std::string_view& stringName : stringNames) {
+                if (rest.substr(0, stringName.size()) == stringName) {
+                    _Emit("string");
+                    _afterString = true;
+                    i += stringName.size();
+                    matched = true;
+                    break;
+                }
+            }
+            for (size_t j = 0; atToken && !matched &&
+                     j != std::size(builtinNames); ++j) {
+                const std::string_view from = builtinNames[j][0];
+                if (rest.substr(0, from.size()) == from &&
+                    (rest.size() == from.size() ||
+                     !_IsIdentifierChar(rest[from.size()]))) {
+                    _Emit(builtinNames[j][1]);
+                    i += from.size();
+                    matched = true;
+                }
+            }
+            for (const std::string_view& prefix : prefixes) {
+                if (atToken && !matched &&
+                    rest.substr(0, prefix.size()) == prefix) {
+                    i += prefix.size();
+                    matched = true;
+                }
+            }
+#if !defined(ARCH_COMPILER_MSVC)
+            if (atToken && !matched) {
+                // Qualifiers are written in front of the type they apply
+                // to, the demangler writes them after it.
+                bool isConst = false, isVolatile = false;
+                for (;;) {
+                    if (name.substr(i, 6) == "const ") {
+                        isConst = true;
+                        i += 6;
+                    }
+                    else if (name.substr(i, 9) == "volatile ") {
+                        isVolatile = true;
+                        i += 9;
+                    }
+                    else {
+                        break;
+                    }
+                }
+                if (isConst || isVolatile) {
+                    const size_t end = _GetEndOfQualifiedType(name, i);
+                    Append(name.substr(i, end - i));
+                    if (isConst) {
+                        _Emit(" const");
+                    }
+                    if (isVolatile) {
+                        _Emit(" volatile");
+                    }
+                    i = end;
+                    matched = true;
+                }
+            }
+#endif
+            if (!matched) {
+                // Nested template argument lists are closed with "> >" and
+                // the parameters of function types are separated from their
+                // return type.
+                if ((name[i] == '>' && _last == '>') ||
+                    (name[i] == '(' && (_IsIdentifierChar(_last) ||
+                                        _last == '>' || _last == '*' ||
+                                        _last == '&'))) {
+                    _Emit(" ");
+                }
+                _Emit(name.substr(i, 1));
+                ++i;
+            }
+        }
+    }
+
+private:
+    static constexpr bool _IsIdentifierChar(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+               (c >= '0' && c <= '9') || c == '_';
+    }
+
+    // Returns the end of the type starting at i in name, which is followed
+    // by a declarator, a separator or the end of the enclosing list.
+    static constexpr size_t
+    _GetEndOfQualifiedType(std::string_view name, size_t i)
+    {
+        int nesting = 0;
+        for (; i < name.size(); ++i) {
+            const char c = name[i];
+            if (c == '<' || c == '(') {
+                ++nesting;
+            }
+            else if (c == '>' || c == ')') {
+                if (nesting-- == 0) {
+                    break;
+                }
+            }
+            else if (nesting == 0 && (c == '*' || c == '&' || c == ',')) {
+                break;
+            }
+        }
+        while (i > 0 && name[i - 1] == ' ') {
+            --i;
+        }
+        return i;
+    }
+
+    constexpr void _Emit(std::string_view str)
+    {
+        for (const char c : str) {
+            // Like ArchDemangle(), drop the spaces following a string.
+            if (c == ' ' && _afterString) {
+                continue;
+            }
+            _afterString = false;
+            if (_out) {
+                _out[_size] = c;
+            }
+            ++_size;
+            _last = c;
+        }
+    }
+
+    char* _out;
+    size_t _size = 0;
+    char _last = '\0';
+    bool _afterString = false;
+};
+
+/// \private
+template <typename T>
+constexpr std::string_view
+Arch_GetRawTypeName()
+{
+    // The type appears in the template argument list of this function's
+    // pretty name.
+    const std::string_view function(
+        __ARCH_PRETTY_FUNCTION__, sizeof(__ARCH_PRETTY_FUNCTION__) - 1);
+#if defined(ARCH_COMPILER_MSVC)
+    const std::string_view prefix = "Arch_GetRawTypeName<";
+    const size_t end = function.rfind(">(void)");
+#else
+    // gcc also lists the typedefs used in the signature after the type.
+    const std::string_view prefix = "T = ";
+    const size_t end = function.find(';') != std::string_view::npos ?
+        function.find(';') : function.rfind(']');
+#endif
+    const size_t begin = function.find(prefix);
+    if (begin == std::string_view::npos || end == std::string_view::npos ||
+        end < begin + prefix.size()) {
+        return std::string_view();
+    }
+    return function.substr(begin + prefix.size(),
+                           end - begin - prefix.size());
+}
+
+/// \private
+template <size_t Size>
+struct Arch_TypeNameBuffer {
+    char data[Size + 1];
+};
+
+/// \private
+template <size_t Size>
+constexpr Arch_TypeNameBuffer<Size>
+Arch_MakeTypeNameBuffer(std::string_view rawName)
+{
+    Arch_TypeNameBuffer<Size> buffer{};
+    Arch_TypeNameNormalizer(buffer.data).Append(rawName);
+    return buffer;
+}
+
+/// \private
+template <typename T>
+struct Arch_TypeName {
+    static constexpr std::string_view rawName = Arch_GetRawTypeName<T>();
+
+    static constexpr size_t size = [] {
+        Arch_TypeNameNormalizer normalizer(nullptr);
+        normalizer.Append(rawName);
+        return normalizer.GetSize();
+    }();
+
+    static constexpr Arch_TypeNameBuffer<size> buffer =
+        Arch_MakeTypeNameBuffer<size>(rawName);
+
+    static constexpr std::string_view value =
+        std::string_view(buffer.data, size);
+};
+
+/// Return the demangled name of type \c T, computed at compile time.
+///
+/// The name is extracted from the compiler's pretty function name and
+/// normalized to the form \c ArchGetDemangled() produces: \c std::string
+/// is written \c string, \c std:: prefixes are removed, qualifiers
+/// follow the type they apply to, anonymous namespaces, \c std::nullptr_t
+/// and function types are spelled like the demangler does.  Like
+/// \c typeid, top-level references and cv-qualifiers are ignored.  The
+/// result refers to static storage and costs nothing at runtime.
+///
+/// Compilers leave out defaulted template arguments from these names, so
+/// the result differs from \c ArchGetDemangled<T>() for types such as
+/// \c std::vector<int>, which is named \c vector<int> here.
+///
+/// \see ArchGetDemangled()
+template <typename T>
+constexpr std::string_view
+ArchGetTypeName() {
+    return Arch_TypeName<
+        std::remove_cv_t<std::remove_reference_t<T>>>::value;
+}
+
+/// Demangle \p mangled into the caller-provided \p buffer of \p size bytes.
+///
+/// \p mangled may be a symbol name (starting with \c _Z) or a type name as
+/// returned by \c std::type_info::name().  The result is NUL-terminated and
+/// is the plain demangled name, as produced by \c abi::__cxa_demangle(); it
+/// is not simplified the way \c ArchDemangle() simplifies type names.
+///
+/// Only the common subset of the Itanium C++ ABI is handled here: nested,
+/// local and template names, constructors, destructors, operators, ABI
+/// tags, lambdas, builtin, qualified, pointer, reference and function
+/// types, template parameters, argument packs, integral literals,
+/// substitutions, vtables, typeinfo, thunks and clone suffixes.  Pointers
+/// and references to functions, pack expansions that decorate a pack of
+/// other than one element and constructors and destructors of lambdas are
+/// not part of it.  Within that subset this function does not allocate,
+/// lock or throw and may be called from a signal handler.
+///
+/// If \p mangled is outside the subset or the result does not fit, \c false
+/// is returned and \p buffer holds an empty string.  If \p fallback is
+/// \c true, such names are instead demangled with the platform's full
+/// demangler, which allocates and is not async-safe.
+ARCH_API
+bool ArchDemangleToBuffer(const char* mangled, char* buffer, size_t size,
+                          bool fallback = false);
+
 /// \private
 ARCH_API
 void Arch_DemangleFunctionName(std::string* functionName);
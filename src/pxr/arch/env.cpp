@@ -7,9 +7,14 @@
 
 #include "./env.h"
 #include "./error.h"
+#include "./hash.h"
 
+#include <atomic>
+#include <cstring>
 #include <memory>
+#include <mutex>
 #include <regex>
+#include <vector>
 
 #if defined(ARCH_OS_WINDOWS)
 #include <Windows.h>
@@ -109,6 +114,228 @@ ArchExpandEnvironmentVariables(const std::string& value)
     return result;
 }
 
+namespace {
+
+// Immutable copy of the environment, indexed by an open addressing hash
+// table of ArchHash64 hashes.
+class _EnvSnapshot
+{
+public:
+    explicit _EnvSnapshot(char** env)
+    {
+        size_t numEntries = 0, storageSize = 0;
+        for (char** entry = env; entry && *entry; ++entry) {
+            ++numEntries;
+            storageSize += strlen(*entry);
+        }
+
+        // Keep the table at most half full.
+        size_t numSlots = 16;
+        while (numSlots < 2 * numEntries) {
+            numSlots *= 2;
+        }
+        _slots.resize(numSlots);
+        _storage.reset(new char[storageSize ? storageSize : 1]);
+
+        char* storage = _storage.get();
+        for (char** entry = env; entry && *entry; ++entry) {
+            const char* separator = strchr(*entry, '=');
+            if (!separator) {
+                continue;
+            }
+            const size_t length = strlen(*entry);
+            memcpy(storage, *entry, length);
+
+            const size_t nameLength = separator - *entry;
+            const std::string_view name(storage, nameLength);
+            const std::string_view value(
+                storage + nameLength + 1, length - nameLength - 1);
+            storage += length;
+
+            // Like getenv(), the first definition of a name wins.
+            const uint64_t hash = ArchHash64(name.data(), name.size());
+            _Slot* slot = _FindSlot(name, hash);
+            if (slot->name.data() == nullptr) {
+                *slot = {hash, name, value};
+            }
+        }
+    }
+
+    bool Find(std::string_view name, std::string_view* value) const
+    {
+        const _Slot* slot =
+            _FindSlot(name, ArchHash64(name.data(), name.size()));
+        if (slot->name.data() == nullptr) {
+            return false;
+        }
+        *value = slot->value;
+        return true;
+    }
+
+private:
+    struct _Slot {
+        uint64_t hash;
+        std::string_view name;
+        std::string_view value;
+    };
+
+    // Returns the slot holding name, or the empty slot it belongs in.
+    _Slot* _FindSlot(std::string_view name, uint64_t hash)
+    {
+        return const_cast<_Slot*>(
+            static_cast<const _EnvSnapshot*>(this)->_FindSlot(name, hash));
+    }
+
+    const _Slot* _FindSlot(std::string_view name, uint64_t hash) const
+    {
+        const size_t mask = _slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            const _Slot& slot = _slots[i];
+            if (slot.name.data() == nullptr ||
+                (slot.hash == hash && slot.name == name)) {
+                return &slot;
+            }
+        }
+    }
+
+    std::unique_ptr<char[]> _storage;
+    std::vector<_Slot> _slots;
+};
+
+std::atomic<const _EnvSnapshot*> _envSnapshot{nullptr};
+
+// Serializes building snapshots.
+std::mutex _envSnapshotMutex;
+
+const _EnvSnapshot*
+_PublishEnvSnapshot(bool replace)
+{
+    std::lock_guard<std::mutex> lock(_envSnapshotMutex);
+    const _EnvSnapshot* snapshot = _envSnapshot.load();
+    if (!snapshot || replace) {
+        // Replaced snapshots are intentionally leaked, readers may still
+        // be using them or the values they returned.
+        snapshot = new _EnvSnapshot(ArchEnviron());
+        _envSnapshot.store(snapshot, std::memory_order_release);
+    }
+    return snapshot;
+}
+
+const _EnvSnapshot&
+_GetEnvSnapshot()
+{
+    const _EnvSnapshot* snapshot =
+        _envSnapshot.load(std::memory_order_acquire);
+    return snapshot ? *snapshot : *_PublishEnvSnapshot(false);
+}
+
+// Expands the variable references in str with their values in env and
+// writes the result to out, or only computes its size if out is null.
+size_t
+_WriteExpandedEnvironmentVariables(std::string_view str,
+                                   const _EnvSnapshot& env, char* out)
+{
+#if defined(ARCH_OS_WINDOWS)
+    const std::string_view open = "%";
+    const char close = '%';
+#else
+    const std::string_view open = "${";
+    const char close = '}';
+#endif
+
+    size_t size = 0;
+    auto emit = [&size, out](std::string_view text) {
+        if (out) {
+            memcpy(out + size, text.data(), text.size());
+        }
+        size += text.size();
+    };
+
+    size_t pos = 0;
+    for (;;) {
+        const size_t start = str.find(open, pos);
+        if (start == std::string_view::npos) {
+            break;
+        }
+        const size_t nameStart = start + open.size();
+        const size_t nameEnd = str.find(close, nameStart);
+        if (nameEnd == std::string_view::npos) {
+            break;
+        }
+        if (nameEnd == nameStart) {
+            // Empty names are not references, look again past the opening.
+            emit(str.substr(pos, start + 1 - pos));
+            pos = start + 1;
+            continue;
+        }
+
+        std::string_view value;
+        env.Find(str.substr(nameStart, nameEnd - nameStart), &value);
+        emit(str.substr(pos, start - pos));
+        emit(value);
+        pos = nameEnd + 1;
+    }
+    emit(str.substr(pos));
+    return size;
+}
+
+void
+_ExpandEnvironmentVariables(std::string_view str, const _EnvSnapshot& env,
+                            std::string* result)
+{
+    result->resize(_WriteExpandedEnvironmentVariables(str, env, nullptr));
+    _WriteExpandedEnvironmentVariables(str, env, &(*result)[0]);
+}
+
+} // anonymous namespace
+
+bool
+ArchHasEnvCached(std::string_view name)
+{
+    std::string_view value;
+    return _GetEnvSnapshot().Find(name, &value);
+}
+
+std::string_view
+ArchGetEnvCached(std::string_view name)
+{
+    std::string_view value;
+    _GetEnvSnapshot().Find(name, &value);
+    return value;
+}
+
+void
+ArchRefreshEnvCache()
+{
+    _PublishEnvSnapshot(true);
+}
+
+std::string
+ArchExpandEnvironmentVariablesCached(std::string_view str)
+{
+    std::string result;
+    _ExpandEnvironmentVariables(str, _GetEnvSnapshot(), &result);
+    return result;
+}
+
+void
+ArchExpandEnvironmentVariablesCached(std::string_view str,
+                                     std::string* result)
+{
+    _ExpandEnvironmentVariables(str, _GetEnvSnapshot(), result);
+}
+
+std::vector<std::string>
+ArchExpandEnvironmentVariablesCached(const std::vector<std::string>& strs)
+{
+    const _EnvSnapshot& env = _GetEnvSnapshot();
+    std::vector<std::string> result(strs.size());
+    for (size_t i = 0; i != strs.size(); ++i) {
+        _ExpandEnvironmentVariables(strs[i], env, &result[i]);
+    }
+    return result;
+}
+
 char** ArchEnviron() {
 #if defined(ARCH_OS_DARWIN)
     return *_NSGetEnviron();
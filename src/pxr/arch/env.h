@@ -11,6 +11,8 @@
 #include "./api.h"
 
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace pxr {
 
@@ -42,6 +44,74 @@ ARCH_API
 std::string
 ArchExpandEnvironmentVariables(const std::string& str);
 
+/// Returns \c true if and only if the environment snapshot contains
+/// \c name.
+///
+/// \see ArchGetEnvCached()
+ARCH_API
+bool
+ArchHasEnvCached(std::string_view name);
+
+/// Gets a value identified by \c name from a snapshot of the environment.
+///
+/// The snapshot is an immutable hash table built from \c ArchEnviron() the
+/// first time it is needed.  Lookups do not lock or allocate and may be
+/// made from any number of threads.  The result refers to memory owned by
+/// the snapshot, which remains valid for the lifetime of the process.  An
+/// empty string view is returned if \c name is not in the snapshot.
+///
+/// Changes made to the environment after the snapshot was built are not
+/// visible until \c ArchRefreshEnvCache() is called.
+ARCH_API
+std::string_view
+ArchGetEnvCached(std::string_view name);
+
+/// Rebuilds the environment snapshot from the current environment.
+///
+/// The new snapshot is published atomically, threads looking up values
+/// concurrently see either the old or the new one.  Previous snapshots are
+/// never freed since the values returned from them must remain valid, so
+/// this should only be called when the environment is known to have
+/// changed.  Like \c ArchSetEnv(), this must be externally synchronized
+/// with changes to the environment.
+ARCH_API
+void
+ArchRefreshEnvCache();
+
+/// Expands environment variables in \c str using the environment snapshot.
+///
+/// References are written \c ${NAME}, or \c %NAME% on Windows, as for
+/// \c ArchExpandEnvironmentVariables(), and variables that are not set
+/// expand to nothing.  Unlike \c ArchExpandEnvironmentVariables(), \c str
+/// is scanned once: the values substituted are not searched for further
+/// references, and the result is written into a buffer sized up front, so
+/// the cost is linear in the size of the input and output.
+///
+/// \see ArchGetEnvCached()
+ARCH_API
+std::string
+ArchExpandEnvironmentVariablesCached(std::string_view str);
+
+/// Expands environment variables in \c str into \c result.
+///
+/// The capacity of \c result is reused, which avoids allocations when
+/// expanding many strings in turn.
+///
+/// \overload
+ARCH_API
+void
+ArchExpandEnvironmentVariablesCached(std::string_view str,
+                                     std::string* result);
+
+/// Expands environment variables in each of \c strs.
+///
+/// All strings are expanded against the same environment snapshot.
+///
+/// \overload
+ARCH_API
+std::vector<std::string>
+ArchExpandEnvironmentVariablesCached(const std::vector<std::string>& strs);
+
 /// Return an array of the environment variables.
 ARCH_API
 char**
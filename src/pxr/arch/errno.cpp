@@ -6,6 +6,7 @@
 // Modified by Jeremy Retailleau.
 
 #include "./errno.h"
+#include <atomic>
 #include <cerrno>
 #include <cstring>
 #if defined(ARCH_OS_WINDOWS)
@@ -14,14 +15,22 @@
 
 namespace pxr {
 
-std::string
-ArchStrerror()
-{
-    return ArchStrerror(errno);
-}
+namespace {
+
+// Messages are cached for the error codes below this value, which covers
+// every code defined on the supported platforms.
+constexpr int _numCachedErrors = 256;
+
+// The messages of the cached error codes, built on first use and never
+// destroyed.
+struct _ErrorTable {
+    std::string messages[_numCachedErrors];
+};
+
+std::atomic<const _ErrorTable*> _errorTable{nullptr};
 
 std::string
-ArchStrerror(int errorCode)
+_Strerror(int errorCode)
 {
     char msg_buf[256];
    
@@ -45,6 +54,67 @@ ArchStrerror(int errorCode)
     return msg_buf;
 }
 
+const _ErrorTable*
+_GetErrorTable()
+{
+    static const _ErrorTable* table = []() {
+        const int savedErrno = errno;
+        _ErrorTable* result = new _ErrorTable;
+        for (int i = 0; i != _numCachedErrors; ++i) {
+            result->messages[i] = _Strerror(i);
+        }
+        errno = savedErrno;
+        _errorTable.store(result, std::memory_order_release);
+        return result;
+    }();
+    return table;
+}
+
+} // anonymous namespace
+
+std::string
+ArchStrerror()
+{
+    return ArchStrerror(errno);
+}
+
+std::string
+ArchStrerror(int errorCode)
+{
+    return _Strerror(errorCode);
+}
+
+std::string_view
+ArchStrerrorView()
+{
+    return ArchStrerrorView(errno);
+}
+
+std::string_view
+ArchStrerrorView(int errorCode)
+{
+    if (errorCode >= 0 && errorCode < _numCachedErrors) {
+        return _GetErrorTable()->messages[errorCode];
+    }
+    return "Unknown error";
+}
+
+const char*
+ArchStrerrorSignalSafe(int errorCode)
+{
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 32))
+    // strerrordesc_np() returns static, untranslated strings.
+    return strerrordesc_np(errorCode);
+#else
+    const _ErrorTable* table = _errorTable.load(std::memory_order_acquire);
+    if (table && errorCode >= 0 && errorCode < _numCachedErrors) {
+        return table->messages[errorCode].c_str();
+    }
+    return nullptr;
+#endif
+}
+
 #if defined(ARCH_OS_WINDOWS)
 std::string ArchStrSysError(unsigned long errorCode)
 {
@@ -13,6 +13,7 @@
 
 #include "./api.h"
 #include <string>
+#include <string_view>
 
 namespace pxr {
 
@@ -29,6 +30,33 @@ ARCH_API std::string ArchStrerror();
 /// This function is thread-safe.
 ARCH_API std::string ArchStrerror(int errorCode);
 
+/// Return the error string for the current value of errno without
+/// allocating.
+///
+/// \overload
+ARCH_API std::string_view ArchStrerrorView();
+
+/// Return the error string for the specified value of errno without
+/// allocating.
+///
+/// The messages for all common error codes are looked up once, in the
+/// locale in effect at the time, and kept for the life of the process, so
+/// the result remains valid forever.  Codes outside that range give a
+/// generic message.  Use this in place of \c ArchStrerror() where errors
+/// may be frequent, e.g. in retry loops.
+///
+/// This function is thread-safe.
+ARCH_API std::string_view ArchStrerrorView(int errorCode);
+
+/// Return the error string for the specified value of errno, or \c NULL if
+/// none is available.
+///
+/// Unlike the other variants this is async-signal-safe, so it may be used
+/// in signal handlers and while crashing.  The message is not translated.
+/// Where the platform has no async-signal-safe lookup, the messages cached
+/// by \c ArchStrerrorView() are used if they were looked up before.
+ARCH_API const char* ArchStrerrorSignalSafe(int errorCode);
+
 #if defined(ARCH_OS_WINDOWS)
 /// Return the error string for the specified error code.
 ///
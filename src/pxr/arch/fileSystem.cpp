@@ -12,6 +12,7 @@
 #include "./error.h"
 #include "./export.h"
 #include "./hints.h"
+#include "./systemInfo.h"
 #include "./vsnprintf.h"
 
 #include <algorithm>
@@ -21,8 +22,15 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cerrno>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <fcntl.h>
 #include <sys/types.h>
@@ -46,6 +54,8 @@ using std::pair;
 using std::string;
 using std::set;
 
+void Arch_InitDeferredConfig();
+
 #if defined (ARCH_OS_WINDOWS)
 namespace {
 static inline HANDLE _FileToWinHANDLE(FILE *file)
@@ -721,11 +731,13 @@ ArchMakeTmpSubdir(const std::string& tmpdir,
     return retstr;
 }
 
-static const char* _TmpDir = 0;
+// The temporary directory is resolved on first use and published with a
+// compare-and-swap so readers never block.  A thread that loses the race
+// frees its copy and uses the winner's.
+static std::atomic<const char*> _TmpDir{nullptr};
 
-ARCH_HIDDEN
-void
-Arch_InitTmpDir()
+static char*
+_ComputeTmpDir()
 {
 #if defined(ARCH_OS_WINDOWS)
     wchar_t tmpPath[MAX_PATH];
@@ -734,34 +746,59 @@ Arch_InitTmpDir()
     int sizeOfPath = GetTempPathW(MAX_PATH - 1, tmpPath);
     if (sizeOfPath > MAX_PATH || sizeOfPath == 0) {
         ARCH_ERROR("Call to GetTempPath failed.");
-        _TmpDir = ".";
-        return;
+        return _strdup(".");
     }
 
     // Strip the trailing slash
     tmpPath[sizeOfPath-1] = 0;
-    _TmpDir = _strdup(ArchWindowsUtf16ToUtf8(tmpPath).c_str());
+    return _strdup(ArchWindowsUtf16ToUtf8(tmpPath).c_str());
 #else
     const std::string tmpdir = ArchGetEnv("TMPDIR");
     if (!tmpdir.empty()) {
-        // This function is not exposed in the header; it is only used during
-        // Arch_InitConfig. If this is called more than once when TMPDIR is
-        // set, the following call will leak a string.
-        _TmpDir = strdup(tmpdir.c_str());
-    } else {
+        return strdup(tmpdir.c_str());
+    }
 #if defined(ARCH_OS_DARWIN)
-        _TmpDir = "/tmp";
+    return strdup("/tmp");
 #else
-        _TmpDir = "/var/tmp";
+    return strdup("/var/tmp");
 #endif
-    }
 #endif
 }
 
+ARCH_HIDDEN
+void
+Arch_InitTmpDir()
+{
+    if (_TmpDir.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    char* tmpDir = _ComputeTmpDir();
+    const char* expected = nullptr;
+    if (!_TmpDir.compare_exchange_strong(expected, tmpDir,
+                                         std::memory_order_acq_rel)) {
+        free(tmpDir);
+    }
+}
+
+// Returns the temporary directory if it has been resolved, or nullptr.
+// Unlike ArchGetTmpDir() this never allocates, so it's safe while crashing.
+ARCH_HIDDEN
+const char*
+Arch_GetTmpDirIfResolved()
+{
+    return _TmpDir.load(std::memory_order_acquire);
+}
+
 const char *
 ArchGetTmpDir()
 {
-    return _TmpDir;
+    const char* tmpDir = _TmpDir.load(std::memory_order_acquire);
+    if (ARCH_UNLIKELY(!tmpDir)) {
+        Arch_InitDeferredConfig();
+        tmpDir = _TmpDir.load(std::memory_order_acquire);
+    }
+    return tmpDir;
 }
 
 void
@@ -817,6 +854,8 @@ Arch_MapFileImpl(FILE *file, std::string *errMsg)
                   MAP_PRIVATE, fileno(file), 0);
     Mapping ret(m == MAP_FAILED ? nullptr : static_cast<PtrType>(m),
                 Arch_Unmapper(length));
+    // The message lookup doesn't allocate, but copying it into errMsg may,
+    // so that's only done for callers that ask for it.
     if (!ret && errMsg) {
         int err = errno;
         if (err == EINVAL) {
@@ -825,7 +864,7 @@ Arch_MapFileImpl(FILE *file, std::string *errMsg)
             *errMsg = "system limit on mapped regions exceeded, "
                 "or out of memory";
         } else {
-            *errMsg = ArchStrerror();
+            *errMsg = ArchStrerrorView();
         }
     }
     return ret;
@@ -868,7 +907,7 @@ Arch_MapFileImpl(std::string const& path, std::string *errMsg)
     _UniqueFILE f(ArchOpenFile(path.c_str(), "rb"));
     if (!f) {
         if (errMsg) {
-            *errMsg = ArchStrerror();
+            *errMsg = ArchStrerrorView();
         }
         return Mapping();
     }
@@ -887,6 +926,376 @@ ArchMapFileReadWrite(std::string const& path, std::string *errMsg)
     return Arch_MapFileImpl<ArchMutableFileMapping>(path, errMsg);
 }
 
+namespace {
+
+// Identifies the contents of a file for the mapping cache.
+struct _FileKey {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    int64_t mtime = 0;
+    int64_t size = 0;
+
+    bool operator==(const _FileKey& other) const {
+        return device == other.device && inode == other.inode &&
+            mtime == other.mtime && size == other.size;
+    }
+    bool operator<(const _FileKey& other) const {
+        return std::tie(device, inode, mtime, size) <
+            std::tie(other.device, other.inode, other.mtime, other.size);
+    }
+};
+
+#if defined(ARCH_OS_WINDOWS)
+
+bool
+_GetFileKey(FILE *file, _FileKey *key)
+{
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(_FileToWinHANDLE(file), &info)) {
+        return false;
+    }
+    key->device = info.dwVolumeSerialNumber;
+    key->inode = (uint64_t(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    key->mtime = (int64_t(info.ftLastWriteTime.dwHighDateTime) << 32) |
+        info.ftLastWriteTime.dwLowDateTime;
+    key->size = (int64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    return true;
+}
+
+bool
+_GetPathKey(std::string const& path, _FileKey *key)
+{
+    // File indices are only available through a handle.
+    _UniqueFILE f(ArchOpenFile(path.c_str(), "rb"));
+    return f && _GetFileKey(f.get(), key);
+}
+
+#else
+
+void
+_GetStatKey(struct stat const& st, _FileKey *key)
+{
+    key->device = st.st_dev;
+    key->inode = st.st_ino;
+#if defined(ARCH_OS_DARWIN)
+    key->mtime = int64_t(st.st_mtimespec.tv_sec) * 1000000000 +
+        st.st_mtimespec.tv_nsec;
+#else
+    key->mtime = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    key->size = st.st_size;
+}
+
+bool
+_GetFileKey(FILE *file, _FileKey *key)
+{
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) {
+        return false;
+    }
+    _GetStatKey(st, key);
+    return true;
+}
+
+bool
+_GetPathKey(std::string const& path, _FileKey *key)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    _GetStatKey(st, key);
+    return true;
+}
+
+#endif
+
+// A mapping held by the cache.  An entry is either referenced, with a live
+// shared pointer tracked by weak, or idle and linked into the LRU list.
+struct _MappingEntry {
+    _FileKey key;
+    std::string path;
+    ArchConstFileMapping mapping;
+    std::weak_ptr<char const> shared;
+    // Number of shared pointer groups created for this entry still alive.
+    // This is briefly 2 when a new group is created before the deleter of
+    // the previous one has run.
+    size_t holders = 0;
+    bool stale = false;
+    // True while the entry is linked into the LRU list at lruPos.
+    bool idle = false;
+    std::list<_MappingEntry*>::iterator lruPos;
+};
+
+class _MappingCache
+{
+public:
+    ArchSharedFileMapping Acquire(std::string const& path,
+                                  std::string *errMsg);
+    void Release(_MappingEntry *entry);
+    ArchFileMappingCacheStats GetStats();
+    size_t GetBudget();
+    void SetBudget(size_t bytes);
+    void Flush();
+
+private:
+    using _Evicted = std::vector<std::unique_ptr<_MappingEntry>>;
+
+    ArchSharedFileMapping _Share(_MappingEntry *entry);
+    void _MarkStale(std::string const& path, _FileKey const& key,
+                    _Evicted *evicted);
+    void _Unlink(_MappingEntry *entry);
+    void _Evict(_MappingEntry *entry, _Evicted *evicted);
+    void _Trim(size_t budget, _Evicted *evicted);
+
+    std::mutex _mutex;
+    std::map<_FileKey, std::unique_ptr<_MappingEntry>> _entries;
+    std::unordered_map<std::string, _FileKey> _pathKeys;
+    // Idle entries, least recently used first.
+    std::list<_MappingEntry*> _lru;
+    size_t _budget = size_t(1) << 30;
+    ArchFileMappingCacheStats _stats;
+};
+
+_MappingCache&
+_GetMappingCache()
+{
+    // Leaked so mappings can be released during static destruction.
+    static _MappingCache* cache = new _MappingCache;
+    return *cache;
+}
+
+ArchSharedFileMapping
+_MappingCache::Acquire(std::string const& path, std::string *errMsg)
+{
+    _Evicted evicted;
+    _FileKey key;
+    if (_GetPathKey(path, &key)) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto i = _entries.find(key);
+        if (i != _entries.end()) {
+            ++_stats.hits;
+            _MarkStale(path, key, &evicted);
+            return _Share(i->second.get());
+        }
+    }
+
+    // Map the file.  Key on what was opened in case the file was replaced
+    // after the check above.
+    _UniqueFILE f(ArchOpenFile(path.c_str(), "rb"));
+    if (!f || !_GetFileKey(f.get(), &key)) {
+        if (errMsg) {
+            *errMsg = ArchStrerrorView();
+        }
+        return ArchSharedFileMapping();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto i = _entries.find(key);
+        if (i != _entries.end()) {
+            ++_stats.hits;
+            _MarkStale(path, key, &evicted);
+            return _Share(i->second.get());
+        }
+    }
+
+    // Map without holding the lock.  Another thread may map the same file
+    // concurrently, in which case the first one to be inserted wins.
+    ArchConstFileMapping mapping = ArchMapFileReadOnly(f.get(), errMsg);
+    if (!mapping) {
+        return ArchSharedFileMapping();
+    }
+    f.reset();
+
+    std::unique_ptr<_MappingEntry> entry(new _MappingEntry);
+    entry->key = key;
+    entry->path = path;
+    entry->mapping = std::move(mapping);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    ++_stats.misses;
+    _MarkStale(path, key, &evicted);
+    auto inserted = _entries.emplace(key, nullptr);
+    if (inserted.second) {
+        inserted.first->second = std::move(entry);
+        _stats.mappings += 1;
+        _stats.mappedBytes += ArchGetFileMappingLength(
+            inserted.first->second->mapping);
+    }
+    else {
+        // Lost the race; the redundant mapping is released on return.
+        evicted.push_back(std::move(entry));
+    }
+    return _Share(inserted.first->second.get());
+}
+
+ArchSharedFileMapping
+_MappingCache::_Share(_MappingEntry *entry)
+{
+    ArchSharedFileMapping shared = entry->shared.lock();
+    if (!shared) {
+        const size_t length = ArchGetFileMappingLength(entry->mapping);
+        shared = ArchSharedFileMapping(
+            entry->mapping.get(), Arch_SharedUnmapper(entry, length));
+        entry->shared = shared;
+        ++entry->holders;
+        if (entry->idle) {
+            _Unlink(entry);
+        }
+    }
+    return shared;
+}
+
+void
+_MappingCache::Release(_MappingEntry *entry)
+{
+    _Evicted evicted;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (--entry->holders != 0) {
+        return;
+    }
+    if (entry->stale) {
+        _Evict(entry, &evicted);
+        return;
+    }
+    entry->lruPos = _lru.insert(_lru.end(), entry);
+    entry->idle = true;
+    _stats.idleMappings += 1;
+    _stats.idleBytes += ArchGetFileMappingLength(entry->mapping);
+    _Trim(_budget, &evicted);
+}
+
+void
+_MappingCache::_MarkStale(
+    std::string const& path, _FileKey const& key, _Evicted *evicted)
+{
+    auto inserted = _pathKeys.emplace(path, key);
+    if (inserted.second || inserted.first->second == key) {
+        inserted.first->second = key;
+        return;
+    }
+
+    // The file at path was replaced.  Release the old mapping now if it's
+    // idle and as soon as it's released otherwise.
+    auto i = _entries.find(inserted.first->second);
+    inserted.first->second = key;
+    if (i != _entries.end() && i->second->path == path) {
+        _MappingEntry *entry = i->second.get();
+        if (entry->idle) {
+            _Unlink(entry);
+            _Evict(entry, evicted);
+        }
+        else {
+            entry->stale = true;
+        }
+    }
+}
+
+void
+_MappingCache::_Unlink(_MappingEntry *entry)
+{
+    _lru.erase(entry->lruPos);
+    entry->idle = false;
+    _stats.idleMappings -= 1;
+    _stats.idleBytes -= ArchGetFileMappingLength(entry->mapping);
+}
+
+void
+_MappingCache::_Evict(_MappingEntry *entry, _Evicted *evicted)
+{
+    auto p = _pathKeys.find(entry->path);
+    if (p != _pathKeys.end() && p->second == entry->key) {
+        _pathKeys.erase(p);
+    }
+    auto i = _entries.find(entry->key);
+    _stats.mappings -= 1;
+    _stats.mappedBytes -= ArchGetFileMappingLength(entry->mapping);
+    _stats.evictions += 1;
+    // Unmapped by the caller once the lock is released.
+    evicted->push_back(std::move(i->second));
+    _entries.erase(i);
+}
+
+void
+_MappingCache::_Trim(size_t budget, _Evicted *evicted)
+{
+    while (_stats.idleBytes > budget) {
+        _MappingEntry *entry = _lru.front();
+        _Unlink(entry);
+        _Evict(entry, evicted);
+    }
+}
+
+ArchFileMappingCacheStats
+_MappingCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
+
+size_t
+_MappingCache::GetBudget()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _budget;
+}
+
+void
+_MappingCache::SetBudget(size_t bytes)
+{
+    _Evicted evicted;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _budget = bytes;
+    _Trim(_budget, &evicted);
+}
+
+void
+_MappingCache::Flush()
+{
+    _Evicted evicted;
+    std::lock_guard<std::mutex> lock(_mutex);
+    _Trim(0, &evicted);
+}
+
+} // end anonymous namespace
+
+void
+Arch_SharedUnmapper::operator()(char const *) const
+{
+    _GetMappingCache().Release(static_cast<_MappingEntry*>(_entry));
+}
+
+ArchSharedFileMapping
+ArchMapFileReadOnlyShared(std::string const& path, std::string *errMsg)
+{
+    return _GetMappingCache().Acquire(path, errMsg);
+}
+
+ArchFileMappingCacheStats
+ArchGetFileMappingCacheStats()
+{
+    return _GetMappingCache().GetStats();
+}
+
+size_t
+ArchGetFileMappingCacheBudget()
+{
+    return _GetMappingCache().GetBudget();
+}
+
+void
+ArchSetFileMappingCacheBudget(size_t bytes)
+{
+    _GetMappingCache().SetBudget(bytes);
+}
+
+void
+ArchFlushFileMappingCache()
+{
+    _GetMappingCache().Flush();
+}
+
 ARCH_API
 void ArchMemAdvise(void const *addr, size_t len, ArchMemAdvice adv)
 {
@@ -910,10 +1319,12 @@ void ArchMemAdvise(void const *addr, size_t len, ArchMemAdvice adv)
     int rval = posix_madvise(reinterpret_cast<void *>(alignedAddrInt),
                              len + (addrInt - alignedAddrInt), adviceMap[adv]);
     if (rval != 0) {
+        const std::string_view message = ArchStrerrorView();
         fprintf(stderr, "failed call to posix_madvise(%zd, %zd)"
-                "ret=%d, errno=%d '%s'\n",
+                "ret=%d, errno=%d '%.*s'\n",
                 alignedAddrInt, len + (addrInt-alignedAddrInt),
-                rval, errno, ArchStrerror().c_str());
+                rval, errno, static_cast<int>(message.size()),
+                message.data());
     }
 #endif
 }
@@ -936,6 +1347,131 @@ ArchQueryMappedMemoryResidency(
     return false;
 }
 
+namespace {
+
+// The page aligned span covering [addr, addr + len).
+struct _PageSpan {
+    _PageSpan(void const *addr, size_t len)
+        : pageSize(static_cast<size_t>(ArchGetPageSize()))
+        , start(reinterpret_cast<uintptr_t>(addr) & ~(pageSize - 1))
+        , length(len + (reinterpret_cast<uintptr_t>(addr) - start))
+        , numPages((length + pageSize - 1) / pageSize) {}
+
+    void const *GetPage(size_t i) const {
+        return reinterpret_cast<void const *>(start + i * pageSize);
+    }
+
+    size_t pageSize;
+    uintptr_t start;
+    size_t length;
+    size_t numPages;
+};
+
+} // end anonymous namespace
+
+bool
+ArchGetMappedMemoryResidency(
+    void const *addr, size_t len, ArchMemoryResidency *result)
+{
+    *result = ArchMemoryResidency();
+    if (len == 0) {
+        result->residentRatio = 1.0;
+        return true;
+    }
+
+    const _PageSpan span(addr, len);
+    std::unique_ptr<unsigned char[]> pageMap(
+        new unsigned char[span.numPages]);
+    if (!ArchQueryMappedMemoryResidency(
+            span.GetPage(0), span.length, pageMap.get())) {
+        return false;
+    }
+
+    // Offsets are relative to addr, so the first page's run starts at 0 and
+    // the last one's is clipped to len.
+    const size_t head = span.length - len;
+    result->pages = span.numPages;
+    for (size_t i = 0; i != span.numPages; ++i) {
+        const bool resident = pageMap[i] & 1;
+        const size_t begin = i == 0 ? 0 : i * span.pageSize - head;
+        const size_t end = std::min((i + 1) * span.pageSize - head, len);
+        result->residentPages += resident;
+        if (result->runs.empty() || result->runs.back().resident != resident) {
+            result->runs.push_back({begin, end - begin, resident});
+        }
+        else {
+            result->runs.back().length += end - begin;
+        }
+    }
+    result->residentRatio =
+        static_cast<double>(result->residentPages) / result->pages;
+    return true;
+}
+
+double
+ArchEstimateMappedMemoryResidency(
+    void const *addr, size_t len, size_t maxSamples)
+{
+    if (len == 0) {
+        return 1.0;
+    }
+
+    const _PageSpan span(addr, len);
+    maxSamples = std::max(maxSamples, size_t(1));
+    if (span.numPages <= maxSamples) {
+        ArchMemoryResidency residency;
+        if (!ArchGetMappedMemoryResidency(addr, len, &residency)) {
+            return -1.0;
+        }
+        return residency.residentRatio;
+    }
+
+    // Examine the page in the middle of each of maxSamples equal strides.
+    const size_t stride = span.numPages / maxSamples;
+    size_t residentSamples = 0;
+    for (size_t i = 0; i != maxSamples; ++i) {
+        unsigned char resident;
+        if (!ArchQueryMappedMemoryResidency(
+                span.GetPage(i * stride + stride / 2), 1, &resident)) {
+            return -1.0;
+        }
+        residentSamples += resident & 1;
+    }
+    return static_cast<double>(residentSamples) / maxSamples;
+}
+
+std::vector<size_t>
+ArchOrderByResidency(ArchMemoryRange const *ranges, size_t count,
+                     bool prefetch, size_t maxSamples)
+{
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), size_t(0));
+
+    std::vector<double> ratios(count);
+    for (size_t i = 0; i != count; ++i) {
+        ratios[i] = ArchEstimateMappedMemoryResidency(
+            ranges[i].addr, ranges[i].len, maxSamples);
+        if (ratios[i] < 0.0) {
+            return order;
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(),
+                     [&ratios](size_t lhs, size_t rhs) {
+                         return ratios[lhs] > ratios[rhs];
+                     });
+
+    if (prefetch) {
+        for (size_t i : order) {
+            if (ratios[i] < 1.0) {
+                ArchMemAdvise(ranges[i].addr, ranges[i].len,
+                              ArchMemAdviceWillNeed);
+            }
+        }
+    }
+    return order;
+}
+
 int64_t
 ArchPRead(FILE *file, void *buffer, size_t count, int64_t offset)
 {
@@ -1375,10 +1911,12 @@ void ArchFileAdvise(
     int rval = posix_fadvise(fileno(file), offset, static_cast<off_t>(count),
                              adviceMap[adv]);
     if (rval != 0) {
+        const std::string_view message = ArchStrerrorView();
         fprintf(stderr, "failed call to posix_fadvise(%d, %zd, %zd)"
-                "ret=%d, errno=%d '%s'\n",
+                "ret=%d, errno=%d '%.*s'\n",
                 fileno(file), offset, static_cast<off_t>(count),
-                rval, errno, ArchStrerror().c_str());
+                rval, errno, static_cast<int>(message.size()),
+                message.data());
     }
 #endif
 }
@@ -18,6 +18,7 @@
 #include <cstdio>
 #include <string>
 #include <set>
+#include <vector>
 
 #include <fcntl.h>
 #include <sys/types.h>
@@ -187,7 +188,9 @@ ARCH_API bool ArchGetStatMode(const char *pathname, int *mode);
 /// specified as a location where files are kept between system reboots -
 /// see "man hier"). The returned string will not have a trailing slash.
 ///
-/// This routine is threadsafe and will not perform any memory allocations.
+/// The directory is resolved on the first call, or when the arch library is
+/// loaded if \c ARCH_EAGER_INIT is set.  This routine is threadsafe and
+/// will not perform any memory allocations after the first call.
 ARCH_API const char *ArchGetTmpDir();
 
 /// Make a temporary file name, in a system-determined temporary directory.
@@ -301,6 +304,85 @@ ARCH_API
 ArchMutableFileMapping
 ArchMapFileReadWrite(std::string const& path, std::string *errMsg=nullptr);
 
+// Helper 'deleter' for mappings shared through the file mapping cache.
+struct Arch_SharedUnmapper {
+    Arch_SharedUnmapper(void *entry, size_t length)
+        : _entry(entry), _length(length) {}
+    ARCH_API void operator()(char const *mapStart) const;
+    size_t GetLength() const { return _length; }
+private:
+    void *_entry;
+    size_t _length;
+};
+
+/// ArchSharedFileMapping is a std::shared_ptr<char const> to read-only
+/// mapped file contents owned by the process-wide file mapping cache.  See
+/// ArchMapFileReadOnlyShared().
+using ArchSharedFileMapping = std::shared_ptr<char const>;
+
+/// Return the length of an ArchSharedFileMapping, or 0 if \p m is null or
+/// was not returned by ArchMapFileReadOnlyShared().
+inline size_t
+ArchGetFileMappingLength(ArchSharedFileMapping const &m) {
+    Arch_SharedUnmapper const *d = std::get_deleter<Arch_SharedUnmapper>(m);
+    return d ? d->GetLength() : 0;
+}
+
+/// Return a shared reference to the read-only mapped contents of the file at
+/// \p path.  All callers asking for the same file get the same mapping, so a
+/// file is opened and mapped only once however many threads use it.  If
+/// mapping fails, return a null pointer and if errMsg is not null fill it with
+/// information about the failure.
+///
+/// Files are identified by device, inode, modification time and size, so a
+/// file reached through different paths or links shares one mapping, and a
+/// file that has been replaced or rewritten is mapped afresh.  Mappings of a
+/// path whose file was replaced are released as soon as they're no longer
+/// referenced.  Modifications that leave the modification time and size
+/// unchanged are not detected.
+///
+/// Mappings that are no longer referenced stay in the cache so they can be
+/// handed out again, and are unmapped in least recently used order when
+/// their total size exceeds ArchGetFileMappingCacheBudget().
+ARCH_API
+ArchSharedFileMapping
+ArchMapFileReadOnlyShared(std::string const& path,
+                          std::string *errMsg=nullptr);
+
+/// Statistics about the process-wide file mapping cache.
+struct ArchFileMappingCacheStats {
+    size_t mappings = 0;        ///< Mappings held by the cache.
+    size_t mappedBytes = 0;     ///< Total length of those mappings.
+    size_t idleMappings = 0;    ///< Mappings with no outstanding references.
+    size_t idleBytes = 0;       ///< Total length of the idle mappings.
+    size_t hits = 0;            ///< Requests satisfied by an existing mapping.
+    size_t misses = 0;          ///< Requests that mapped the file.
+    size_t evictions = 0;       ///< Idle mappings unmapped by the cache.
+};
+
+/// Return statistics about the file mapping cache.
+ARCH_API
+ArchFileMappingCacheStats
+ArchGetFileMappingCacheStats();
+
+/// Return the number of bytes of idle mappings the file mapping cache keeps
+/// before unmapping the least recently used ones.  The default is 1 GiB.
+ARCH_API
+size_t
+ArchGetFileMappingCacheBudget();
+
+/// Set the number of bytes of idle mappings the file mapping cache keeps,
+/// immediately unmapping idle mappings beyond it.  A budget of 0 unmaps
+/// mappings as soon as they're no longer referenced.
+ARCH_API
+void
+ArchSetFileMappingCacheBudget(size_t bytes);
+
+/// Unmap every idle mapping held by the file mapping cache.
+ARCH_API
+void
+ArchFlushFileMappingCache();
+
 enum ArchMemAdvice {
     ArchMemAdviceNormal,       // Treat range with default behavior.
     ArchMemAdviceWillNeed,     // OS may prefetch this range.
@@ -332,6 +414,70 @@ bool
 ArchQueryMappedMemoryResidency(
     void const *addr, size_t len, unsigned char *pageMap);
 
+/// A run of consecutive pages that are either all resident or all not.  The
+/// offset and length are in bytes from the start of the queried range and are
+/// clipped to it.
+struct ArchMemoryResidencyRun {
+    size_t offset;
+    size_t length;
+    bool resident;
+};
+
+/// Summary of the residency of a range of mapped memory.
+struct ArchMemoryResidency {
+    size_t pages = 0;           ///< Number of pages in the range.
+    size_t residentPages = 0;   ///< Number of those that are resident.
+    double residentRatio = 0.0; ///< residentPages / pages, or 1 if empty.
+    /// Runs of resident and non-resident pages covering the range in order.
+    std::vector<ArchMemoryResidencyRun> runs;
+};
+
+/// Fill \p result with a summary of the residency of the mapped virtual
+/// memory starting at \p addr for \p len bytes.  Unlike
+/// ArchQueryMappedMemoryResidency(), \p addr need not be page aligned; the
+/// pages overlapping the range are examined.  Return true on success and
+/// false in case of an error or if residency can't be queried on this
+/// platform.
+ARCH_API
+bool
+ArchGetMappedMemoryResidency(
+    void const *addr, size_t len, ArchMemoryResidency *result);
+
+/// Estimate the fraction of the pages of the mapped virtual memory starting
+/// at \p addr for \p len bytes that are resident, by examining at most
+/// \p maxSamples pages spread evenly over the range.  Ranges of at most
+/// \p maxSamples pages are examined exactly.  This keeps the cost bounded for
+/// huge mappings where a full page map would be large.  An empty range is
+/// reported as fully resident.  Return a negative
+/// value in case of an error or if residency can't be queried on this
+/// platform.
+ARCH_API
+double
+ArchEstimateMappedMemoryResidency(
+    void const *addr, size_t len, size_t maxSamples = 64);
+
+/// A range of mapped memory to be processed.
+struct ArchMemoryRange {
+    void const *addr;
+    size_t len;
+};
+
+/// Return the indices of the \p count ranges in \p ranges ordered so that
+/// ranges whose pages are resident come first, followed by the others in
+/// decreasing order of their resident fraction.  Ranges with the same
+/// fraction keep their relative order.  Each range is examined with
+/// ArchEstimateMappedMemoryResidency() using \p maxSamples.
+///
+/// If \p prefetch is true, the ranges that are not fully resident are passed
+/// to ArchMemAdvise() with ArchMemAdviceWillNeed, in the returned order, so
+/// the OS can read them in while the resident ranges are processed.  If
+/// residency can't be queried, the ranges are returned in their original
+/// order.
+ARCH_API
+std::vector<size_t>
+ArchOrderByResidency(ArchMemoryRange const *ranges, size_t count,
+                     bool prefetch = true, size_t maxSamples = 64);
+
 /// Read up to \p count bytes from \p offset in \p file into \p buffer.  The
 /// file position indicator for \p file is not changed.  Return the number of
 /// bytes read, or zero if at end of file.  Return -1 in case of an error, with
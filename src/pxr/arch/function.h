@@ -17,10 +17,279 @@
 
 #include "./api.h"
 #include "./functionLite.h"
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace pxr {
 
+/// \private
+/// Constant expression implementation of \c ArchGetPrettierFunctionName().
+class Arch_PrettierFunctionNameWriter
+{
+public:
+    /// Writes the prettier name to \p out, or only computes its size if
+    /// \p out is null.  Returns the size of the name, which is never larger
+    /// than \p prettyFunction.
+    static constexpr size_t
+    Write(std::string_view function, std::string_view prettyFunction,
+          char* out)
+    {
+        // Get the function signature and template list, respectively.
+        std::string_view signature = prettyFunction;
+        std::string_view templates;
+        const size_t with = prettyFunction.find(" [with ");
+        if (with != std::string_view::npos) {
+            signature = prettyFunction.substr(0, with);
+            templates = prettyFunction.substr(
+                with + 6, prettyFunction.size() - with - 7);
+        }
+
+        // Get just the function name.
+        const std::string_view functionName =
+            _GetFunctionName(function, signature);
+
+        // Get the types from the template list.
+        _TemplateList templateList;
+        _GetTemplateList(templates, &templateList);
+
+        // Keep the types that are in functionName, sorted by name.
+        _TemplateList filtered;
+        size_t pos = functionName.find('<');
+        while (pos != std::string_view::npos) {
+            const std::string_view identifier =
+                _GetNextIdentifier(functionName, pos);
+            if (!identifier.empty()) {
+                if (const _Template* entry = templateList.Find(identifier)) {
+                    if (!filtered.Find(identifier)) {
+                        filtered.Insert(*entry);
+                    }
+                }
+            }
+        }
+
+        // Construct the prettier function name.
+        size_t size = 0;
+        _Append(functionName, out, &size);
+        for (size_t i = 0; i != filtered.size; ++i) {
+            _Append(i == 0 ? " [with " : ", ", out, &size);
+            _Append(filtered.entries[i].name, out, &size);
+            _Append(" = ", out, &size);
+            _Append(filtered.entries[i].type, out, &size);
+        }
+        if (filtered.size) {
+            _Append("]", out, &size);
+        }
+        return size;
+    }
+
+private:
+    struct _Template {
+        std::string_view name;
+        std::string_view type;
+    };
+
+    // Template parameters sorted by name.
+    struct _TemplateList {
+        static constexpr size_t capacity = 32;
+
+        constexpr const _Template* Find(std::string_view name) const
+        {
+            for (size_t i = 0; i != size; ++i) {
+                if (entries[i].name == name) {
+                    return &entries[i];
+                }
+            }
+            return nullptr;
+        }
+
+        constexpr void Insert(const _Template& entry)
+        {
+            for (size_t i = 0; i != size; ++i) {
+                if (entries[i].name == entry.name) {
+                    entries[i].type = entry.type;
+                    return;
+                }
+            }
+            if (size == capacity) {
+                return;
+            }
+            size_t i = size++;
+            for (; i > 0 && entry.name < entries[i - 1].name; --i) {
+                entries[i] = entries[i - 1];
+            }
+            entries[i] = entry;
+        }
+
+        _Template entries[capacity] = {};
+        size_t size = 0;
+    };
+
+    static constexpr void
+    _Append(std::string_view str, char* out, size_t* size)
+    {
+        for (const char c : str) {
+            if (out) {
+                out[*size] = c;
+            }
+            ++*size;
+        }
+    }
+
+    // Returns the start of the type name in s that ends at i.
+    // For example, given:
+    //   s = "int Foo<A>::Bar<B, C>::Blah () [with A = int, B = float, C = bool]"
+    // and i = the position of "Blah" in s, then:
+    //   _GetStartOfName(s, i) --> the position of "Foo" in s.
+    static constexpr size_t
+    _GetStartOfName(std::string_view s, size_t i)
+    {
+        // Skip backwards until we find the start of the function name.  We
+        // do this by skipping over everything between matching '<' and '>'
+        // and then searching for a space.
+        i = s.find_last_of(" >", i);
+        while (i != std::string_view::npos && s[i] != ' ') {
+            int nestingDepth = 1;
+            while (nestingDepth && --i) {
+                if (s[i] == '>') {
+                    ++nestingDepth;
+                }
+                else if (s[i] == '<') {
+                    --nestingDepth;
+                }
+            }
+            i = s.find_last_of(" >", i);
+        }
+        return i == std::string_view::npos ? 0 : i + 1;
+    }
+
+    // Finds the real name of function in prettyFunction.  If function is
+    // free, it will just be function.  If function is a member, there will
+    // be a "::" preceding it in prettyFunction, and we can search backwards
+    // to find the class name.
+    //
+    // For example: _GetFunctionName("Bar", "int Foo<A>::Bar () [with A = int]")
+    // returns "Foo<A>::Bar"
+    //
+    // Note that this is full of heuristics that don't always work.
+    static constexpr std::string_view
+    _GetFunctionName(std::string_view function,
+                     std::string_view prettyFunction)
+    {
+        // First search to see if function is a member function.  If it's
+        // not, then we bail out early, returning function.
+        size_t functionStart = std::string_view::npos;
+        for (size_t i = prettyFunction.find(function);
+             i != std::string_view::npos;
+             i = prettyFunction.find(function, i + 1)) {
+            if (i >= 2 && prettyFunction.substr(i - 2, 2) == "::") {
+                functionStart = i - 2;
+                break;
+            }
+        }
+        if (functionStart == std::string_view::npos || functionStart == 0) {
+            return function;
+        }
+
+        // The +2 is because of the '::' preceding the name.
+        const size_t functionEnd = functionStart + function.size() + 2;
+
+        // Cut everything that's not part of the function name out.
+        const size_t i = _GetStartOfName(prettyFunction, functionStart);
+        return prettyFunction.substr(i, functionEnd - i);
+    }
+
+    // Splits a template list into name and type pairs.
+    // For example:
+    //   " A = int, B = float"
+    // becomes:
+    //   "A": "int", "B": "float"
+    // Note the leading space in the template list.
+    static constexpr void
+    _GetTemplateList(std::string_view templates, _TemplateList* result)
+    {
+        size_t typeEnd = templates.size();
+        size_t i = templates.rfind('=', typeEnd);
+        while (i != std::string_view::npos) {
+            const size_t typeStart = templates.find_first_not_of(" =", i);
+            const size_t nameEnd = templates.find_last_not_of(" =", i);
+            const size_t nameStart = _GetStartOfName(templates, nameEnd);
+            result->Insert({
+                templates.substr(nameStart, nameEnd + 1 - nameStart),
+                templates.substr(typeStart, typeEnd - typeStart)});
+            typeEnd = templates.find_last_not_of(" =,;", nameStart - 1) + 1;
+            i = templates.rfind('=', typeEnd);
+        }
+    }
+
+    // Finds the next template identifier in prettyFunction, starting from
+    // pos.  pos is updated for the next call to _GetNextIdentifier() and
+    // iteration should stop when pos is npos.
+    //
+    // For example: _GetNextIdentifier("Foo<A, B>::Bar", 0) returns "A".
+    //
+    // Note that Windows does not have template lists and directly embeds
+    // the types.  This only works on Windows to the extent that it parses
+    // the types somehow and tries to filter an empty list, yielding an
+    // empty list, which is the result we expect.
+    static constexpr std::string_view
+    _GetNextIdentifier(std::string_view prettyFunction, size_t& pos)
+    {
+        constexpr size_t npos = std::string_view::npos;
+
+        // Skip '<' or leading space.
+        const size_t first = prettyFunction.find_first_not_of("< ", pos);
+
+        // If we found nothing or '<' then this is probably operator< or <<.
+        if (first == npos || prettyFunction[first] == '<') {
+            pos = npos;
+            return std::string_view();
+        }
+
+        // Find the next separator, which should be a ',', unless we are on
+        // the last identifier, and then it should be a '>'.  Update pos to
+        // be just before the next identifier.
+        size_t last = prettyFunction.find_first_of(",>", first);
+        if (last == npos) {
+            pos = npos;
+            last = prettyFunction.find('>', first);
+            if (last == npos) {
+                last = prettyFunction.size();
+            }
+        }
+        else if (prettyFunction[last] == ',') {
+            // Skip ','.
+            pos = last + 1;
+        }
+        else {
+            // Skip to next template.
+            pos = prettyFunction.find('<', first);
+        }
+
+        return prettyFunction.substr(first, last - first);
+    }
+};
+
+/// \private
+template <size_t Capacity>
+struct Arch_PrettierFunctionName {
+    constexpr Arch_PrettierFunctionName(std::string_view function,
+                                        std::string_view prettyFunction)
+        : size(Arch_PrettierFunctionNameWriter::Write(
+              function, prettyFunction, nullptr))
+    {
+        Arch_PrettierFunctionNameWriter::Write(function, prettyFunction, data);
+    }
+
+    constexpr operator std::string_view() const
+    {
+        return std::string_view(data, size);
+    }
+
+    char data[Capacity] = {};
+    size_t size;
+};
+
 /// Return well formatted function name.
 ///
 /// This function assumes \c function is __ARCH_FUNCTION__ and
@@ -31,6 +300,35 @@ ARCH_API
 std::string ArchGetPrettierFunctionName(const std::string &function,
                                         const std::string &prettyFunction);
 
+/// Expands to the prettier name of the enclosing function, as a
+/// \c const \c std::string&.
+///
+/// The name is computed with \c ArchGetPrettierFunctionName() the first
+/// time each expansion of this macro is evaluated, and cached in a static
+/// for the following evaluations.  In templates, each instantiation has its
+/// own cache.
+#define ARCH_PRETTIER_FUNCTION_NAME                                          \
+    ([](const char* function, const char* prettyFunction)                   \
+         -> const std::string& {                                            \
+        static const std::string name =                                     \
+            ::pxr::ArchGetPrettierFunctionName(function, prettyFunction);   \
+        return name;                                                        \
+    }(__ARCH_FUNCTION__, __ARCH_PRETTY_FUNCTION__))
+
+/// Expands to the prettier name of the enclosing function as a constant
+/// expression.
+///
+/// The result is convertible to \c std::string_view and is the same name
+/// \c ARCH_PRETTIER_FUNCTION_NAME yields.  Assign it to a static constexpr
+/// variable to have it computed at compile time:
+///
+/// \code
+/// static constexpr auto name = ARCH_PRETTIER_FUNCTION_NAME_CONSTANT;
+/// \endcode
+#define ARCH_PRETTIER_FUNCTION_NAME_CONSTANT                                 \
+    (::pxr::Arch_PrettierFunctionName<sizeof(__ARCH_PRETTY_FUNCTION__)>(     \
+        __ARCH_FUNCTION__, __ARCH_PRETTY_FUNCTION__))
+
 }  // namespace pxr
 
 #endif // PXR_ARCH_FUNCTION_H
@@ -6,47 +6,78 @@
 // Modified by Jeremy Retailleau.
 
 #include "./attributes.h"
-#include "./stackTrace.h"
-#include "./systemInfo.h"
+
+#include <cstdlib>
+#include <cstring>
 
 namespace pxr {
 
 void Arch_InitDebuggerAttach();
+void Arch_InitProgramNameForErrors();
 void Arch_InitTmpDir();
 void Arch_SetAppLaunchTime();
-void Arch_ValidateAssumptions();
+void Arch_ValidateAssumptionsOnce();
 void Arch_InitTickTimer();
 
 namespace {
 
+// Returns true if ARCH_EAGER_INIT is set to something other than 0.
+bool
+_IsEagerInitEnabled()
+{
+    const char* value = getenv("ARCH_EAGER_INIT");
+    return value && value[0] && strcmp(value, "0") != 0;
+}
+
 ARCH_CONSTRUCTOR(Arch_InitConfig, 2, void)
 {
     // Initialize the application start time.  First so it's a close as
     // possible to the real start time.
     Arch_SetAppLaunchTime();
 
-    // Initialize the temp directory.  Early so other initialization
-    // functions can use it.
-    Arch_InitTmpDir();
+    // The temp directory, the program name for errors and the platform
+    // validations are initialized on first use so processes that never
+    // need them don't pay for them at load time (resolving the executable
+    // path in particular).  Setting ARCH_EAGER_INIT initializes them here
+    // instead, which is useful when debugging startup.
+    if (_IsEagerInitEnabled()) {
+        // Initialize the temp directory.  Early so other initialization
+        // functions can use it.
+        Arch_InitTmpDir();
 
-    // Initialize program name for errors.  Early for initialization
-    // error reporting.
-    ArchSetProgramNameForErrors(ArchGetExecutablePath().c_str());
+        // Initialize program name for errors.  Early for initialization
+        // error reporting.
+        Arch_InitProgramNameForErrors();
 
-    // Perform platform validations: these are very quick, lightweight
-    // checks.  The reason that we call this function here is that pretty
-    // much any program that uses anything from lib/tf will end up here
-    // at some point.  It is not so important that *every* program
-    // perform this check; what is important is that when we bring up a new
-    // architecture/compiler/build, the validation gets performed at some
-    // point, to alert us to any problems.
-    Arch_ValidateAssumptions();
+        // Perform platform validations: these are very quick, lightweight
+        // checks.  When initialized lazily they're performed the first
+        // time either of the above is.  It is not so important that *every*
+        // program perform this check; what is important is that when we
+        // bring up a new architecture/compiler/build, the validation gets
+        // performed at some point, to alert us to any problems.
+        Arch_ValidateAssumptionsOnce();
+    }
 
-    // Initialize the debugger interface.
+    // Initialize the debugger interface.  This only reads ARCH_DEBUGGER
+    // unless it's set, and must happen now so attaching later doesn't need
+    // the heap.
     Arch_InitDebuggerAttach();
 }
 
 }
 
-}  // namespace pxr
+/// \private
+/// Initializes what Arch_InitConfig() leaves to first use, unless it was
+/// done already.  The temp directory and the program name for errors are
+/// resolved together so that a crash, which can't resolve them, finds both
+/// once either was used.
+ARCH_HIDDEN
+void
+Arch_InitDeferredConfig()
+{
+    Arch_ValidateAssumptionsOnce();
+    Arch_InitTmpDir();
+    Arch_InitProgramNameForErrors();
+}
 
+}  // namespace pxr
@@ -0,0 +1,147 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include "./initializerProfile.h"
+#include "./attributes.h"
+#include "./env.h"
+#include "./symbols.h"
+#include "./timing.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace pxr {
+
+namespace {
+
+struct _Entry {
+    void (*function)();
+    std::string name;
+    std::string library;
+    int priority;
+    bool isDestructor;
+    uint64_t ticks;
+};
+
+enum _State { _Unknown, _Disabled, _Enabled };
+
+// These are constant initialized so they're usable from initializers that
+// run before this translation unit is dynamically initialized.
+std::atomic<int> _state{_Unknown};
+std::mutex _entriesMutex;
+
+// Leaked so it's still available to destructors run at teardown.
+std::vector<_Entry>* _entries = nullptr;
+
+bool
+_IsEnabled()
+{
+    int state = _state.load(std::memory_order_relaxed);
+    if (state == _Unknown) {
+        const std::string value = ArchGetEnv("ARCH_PROFILE_INITIALIZERS");
+        state = (!value.empty() && value != "0") ? _Enabled : _Disabled;
+        _state.store(state, std::memory_order_relaxed);
+    }
+    return state == _Enabled;
+}
+
+void
+_Record(void (*function)(), const char* name, int priority, bool isDestructor,
+        uint64_t ticks)
+{
+    _Entry entry{ function, name ? name : "", "", priority, isDestructor,
+                  ticks };
+
+    // Resolve the library now since it may be unloaded before the report.
+    std::string symbolName;
+    ArchGetAddressInfo(reinterpret_cast<void*>(function),
+                       &entry.library, nullptr, &symbolName, nullptr);
+    if (entry.name.empty()) {
+        entry.name = symbolName.empty() ? "<unknown>" : symbolName;
+    }
+
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+    if (!_entries) {
+        _entries = new std::vector<_Entry>;
+    }
+    _entries->push_back(std::move(entry));
+}
+
+}
+
+void
+Arch_RunInitializer(void (*function)(), const char* name,
+                    int priority, bool isDestructor)
+{
+    if (!_IsEnabled()) {
+        function();
+        return;
+    }
+
+    ArchIntervalTimer timer;
+    function();
+    const uint64_t ticks = timer.GetElapsedTicks();
+    _Record(function, name, priority, isDestructor, ticks);
+}
+
+bool
+ArchIsInitializerProfilingEnabled()
+{
+    return _IsEnabled();
+}
+
+std::vector<ArchInitializerTiming>
+ArchGetInitializerTimings()
+{
+    std::vector<ArchInitializerTiming> result;
+
+    std::lock_guard<std::mutex> lock(_entriesMutex);
+    if (_entries) {
+        result.reserve(_entries->size());
+        for (const _Entry& entry : *_entries) {
+            result.push_back({ entry.name, entry.library, entry.priority,
+                               entry.isDestructor,
+                               ArchTicksToNanoseconds(entry.ticks) });
+        }
+    }
+    return result;
+}
+
+void
+ArchPrintInitializerTimings(FILE* file)
+{
+    if (!_IsEnabled()) {
+        return;
+    }
+
+    const std::vector<ArchInitializerTiming> timings =
+        ArchGetInitializerTimings();
+
+    int64_t total = 0;
+    fprintf(file, "Initializer timings (%zu functions):\n", timings.size());
+    fprintf(file, "  %12s  %-11s %8s  %s\n",
+            "time (us)", "kind", "priority", "name [library]");
+    for (const ArchInitializerTiming& timing : timings) {
+        fprintf(file, "  %12.3f  %-11s %8d  %s [%s]\n",
+                timing.nanoseconds / 1e3,
+                timing.isDestructor ? "destructor" : "constructor",
+                timing.priority, timing.name.c_str(),
+                timing.library.c_str());
+        total += timing.nanoseconds;
+    }
+    fprintf(file, "  %12.3f  total\n", total / 1e3);
+    fflush(file);
+}
+
+// Report at exit.  This runs after the other destructors in this library, but
+// destructors in libraries unloaded later will not be included.
+ARCH_DESTRUCTOR(Arch_PrintInitializerTimingsAtExit, 1, void)
+{
+    ArchPrintInitializerTimings(stderr);
+}
+
+}  // namespace pxr
@@ -0,0 +1,64 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#ifndef PXR_ARCH_INITIALIZER_PROFILE_H
+#define PXR_ARCH_INITIALIZER_PROFILE_H
+
+/// \file arch/initializerProfile.h
+/// Startup-time profile of ARCH_CONSTRUCTOR and ARCH_DESTRUCTOR functions.
+///
+/// Profiling is enabled by setting the environment variable
+/// \c ARCH_PROFILE_INITIALIZERS to a value other than \c 0 before the
+/// program starts.  Every ARCH_CONSTRUCTOR and ARCH_DESTRUCTOR function is
+/// then timed with \c ArchIntervalTimer and the timings are written to
+/// \c stderr when the arch library is unloaded.  When profiling is disabled
+/// the only cost is one relaxed atomic load per function.
+
+#include "./api.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace pxr {
+
+/// The timing of one ARCH_CONSTRUCTOR or ARCH_DESTRUCTOR invocation.
+struct ArchInitializerTiming {
+    /// The name of the function.
+    std::string name;
+    /// The path of the library or executable containing the function.
+    std::string library;
+    /// The priority given to ARCH_CONSTRUCTOR or ARCH_DESTRUCTOR.
+    int priority;
+    /// \c true if the function is an ARCH_DESTRUCTOR.
+    bool isDestructor;
+    /// The time spent in the function.
+    int64_t nanoseconds;
+};
+
+/// Returns \c true if ARCH_CONSTRUCTOR and ARCH_DESTRUCTOR functions are
+/// being timed.
+ARCH_API
+bool ArchIsInitializerProfilingEnabled();
+
+/// Returns the timings recorded so far, in the order the functions ran.
+///
+/// Returns an empty vector if profiling is not enabled.
+ARCH_API
+std::vector<ArchInitializerTiming> ArchGetInitializerTimings();
+
+/// Writes the timings recorded so far to \p file, in the order the functions
+/// ran, followed by their total.
+///
+/// Nothing is written if profiling is not enabled.
+ARCH_API
+void ArchPrintInitializerTimings(FILE* file);
+
+}  // namespace pxr
+
+#endif // PXR_ARCH_INITIALIZER_PROFILE_H
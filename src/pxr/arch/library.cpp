@@ -7,6 +7,18 @@
 
 #include "./library.h"
 #include "./errno.h"
+#include "./fileSystem.h"
+#include "./hash.h"
+#include "./timing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 
 #if defined(ARCH_OS_WINDOWS)
 #include <Windows.h>
@@ -14,6 +26,11 @@
 #include <dlfcn.h>
 #endif
 
+#if defined(ARCH_OS_LINUX)
+#include <elf.h>
+#include <link.h>
+#endif
+
 namespace pxr {
 
 #if defined(ARCH_OS_WINDOWS)
@@ -22,6 +39,12 @@ DWORD arch_lastLibraryError = 0;
 }
 #endif
 
+#if defined(ARCH_OS_LINUX)
+void Arch_NotifyModulesChanged();
+void Arch_BeginModuleChanges();
+void Arch_EndModuleChanges();
+#endif
+
 void* ArchLibraryOpen(const std::string &filename, int flag)
 {
 #if defined(ARCH_OS_WINDOWS)
@@ -36,7 +59,13 @@ void* ArchLibraryOpen(const std::string &filename, int flag)
 #else
     // Clear any unchecked error first.
     (void)dlerror();
-    return dlopen(filename.c_str(), flag);
+    void* result = dlopen(filename.c_str(), flag);
+#if defined(ARCH_OS_LINUX)
+    if (result) {
+        Arch_NotifyModulesChanged();
+    }
+#endif
+    return result;
 #endif
 }
 
@@ -63,6 +92,11 @@ int ArchLibraryClose(void* handle)
     }
 #else
     int status = dlclose(handle);
+#if defined(ARCH_OS_LINUX)
+    if (status == 0) {
+        Arch_NotifyModulesChanged();
+    }
+#endif
 #endif
     return status;
 }
@@ -76,4 +110,609 @@ void* ArchLibraryGetSymbolAddress(void* handle, const char* name)
 #endif
 }
 
+namespace {
+
+#if defined(ARCH_OS_LINUX)
+
+// Looks up symbols defined by a loaded library in its dynamic symbol
+// table using the library's GNU or SysV hash table, the same way the
+// dynamic loader does but without searching any other object.
+class _ElfSymbolTable {
+public:
+    // Finds the tables for the library with the dlopen() handle \p handle.
+    // Returns false if they can't be found.
+    bool Init(void* handle)
+    {
+        struct link_map* map = nullptr;
+        if (dlinfo(handle, RTLD_DI_LINKMAP, &map) != 0 || !map || !map->l_ld) {
+            return false;
+        }
+
+        _base = map->l_addr;
+        for (const ElfW(Dyn)* dyn = map->l_ld; dyn->d_tag != DT_NULL; ++dyn) {
+            switch (dyn->d_tag) {
+            case DT_SYMTAB:
+                _symtab = reinterpret_cast<const ElfW(Sym)*>(
+                    _Rebase(dyn->d_un.d_ptr));
+                break;
+            case DT_STRTAB:
+                _strtab = reinterpret_cast<const char*>(
+                    _Rebase(dyn->d_un.d_ptr));
+                break;
+            case DT_GNU_HASH:
+                _gnuHash = reinterpret_cast<const uint32_t*>(
+                    _Rebase(dyn->d_un.d_ptr));
+                break;
+            case DT_HASH:
+                _sysvHash = reinterpret_cast<const ElfW(Word)*>(
+                    _Rebase(dyn->d_un.d_ptr));
+                break;
+            case DT_VERSYM:
+                _versym = reinterpret_cast<const ElfW(Half)*>(
+                    _Rebase(dyn->d_un.d_ptr));
+                break;
+            default:
+                break;
+            }
+        }
+        return _symtab && _strtab && (_gnuHash || _sysvHash);
+    }
+
+    // Returns true and sets \p address if \p name is defined by the
+    // library.  Returns false if it isn't or if it can only be resolved by
+    // the dynamic loader.
+    bool Find(const char* name, void** address) const
+    {
+        return _gnuHash ? _FindGnu(name, address) : _FindSysV(name, address);
+    }
+
+private:
+    // Most platforms relocate the pointers in the dynamic section in
+    // memory but some don't.
+    ElfW(Addr) _Rebase(ElfW(Addr) ptr) const
+    {
+        return ptr < _base ? ptr + _base : ptr;
+    }
+
+    // Returns true and sets \p address if symbol \p index is a usable
+    // default definition of \p name.
+    bool _Match(uint32_t index, const char* name, void** address) const
+    {
+        const ElfW(Sym)& sym = _symtab[index];
+        if (sym.st_shndx == SHN_UNDEF || sym.st_value == 0 ||
+            strcmp(name, _strtab + sym.st_name) != 0) {
+            return false;
+        }
+
+        // Skip local and hidden (non-default) versions.
+        if (_versym && ((_versym[index] & 0x7fff) == 0 ||
+                        (_versym[index] & 0x8000))) {
+            return false;
+        }
+
+        const unsigned char bind = ELF64_ST_BIND(sym.st_info);
+        if (bind != STB_GLOBAL && bind != STB_WEAK &&
+            bind != STB_GNU_UNIQUE) {
+            return false;
+        }
+
+        // Indirect functions and thread-local variables need the dynamic
+        // loader.
+        switch (ELF64_ST_TYPE(sym.st_info)) {
+        case STT_FUNC:
+        case STT_OBJECT:
+        case STT_NOTYPE:
+        case STT_COMMON:
+            *address = reinterpret_cast<void*>(_base + sym.st_value);
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool _FindGnu(const char* name, void** address) const
+    {
+        uint32_t hash = 5381;
+        for (const unsigned char* c =
+                 reinterpret_cast<const unsigned char*>(name); *c; ++c) {
+            hash = hash * 33 + *c;
+        }
+
+        const uint32_t numBuckets = _gnuHash[0];
+        const uint32_t symOffset  = _gnuHash[1];
+        const uint32_t bloomSize  = _gnuHash[2];
+        const uint32_t bloomShift = _gnuHash[3];
+        const ElfW(Addr)* bloom =
+            reinterpret_cast<const ElfW(Addr)*>(_gnuHash + 4);
+        const uint32_t* buckets =
+            reinterpret_cast<const uint32_t*>(bloom + bloomSize);
+        const uint32_t* chain = buckets + numBuckets;
+
+        // Check the bloom filter.
+        constexpr uint32_t bits = sizeof(ElfW(Addr)) * 8;
+        const ElfW(Addr) word = bloom[(hash / bits) % bloomSize];
+        const ElfW(Addr) mask = (ElfW(Addr)(1) << (hash % bits)) |
+                                (ElfW(Addr)(1) << ((hash >> bloomShift) % bits));
+        if ((word & mask) != mask) {
+            return false;
+        }
+
+        uint32_t index = buckets[hash % numBuckets];
+        if (index < symOffset) {
+            return false;
+        }
+        for (;; ++index) {
+            const uint32_t chainHash = chain[index - symOffset];
+            if ((hash | 1) == (chainHash | 1) &&
+                _Match(index, name, address)) {
+                return true;
+            }
+            if (chainHash & 1) {
+                return false;
+            }
+        }
+    }
+
+    bool _FindSysV(const char* name, void** address) const
+    {
+        uint32_t hash = 0;
+        for (const unsigned char* c =
+                 reinterpret_cast<const unsigned char*>(name); *c; ++c) {
+            hash = (hash << 4) + *c;
+            const uint32_t high = hash & 0xf0000000;
+            if (high) {
+                hash ^= high >> 24;
+            }
+            hash &= ~high;
+        }
+
+        const ElfW(Word) numBuckets = _sysvHash[0];
+        const ElfW(Word)* buckets = _sysvHash + 2;
+        const ElfW(Word)* chain = buckets + numBuckets;
+        for (ElfW(Word) index = buckets[hash % numBuckets];
+             index != STN_UNDEF; index = chain[index]) {
+            if (_Match(index, name, address)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    ElfW(Addr) _base = 0;
+    const ElfW(Sym)* _symtab = nullptr;
+    const char* _strtab = nullptr;
+    const uint32_t* _gnuHash = nullptr;
+    const ElfW(Word)* _sysvHash = nullptr;
+    const ElfW(Half)* _versym = nullptr;
+};
+
+#endif
+
+#if defined(ARCH_OS_LINUX)
+
+// Returns the file offset of the virtual address \p vaddr in the ELF file
+// with program headers \p phdrs, or 0 if it isn't in a loaded segment.
+ElfW(Off)
+_GetFileOffset(const ElfW(Phdr)* phdrs, size_t numPhdrs, ElfW(Addr) vaddr)
+{
+    for (size_t i = 0; i != numPhdrs; ++i) {
+        const ElfW(Phdr)& phdr = phdrs[i];
+        if (phdr.p_type == PT_LOAD && vaddr >= phdr.p_vaddr &&
+            vaddr < phdr.p_vaddr + phdr.p_filesz) {
+            return vaddr - phdr.p_vaddr + phdr.p_offset;
+        }
+    }
+    return 0;
+}
+
+// Reads the DT_NEEDED and DT_SONAME entries from the ELF file \p path.
+// Returns false if the file isn't an ELF shared object for this platform.
+bool
+_ReadDynamicEntries(const std::string& path,
+                    std::vector<std::string>* needed, std::string* soname)
+{
+    const ArchConstFileMapping mapping = ArchMapFileReadOnly(path);
+    if (!mapping) {
+        return false;
+    }
+    const char* data = mapping.get();
+    const size_t size = ArchGetFileMappingLength(mapping);
+
+    // Check the header.
+    if (size < sizeof(ElfW(Ehdr))) {
+        return false;
+    }
+    const ElfW(Ehdr)* ehdr = reinterpret_cast<const ElfW(Ehdr)*>(data);
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr->e_ident[EI_CLASS] != (sizeof(void*) == 8 ? ELFCLASS64
+                                                       : ELFCLASS32) ||
+        ehdr->e_phentsize != sizeof(ElfW(Phdr)) ||
+        ehdr->e_phoff > size ||
+        ehdr->e_phnum > (size - ehdr->e_phoff) / sizeof(ElfW(Phdr))) {
+        return false;
+    }
+    const ElfW(Phdr)* phdrs =
+        reinterpret_cast<const ElfW(Phdr)*>(data + ehdr->e_phoff);
+
+    // Find the dynamic section.
+    const ElfW(Dyn)* dyns = nullptr;
+    size_t numDyns = 0;
+    for (size_t i = 0; i != ehdr->e_phnum; ++i) {
+        if (phdrs[i].p_type == PT_DYNAMIC) {
+            if (phdrs[i].p_offset > size ||
+                phdrs[i].p_filesz > size - phdrs[i].p_offset) {
+                return false;
+            }
+            dyns = reinterpret_cast<const ElfW(Dyn)*>(
+                data + phdrs[i].p_offset);
+            numDyns = phdrs[i].p_filesz / sizeof(ElfW(Dyn));
+            break;
+        }
+    }
+    if (!dyns) {
+        return false;
+    }
+
+    // Find the string table.
+    ElfW(Off) strtab = 0;
+    ElfW(Xword) strsz = 0;
+    for (size_t i = 0; i != numDyns && dyns[i].d_tag != DT_NULL; ++i) {
+        if (dyns[i].d_tag == DT_STRTAB) {
+            strtab = _GetFileOffset(phdrs, ehdr->e_phnum, dyns[i].d_un.d_ptr);
+        }
+        else if (dyns[i].d_tag == DT_STRSZ) {
+            strsz = dyns[i].d_un.d_val;
+        }
+    }
+    if (strtab == 0 || strtab > size || strsz > size - strtab) {
+        return false;
+    }
+
+    const auto getString = [&](ElfW(Xword) offset) {
+        if (offset >= strsz) {
+            return std::string();
+        }
+        const char* str = data + strtab + offset;
+        return std::string(str, strnlen(str, strsz - offset));
+    };
+    for (size_t i = 0; i != numDyns && dyns[i].d_tag != DT_NULL; ++i) {
+        if (dyns[i].d_tag == DT_NEEDED) {
+            needed->push_back(getString(dyns[i].d_un.d_val));
+        }
+        else if (dyns[i].d_tag == DT_SONAME) {
+            *soname = getString(dyns[i].d_un.d_val);
+        }
+    }
+    return true;
+}
+
+#endif
+
+// Returns the file name of \p path.
+std::string
+_GetBaseName(const std::string& path)
+{
+#if defined(ARCH_OS_WINDOWS)
+    const std::string::size_type i = path.find_last_of("/\\");
+#else
+    const std::string::size_type i = path.rfind('/');
+#endif
+    return i == std::string::npos ? path : path.substr(i + 1);
+}
+
+// Asks the OS to start reading the file \p path.
+void
+_PrefetchFile(const std::string& path)
+{
+    if (FILE* file = ArchOpenFile(path.c_str(), "rb")) {
+        const int64_t length = ArchGetFileLength(file);
+        if (length > 0) {
+            ArchFileAdvise(file, 0, static_cast<size_t>(length),
+                           ArchFileAdviceWillNeed);
+        }
+        fclose(file);
+    }
+}
+
+// Assigns each library a batch such that every library it needs from
+// \p libraries is in an earlier batch.  Libraries in a dependency cycle
+// are put in a batch of their own after all others and flagged in
+// \p sequential.  Returns the number of batches.
+int
+_AssignBatches(std::vector<ArchPreloadedLibrary>* libraries,
+               const std::vector<std::string>& sonames,
+               std::vector<bool>* sequential)
+{
+    const size_t n = libraries->size();
+
+    // Map sonames and file names to libraries.
+    std::unordered_map<std::string, size_t> byName;
+    for (size_t i = 0; i != n; ++i) {
+        byName.emplace(_GetBaseName((*libraries)[i].path), i);
+        if (!sonames[i].empty()) {
+            byName.emplace(sonames[i], i);
+        }
+    }
+
+    // Find the dependencies within the set.
+    std::vector<std::vector<size_t>> dependents(n);
+    std::vector<size_t> numDependencies(n, 0);
+    for (size_t i = 0; i != n; ++i) {
+        for (const std::string& name : (*libraries)[i].needed) {
+            const auto j = byName.find(name);
+            if (j != byName.end() && j->second != i) {
+                dependents[j->second].push_back(i);
+                ++numDependencies[i];
+            }
+        }
+    }
+
+    // Peel off libraries with no remaining dependencies.
+    std::vector<size_t> ready;
+    for (size_t i = 0; i != n; ++i) {
+        if (numDependencies[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+    int batch = 0;
+    size_t numAssigned = 0;
+    while (!ready.empty()) {
+        std::vector<size_t> next;
+        for (size_t i : ready) {
+            (*libraries)[i].batch = batch;
+            ++numAssigned;
+            for (size_t j : dependents[i]) {
+                if (--numDependencies[j] == 0) {
+                    next.push_back(j);
+                }
+            }
+        }
+        ready.swap(next);
+        ++batch;
+    }
+
+    // Anything left is in a cycle.
+    sequential->assign(n, false);
+    if (numAssigned != n) {
+        for (size_t i = 0; i != n; ++i) {
+            if (numDependencies[i] != 0) {
+                (*libraries)[i].batch = batch;
+                (*sequential)[i] = true;
+            }
+        }
+        ++batch;
+    }
+    return batch;
+}
+
+// Loads \p library with ArchLibraryOpen and records the time it took.
+void
+_LoadLibrary(ArchPreloadedLibrary* library, int flag)
+{
+    ArchIntervalTimer timer;
+    library->handle = ArchLibraryOpen(library->path, flag);
+    library->nanoseconds = ArchTicksToNanoseconds(timer.GetElapsedTicks());
+    if (!library->handle) {
+        library->error = ArchLibraryError();
+        if (library->error.empty()) {
+            library->error = "unable to open " + library->path;
+        }
+    }
+}
+
+struct _NameHash {
+    size_t operator()(std::string_view name) const
+    {
+        return ArchHash64(name.data(), name.size());
+    }
+};
+
+}
+
+std::vector<ArchPreloadedLibrary>
+ArchPreloadLibraries(const std::vector<std::string>& paths, int flag,
+                     unsigned int maxThreads)
+{
+    const size_t n = paths.size();
+    std::vector<ArchPreloadedLibrary> libraries(n);
+    std::vector<std::string> sonames(n);
+
+    // Start reading all of the files before looking at any of them.
+    for (size_t i = 0; i != n; ++i) {
+        libraries[i].path = paths[i];
+        _PrefetchFile(paths[i]);
+    }
+
+#if defined(ARCH_OS_LINUX)
+    for (size_t i = 0; i != n; ++i) {
+        _ReadDynamicEntries(paths[i], &libraries[i].needed, &sonames[i]);
+    }
+#endif
+
+    std::vector<bool> sequential;
+    const int numBatches = _AssignBatches(&libraries, sonames, &sequential);
+
+    if (maxThreads == 0) {
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+#if defined(ARCH_OS_LINUX)
+    // Rebuild the module registry once for the whole set.
+    Arch_BeginModuleChanges();
+#endif
+
+    // Load each batch, concurrently where possible.
+    std::vector<ArchPreloadedLibrary*> batch;
+    for (int b = 0; b != numBatches; ++b) {
+        batch.clear();
+        for (size_t i = 0; i != n; ++i) {
+            if (libraries[i].batch == b) {
+                batch.push_back(&libraries[i]);
+            }
+        }
+
+        const size_t numThreads =
+            (!batch.empty() && sequential[batch.front() - libraries.data()])
+            ? 1 : std::min<size_t>(maxThreads, batch.size());
+        if (numThreads <= 1) {
+            for (ArchPreloadedLibrary* library : batch) {
+                _LoadLibrary(library, flag);
+            }
+            continue;
+        }
+
+        std::atomic<size_t> next(0);
+        const auto worker = [&]() {
+            for (size_t i = next++; i < batch.size(); i = next++) {
+                _LoadLibrary(batch[i], flag);
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i != numThreads; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+#if defined(ARCH_OS_LINUX)
+    Arch_EndModuleChanges();
+#endif
+
+    return libraries;
+}
+
+class ArchLibrary::_Impl {
+public:
+    _Impl(void* handle, unsigned int options) : _handle(handle)
+    {
+#if defined(ARCH_OS_LINUX)
+        _useSymbolTable =
+            (options & USE_SYMBOL_TABLE) && _symbolTable.Init(handle);
+#endif
+    }
+
+    ~_Impl()
+    {
+        ArchLibraryClose(_handle);
+    }
+
+    void* GetHandle() const
+    {
+        return _handle;
+    }
+
+    // Returns the address of \p name, looking it up if it's not cached.
+    // The caller must hold the mutex.
+    void* Resolve(const char* name)
+    {
+        // The cache is keyed by views of the names in _names so hits
+        // don't allocate.
+        const std::string_view key(name);
+        auto i = _cache.find(key);
+        if (i == _cache.end()) {
+            const std::string& stored = _names.emplace_back(key);
+            i = _cache.emplace(stored, _Lookup(name)).first;
+        }
+        return i->second;
+    }
+
+    std::mutex& GetMutex()
+    {
+        return _mutex;
+    }
+
+private:
+    void* _Lookup(const char* name) const
+    {
+#if defined(ARCH_OS_LINUX)
+        void* address;
+        if (_useSymbolTable && _symbolTable.Find(name, &address)) {
+            return address;
+        }
+#endif
+        return ArchLibraryGetSymbolAddress(_handle, name);
+    }
+
+    void* _handle;
+    std::mutex _mutex;
+    std::deque<std::string> _names;
+    std::unordered_map<std::string_view, void*, _NameHash> _cache;
+#if defined(ARCH_OS_LINUX)
+    _ElfSymbolTable _symbolTable;
+    bool _useSymbolTable = false;
+#endif
+};
+
+ArchLibrary::ArchLibrary(const std::string& filename, int flag,
+                         unsigned int options)
+{
+    if (void* handle = ArchLibraryOpen(filename, flag)) {
+        _impl.reset(new _Impl(handle, options));
+    }
+    else {
+        _error = ArchLibraryError();
+        if (_error.empty()) {
+            _error = "unable to open " + filename;
+        }
+    }
+}
+
+ArchLibrary::ArchLibrary() = default;
+
+ArchLibrary::ArchLibrary(ArchLibrary&&) noexcept = default;
+
+ArchLibrary&
+ArchLibrary::operator=(ArchLibrary&&) noexcept = default;
+
+ArchLibrary::~ArchLibrary() = default;
+
+ArchLibrary::operator bool() const
+{
+    return bool(_impl);
+}
+
+std::string
+ArchLibrary::GetError() const
+{
+    return _error;
+}
+
+void*
+ArchLibrary::GetHandle() const
+{
+    return _impl ? _impl->GetHandle() : nullptr;
+}
+
+void*
+ArchLibrary::GetSymbolAddress(const char* name) const
+{
+    if (!_impl) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_impl->GetMutex());
+    return _impl->Resolve(name);
+}
+
+size_t
+ArchLibrary::GetSymbolAddresses(const char* const* names, size_t count,
+                                void** addresses) const
+{
+    if (!_impl) {
+        std::fill(addresses, addresses + count, nullptr);
+        return 0;
+    }
+
+    size_t found = 0;
+    std::lock_guard<std::mutex> lock(_impl->GetMutex());
+    for (size_t i = 0; i != count; ++i) {
+        addresses[i] = _impl->Resolve(names[i]);
+        found += (addresses[i] != nullptr);
+    }
+    return found;
+}
+
 }  // namespace pxr
@@ -10,7 +10,11 @@
 
 #include "./api.h"
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 #if defined(ARCH_OS_WINDOWS)
 #   define ARCH_LIBRARY_LAZY    0
@@ -72,6 +76,109 @@ int ArchLibraryClose(void* handle);
 ARCH_API
 void* ArchLibraryGetSymbolAddress(void* handle, const char* name);
 
+/// The result of loading one library with \c ArchPreloadLibraries.
+struct ArchPreloadedLibrary {
+    /// The path of the library, as given.
+    std::string path;
+    /// The handle returned by \c ArchLibraryOpen, or \c nullptr if the
+    /// library could not be loaded.
+    void* handle = nullptr;
+    /// The reason the library could not be loaded, or empty.
+    std::string error;
+    /// The libraries this library needs (its \c DT_NEEDED entries).  This
+    /// is only available on Linux.
+    std::vector<std::string> needed;
+    /// The batch the library was loaded in.  Libraries in batch 0 need none
+    /// of the other libraries, and every library needed by a library in
+    /// batch \c n is in an earlier batch.
+    int batch = 0;
+    /// The time \c ArchLibraryOpen took.
+    int64_t nanoseconds = 0;
+};
+
+/// Load the libraries in \p paths with \c ArchLibraryOpen using \p flag.
+///
+/// Each library file is first prefetched with \c ArchFileAdvise and, on
+/// Linux, its \c DT_NEEDED entries are read to find which of the other
+/// libraries it needs.  The libraries are then loaded in batches such that
+/// each library is loaded after the libraries it needs, using up to
+/// \p maxThreads threads to load the libraries in a batch concurrently.  If
+/// \p maxThreads is zero the number of hardware threads is used.  Libraries
+/// that need each other are loaded in the last batch, one at a time.
+///
+/// Returns the result for each library in the order of \p paths.  The
+/// caller is responsible for closing the handles with \c ArchLibraryClose.
+ARCH_API
+std::vector<ArchPreloadedLibrary>
+ArchPreloadLibraries(const std::vector<std::string>& paths, int flag,
+                     unsigned int maxThreads = 0);
+
+/// \class ArchLibrary
+///
+/// A dynamic library opened with \c ArchLibraryOpen that caches symbol
+/// lookups.
+///
+/// Every name looked up, found or not, is cached so resolving it again
+/// doesn't search the library.  \c GetSymbolAddresses() resolves many
+/// names in one call, which suits plugin systems that resolve a list of
+/// entry points when loading a plugin.  The library is closed when this
+/// object is destroyed.  Lookups are thread-safe.
+///
+class ArchLibrary {
+public:
+    enum : unsigned int {
+        /// Look up symbols defined by the library itself in its ELF dynamic
+        /// symbol table, in memory, rather than with \c dlsym.  Names not
+        /// found there, including those defined in the library's
+        /// dependencies, and symbols that need the dynamic loader to
+        /// resolve (such as GNU indirect functions) still use \c dlsym.
+        /// This is ignored on platforms other than Linux.
+        USE_SYMBOL_TABLE = 1u
+    };
+
+    /// Create an empty library.
+    ARCH_API ArchLibrary();
+
+    ARCH_API ArchLibrary(ArchLibrary &&) noexcept;
+
+    /// Closes this library and takes over \p other.
+    ARCH_API ArchLibrary &operator=(ArchLibrary &&) noexcept;
+
+    /// Open the library \p filename with \c ArchLibraryOpen using \p flag
+    /// and the options in \p options.
+    ARCH_API ArchLibrary(const std::string& filename, int flag,
+                         unsigned int options = 0);
+
+    /// Destructor.  Closes the library.
+    ARCH_API ~ArchLibrary();
+
+    /// Returns \c true if the library is open.
+    ARCH_API explicit operator bool() const;
+
+    /// Returns the reason the library could not be opened or the empty
+    /// string if it's open.
+    ARCH_API std::string GetError() const;
+
+    /// Returns the handle returned by \c ArchLibraryOpen, or \c nullptr if
+    /// the library is not open.
+    ARCH_API void* GetHandle() const;
+
+    /// Returns the address of the symbol named \p name, or \c nullptr if
+    /// there is no such symbol or the library is not open.
+    ARCH_API void* GetSymbolAddress(const char* name) const;
+
+    /// Resolves the \p count symbols named in \p names, writing their
+    /// addresses to the corresponding elements of \p addresses.  Missing
+    /// symbols get \c nullptr.  Returns the number of symbols found.
+    ARCH_API size_t GetSymbolAddresses(const char* const* names, size_t count,
+                                       void** addresses) const;
+
+private:
+    class _Impl;
+    std::string _error;
+    std::unique_ptr<_Impl> _impl;
+};
+
 }  // namespace pxr
 
 #endif // PXR_ARCH_LIBRARY_H
@@ -0,0 +1,481 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include "./math.h"
+
+#if defined(ARCH_CPU_INTEL) && \
+    (defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64))
+#define ARCH_MATH_SSE2
+#include <emmintrin.h>
+#endif
+
+// Functions for instruction set extensions are selected at run time when
+// the compiler can target them individually.
+#if defined(ARCH_CPU_INTEL) && defined(ARCH_BITS_64) && \
+    (defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG))
+#define ARCH_MATH_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace pxr {
+
+namespace {
+
+// Double precision kernels.  The argument is reduced to r in [-pi/4, pi/4]
+// by subtracting k*pi/2 in three parts, each with enough trailing zero bits
+// that its product with k is exact, then sin(r) and cos(r) are evaluated
+// with the minimax polynomials of fdlibm's __kernel_sin and __kernel_cos.
+// The reduction is only exact for arguments below _maxDouble; larger or
+// non-finite arguments fall back to ArchSinCos().  Arguments below
+// _tinyDouble, whose sine rounds to the argument, are passed through so
+// the sign of zero is kept.
+constexpr double _maxDouble = 823549.0;     // ~2^19 * pi/2
+constexpr double _tinyDouble = 0x1p-27;
+constexpr double _twoOverPi = 6.36619772367581382433e-01;
+constexpr double _pio2_1 = 1.57079632673412561417e+00;
+constexpr double _pio2_2 = 6.07710050630396597660e-11;
+constexpr double _pio2_3 = 2.02226624871116645580e-21;
+
+constexpr double _s1 = -1.66666666666666324348e-01;
+constexpr double _s2 =  8.33333333332248946124e-03;
+constexpr double _s3 = -1.98412698298579493134e-04;
+constexpr double _s4 =  2.75573137070700676789e-06;
+constexpr double _s5 = -2.50507602534068634195e-08;
+constexpr double _s6 =  1.58969099521155010221e-10;
+
+constexpr double _c1 =  4.16666666666666019037e-02;
+constexpr double _c2 = -1.38888888888741095749e-03;
+constexpr double _c3 =  2.48015872894767294178e-05;
+constexpr double _c4 = -2.75573143513906633035e-07;
+constexpr double _c5 =  2.08757232129817482790e-09;
+constexpr double _c6 = -1.13596475577881948265e-11;
+
+// Single precision kernels.  The same scheme with the reduction constants
+// and polynomials of Cephes' sinf and cosf, exact below _maxFloat.
+constexpr float _maxFloat = 8192.0f;
+constexpr float _tinyFloat = 0x1p-12f;
+constexpr float _twoOverPif = 0.636619772367581343f;
+constexpr float _pio2_1f = 1.5703125f;
+constexpr float _pio2_2f = 4.837512969970703125e-4f;
+constexpr float _pio2_3f = 7.54978995489188216e-8f;
+
+constexpr float _s1f = -1.6666654611e-1f;
+constexpr float _s2f =  8.3321608736e-3f;
+constexpr float _s3f = -1.9515295891e-4f;
+
+constexpr float _c1f =  4.166664568298827e-2f;
+constexpr float _c2f = -1.388731625493765e-3f;
+constexpr float _c3f =  2.443315711809948e-5f;
+
+// Sets *s and *c to the sine and cosine of the reduced argument r of
+// quadrant k.
+template <class T>
+inline void
+_SelectQuadrant(int k, T sinr, T cosr, T* s, T* c)
+{
+    if (k & 1) {
+        const T t = sinr;
+        sinr = cosr;
+        cosr = -t;
+    }
+    if (k & 2) {
+        sinr = -sinr;
+        cosr = -cosr;
+    }
+    *s = sinr;
+    *c = cosr;
+}
+
+// Scalar versions of the kernels, used where SIMD isn't available and for
+// the elements that don't fill a vector.
+inline void
+_SinCos(double x, double* s, double* c)
+{
+    if (!(std::fabs(x) <= _maxDouble)) {
+        ArchSinCos(x, s, c);
+        return;
+    }
+    if (std::fabs(x) < _tinyDouble) {
+        *s = x;
+        *c = 1.0;
+        return;
+    }
+
+    const double k = std::nearbyint(x * _twoOverPi);
+    const double r = ((x - k * _pio2_1) - k * _pio2_2) - k * _pio2_3;
+    const double z = r * r;
+
+    const double sinr = r + r * z *
+        (_s1 + z * (_s2 + z * (_s3 + z * (_s4 + z * (_s5 + z * _s6)))));
+
+    const double hz = 0.5 * z;
+    const double w = 1.0 - hz;
+    const double cosr = w + (((1.0 - w) - hz) + z * z *
+        (_c1 + z * (_c2 + z * (_c3 + z * (_c4 + z * (_c5 + z * _c6))))));
+
+    _SelectQuadrant(static_cast<int>(k), sinr, cosr, s, c);
+}
+
+inline void
+_SinCosf(float x, float* s, float* c)
+{
+    if (!(std::fabs(x) <= _maxFloat)) {
+        ArchSinCosf(x, s, c);
+        return;
+    }
+    if (std::fabs(x) < _tinyFloat) {
+        *s = x;
+        *c = 1.0f;
+        return;
+    }
+
+    const float k = std::nearbyint(x * _twoOverPif);
+    const float r = ((x - k * _pio2_1f) - k * _pio2_2f) - k * _pio2_3f;
+    const float z = r * r;
+
+    const float sinr = r + r * z * (_s1f + z * (_s2f + z * _s3f));
+    const float cosr =
+        1.0f - 0.5f * z + z * z * (_c1f + z * (_c2f + z * _c3f));
+
+    _SelectQuadrant(static_cast<int>(k), sinr, cosr, s, c);
+}
+
+#if defined(ARCH_MATH_SSE2)
+
+// Returns masks selecting the lanes whose sine and cosine swap, and the
+// sign bits to apply to each, for the quadrants in the 32-bit lanes of k.
+inline void
+_GetQuadrantMasks(__m128i k, __m128i* swap, __m128i* sinSign,
+                  __m128i* cosSign)
+{
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    *swap = _mm_cmpeq_epi32(_mm_and_si128(k, one), one);
+    *sinSign = _mm_and_si128(k, two);
+    *cosSign = _mm_and_si128(_mm_add_epi32(k, one), two);
+}
+
+inline __m128d
+_Select(__m128d mask, __m128d a, __m128d b)
+{
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+inline __m128
+_Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Computes the sine and cosine of the two values at x.
+inline void
+_SinCos2(const double* x, double* s, double* c)
+{
+    const __m128d v = _mm_loadu_pd(x);
+    const __m128d absMask =
+        _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+    const __m128d absV = _mm_and_pd(v, absMask);
+    const __m128d inRange = _mm_cmple_pd(absV, _mm_set1_pd(_maxDouble));
+    const __m128d tiny = _mm_cmplt_pd(absV, _mm_set1_pd(_tinyDouble));
+
+    // Rounds to nearest in the default rounding mode.
+    const __m128i ki = _mm_cvtpd_epi32(_mm_mul_pd(v, _mm_set1_pd(_twoOverPi)));
+    const __m128d k = _mm_cvtepi32_pd(ki);
+
+    __m128d r = _mm_sub_pd(v, _mm_mul_pd(k, _mm_set1_pd(_pio2_1)));
+    r = _mm_sub_pd(r, _mm_mul_pd(k, _mm_set1_pd(_pio2_2)));
+    r = _mm_sub_pd(r, _mm_mul_pd(k, _mm_set1_pd(_pio2_3)));
+    const __m128d z = _mm_mul_pd(r, r);
+
+    __m128d p = _mm_set1_pd(_s6);
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(_s5));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(_s4));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(_s3));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(_s2));
+    p = _mm_add_pd(_mm_mul_pd(p, z), _mm_set1_pd(_s1));
+    const __m128d sinr = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, z), p));
+
+    __m128d q = _mm_set1_pd(_c6);
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(_c5));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(_c4));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(_c3));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(_c2));
+    q = _mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(_c1));
+    const __m128d oneV = _mm_set1_pd(1.0);
+    const __m128d hz = _mm_mul_pd(_mm_set1_pd(0.5), z);
+    const __m128d w = _mm_sub_pd(oneV, hz);
+    const __m128d cosr = _mm_add_pd(w, _mm_add_pd(
+        _mm_sub_pd(_mm_sub_pd(oneV, w), hz),
+        _mm_mul_pd(_mm_mul_pd(z, z), q)));
+
+    // Widen the 32-bit quadrant masks to the 64-bit lanes.
+    __m128i swap, sinSign, cosSign;
+    _GetQuadrantMasks(_mm_shuffle_epi32(ki, _MM_SHUFFLE(1, 1, 0, 0)),
+                      &swap, &sinSign, &cosSign);
+    const __m128d swapMask = _mm_castsi128_pd(swap);
+    const __m128d sinBits = _mm_castsi128_pd(_mm_slli_epi64(sinSign, 62));
+    const __m128d cosBits = _mm_castsi128_pd(_mm_slli_epi64(cosSign, 62));
+
+    const __m128d sinv = _mm_xor_pd(_Select(swapMask, cosr, sinr), sinBits);
+    const __m128d cosv = _mm_xor_pd(_Select(swapMask, sinr, cosr), cosBits);
+    _mm_storeu_pd(s, _Select(tiny, v, sinv));
+    _mm_storeu_pd(c, _Select(tiny, oneV, cosv));
+
+    // The stores may have overwritten x, so use the loaded values.
+    if (_mm_movemask_pd(inRange) != 0x3) {
+        double values[2];
+        _mm_storeu_pd(values, v);
+        for (int i = 0; i != 2; ++i) {
+            _SinCos(values[i], s + i, c + i);
+        }
+    }
+}
+
+// Computes the sine and cosine of the four values at x.
+inline void
+_SinCosf4(const float* x, float* s, float* c)
+{
+    const __m128 v = _mm_loadu_ps(x);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 absV = _mm_and_ps(v, absMask);
+    const __m128 inRange = _mm_cmple_ps(absV, _mm_set1_ps(_maxFloat));
+    const __m128 tiny = _mm_cmplt_ps(absV, _mm_set1_ps(_tinyFloat));
+
+    // Rounds to nearest in the default rounding mode.
+    const __m128i ki = _mm_cvtps_epi32(_mm_mul_ps(v, _mm_set1_ps(_twoOverPif)));
+    const __m128 k = _mm_cvtepi32_ps(ki);
+
+    __m128 r = _mm_sub_ps(v, _mm_mul_ps(k, _mm_set1_ps(_pio2_1f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(_pio2_2f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(k, _mm_set1_ps(_pio2_3f)));
+    const __m128 z = _mm_mul_ps(r, r);
+
+    __m128 p = _mm_set1_ps(_s3f);
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(_s2f));
+    p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(_s1f));
+    const __m128 sinr = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), p));
+
+    __m128 q = _mm_set1_ps(_c3f);
+    q = _mm_add_ps(_mm_mul_ps(q, z), _mm_set1_ps(_c2f));
+    q = _mm_add_ps(_mm_mul_ps(q, z), _mm_set1_ps(_c1f));
+    const __m128 oneV = _mm_set1_ps(1.0f);
+    const __m128 cosr = _mm_add_ps(
+        _mm_sub_ps(oneV, _mm_mul_ps(_mm_set1_ps(0.5f), z)),
+        _mm_mul_ps(_mm_mul_ps(z, z), q));
+
+    __m128i swap, sinSign, cosSign;
+    _GetQuadrantMasks(ki, &swap, &sinSign, &cosSign);
+    const __m128 swapMask = _mm_castsi128_ps(swap);
+    const __m128 sinBits = _mm_castsi128_ps(_mm_slli_epi32(sinSign, 30));
+    const __m128 cosBits = _mm_castsi128_ps(_mm_slli_epi32(cosSign, 30));
+
+    const __m128 sinv = _mm_xor_ps(_Select(swapMask, cosr, sinr), sinBits);
+    const __m128 cosv = _mm_xor_ps(_Select(swapMask, sinr, cosr), cosBits);
+    _mm_storeu_ps(s, _Select(tiny, v, sinv));
+    _mm_storeu_ps(c, _Select(tiny, oneV, cosv));
+
+    // The stores may have overwritten x, so use the loaded values.
+    if (_mm_movemask_ps(inRange) != 0xf) {
+        float values[4];
+        _mm_storeu_ps(values, v);
+        for (int i = 0; i != 4; ++i) {
+            _SinCosf(values[i], s + i, c + i);
+        }
+    }
+}
+
+#endif // defined(ARCH_MATH_SSE2)
+
+uint64_t
+_DepositBits(uint64_t x, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (x & bit) {
+            result |= mask & (~mask + 1);
+        }
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+uint64_t
+_ExtractBits(uint64_t x, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask; bit <<= 1) {
+        if (x & mask & (~mask + 1)) {
+            result |= bit;
+        }
+        mask &= mask - 1;
+    }
+    return result;
+}
+
+size_t
+_PopCount(const uint64_t* words, size_t count)
+{
+    size_t result = 0;
+    for (size_t i = 0; i != count; ++i) {
+        result += ArchPopCount(words[i]);
+    }
+    return result;
+}
+
+#if defined(ARCH_MATH_DISPATCH)
+
+// The instruction set extensions supported by the CPU.
+struct _CpuFeatures {
+    _CpuFeatures()
+    {
+        // This may run before the compiler's own initialization.
+        __builtin_cpu_init();
+        bmi2 = __builtin_cpu_supports("bmi2");
+        popcnt = __builtin_cpu_supports("popcnt");
+        avx2 = __builtin_cpu_supports("avx2");
+    }
+
+    bool bmi2;
+    bool popcnt;
+    bool avx2;
+};
+
+const _CpuFeatures&
+_GetCpuFeatures()
+{
+    static const _CpuFeatures features;
+    return features;
+}
+
+__attribute__((target("bmi2"))) uint64_t
+_DepositBitsBmi2(uint64_t x, uint64_t mask)
+{
+    return _pdep_u64(x, mask);
+}
+
+__attribute__((target("bmi2"))) uint64_t
+_ExtractBitsBmi2(uint64_t x, uint64_t mask)
+{
+    return _pext_u64(x, mask);
+}
+
+__attribute__((target("popcnt"))) size_t
+_PopCountPopcnt(const uint64_t* words, size_t count)
+{
+    size_t result = 0;
+    for (size_t i = 0; i != count; ++i) {
+        result += __builtin_popcountll(words[i]);
+    }
+    return result;
+}
+
+// Counts the bits of each nibble with a table lookup, 32 bytes at a time,
+// and sums the bytes of the counts with psadbw.
+__attribute__((target("avx2,popcnt"))) size_t
+_PopCountAvx2(const uint64_t* words, size_t count)
+{
+    const __m256i table = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowMask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i sums = zero;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256i v = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(words + i));
+        const __m256i low = _mm256_and_si256(v, lowMask);
+        const __m256i high =
+            _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+        const __m256i counts = _mm256_add_epi8(
+            _mm256_shuffle_epi8(table, low),
+            _mm256_shuffle_epi8(table, high));
+        sums = _mm256_add_epi64(sums, _mm256_sad_epu8(counts, zero));
+    }
+
+    size_t result =
+        static_cast<size_t>(_mm256_extract_epi64(sums, 0)) +
+        static_cast<size_t>(_mm256_extract_epi64(sums, 1)) +
+        static_cast<size_t>(_mm256_extract_epi64(sums, 2)) +
+        static_cast<size_t>(_mm256_extract_epi64(sums, 3));
+    for (; i != count; ++i) {
+        result += __builtin_popcountll(words[i]);
+    }
+    return result;
+}
+
+#endif // defined(ARCH_MATH_DISPATCH)
+
+} // anonymous namespace
+
+void
+ArchSinCos(const double* values, size_t count, double* sines, double* cosines)
+{
+    size_t i = 0;
+#if defined(ARCH_MATH_SSE2)
+    for (; i + 2 <= count; i += 2) {
+        _SinCos2(values + i, sines + i, cosines + i);
+    }
+#endif
+    for (; i != count; ++i) {
+        _SinCos(values[i], sines + i, cosines + i);
+    }
+}
+
+void
+ArchSinCosf(const float* values, size_t count, float* sines, float* cosines)
+{
+    size_t i = 0;
+#if defined(ARCH_MATH_SSE2)
+    for (; i + 4 <= count; i += 4) {
+        _SinCosf4(values + i, sines + i, cosines + i);
+    }
+#endif
+    for (; i != count; ++i) {
+        _SinCosf(values[i], sines + i, cosines + i);
+    }
+}
+
+uint64_t
+ArchDepositBits(uint64_t x, uint64_t mask)
+{
+#if defined(ARCH_MATH_DISPATCH)
+    if (_GetCpuFeatures().bmi2) {
+        return _DepositBitsBmi2(x, mask);
+    }
+#endif
+    return _DepositBits(x, mask);
+}
+
+uint64_t
+ArchExtractBits(uint64_t x, uint64_t mask)
+{
+#if defined(ARCH_MATH_DISPATCH)
+    if (_GetCpuFeatures().bmi2) {
+        return _ExtractBitsBmi2(x, mask);
+    }
+#endif
+    return _ExtractBits(x, mask);
+}
+
+size_t
+ArchPopCount(const uint64_t* words, size_t count)
+{
+#if defined(ARCH_MATH_DISPATCH)
+    const _CpuFeatures& features = _GetCpuFeatures();
+    if (features.avx2 && features.popcnt) {
+        return _PopCountAvx2(words, count);
+    }
+    if (features.popcnt) {
+        return _PopCountPopcnt(words, count);
+    }
+#endif
+    return _PopCount(words, count);
+}
+
+}  // namespace pxr
@@ -11,6 +11,7 @@
 /// \file arch/math.h
 /// Architecture-specific math function calls.
 
+#include "./api.h"
 #include "./defines.h"
 #include "./inttypes.h"
 
@@ -19,6 +20,7 @@
 #endif
 
 #include <cmath>
+#include <type_traits>
 #if !defined(M_PI)
 #define M_PI 3.14159265358979323846
 #endif
@@ -107,10 +109,48 @@ inline void ArchSinCos(double v, double *s, double *c) {
 #error Unknown architecture.
 #endif
 
+/// Computes the sine and cosine of each of the \p count values at
+/// \p values, storing them at the same index of \p sines and \p cosines.
+///
+/// This evaluates several values at once with SIMD polynomial
+/// approximations where available (SSE2), and the same approximations one
+/// value at a time elsewhere, so results don't depend on the position of
+/// a value in the array.  For arguments of magnitude up to 823549 the
+/// error is at most 2.5 ulp, or \c 2^-80 absolute for results smaller than
+/// \c 2^-30 in magnitude.  Larger and non-finite arguments are computed
+/// with the scalar \c ArchSinCos().  \p sines or \p cosines may be
+/// \p values to compute in place.
+ARCH_API
+void ArchSinCos(const double* values, size_t count,
+                double* sines, double* cosines);
+
+/// Computes the sine and cosine of each of the \p count values at
+/// \p values, storing them at the same index of \p sines and \p cosines.
+///
+/// This is the single precision counterpart of the array \c ArchSinCos().
+/// For arguments of magnitude up to 8192 the error is at most 2 ulp, or
+/// \c 2^-24 absolute for results smaller than \c 2^-12 in magnitude.
+/// Larger and non-finite arguments are computed with the scalar
+/// \c ArchSinCosf().  \p sines or \p cosines may be \p values to compute
+/// in place.
+ARCH_API
+void ArchSinCosf(const float* values, size_t count,
+                 float* sines, float* cosines);
+
+
+/// \def ARCH_BITS_CONSTEXPR
+/// Expands to \c constexpr for the bit manipulation functions below when
+/// the compiler's builtins can be evaluated at compile time, which is the
+/// case with GCC and Clang.
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+#define ARCH_BITS_CONSTEXPR constexpr
+#else
+#define ARCH_BITS_CONSTEXPR
+#endif
 
 /// Return the number of consecutive 0-bits in \p x starting from the least
 /// significant bit position.  If \p x is 0, the result is undefined.
-inline int
+ARCH_BITS_CONSTEXPR inline int
 ArchCountTrailingZeros(uint64_t x)
 {
 #if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
@@ -130,6 +170,136 @@ ArchCountTrailingZeros(uint64_t x)
 #endif
 }
 
+/// Return the number of consecutive 0-bits in \p x starting from the most
+/// significant bit position.  If \p x is 0, the result is undefined.
+ARCH_BITS_CONSTEXPR inline int
+ArchCountLeadingZeros(uint64_t x)
+{
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+    return __builtin_clzll(x);
+#elif defined(ARCH_COMPILER_MSVC)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - static_cast<int>(index);
+#else
+    int c = 0;
+    for (uint64_t bit = uint64_t(1) << 63; !(x & bit); bit >>= 1) {
+        ++c;
+    }
+    return c;
+#endif
+}
+
+/// Return the number of 1-bits in \p x.
+ARCH_BITS_CONSTEXPR inline int
+ArchPopCount(uint64_t x)
+{
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+    return __builtin_popcountll(x);
+#else
+    // Sum adjacent bits, then pairs, then nibbles, then all bytes at once.
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<int>((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+/// Return the total number of 1-bits in the \p count words at \p words.
+///
+/// This counts several words at once with SIMD instructions or the
+/// population count instruction when the CPU supports them, which is
+/// detected at run time.
+ARCH_API
+size_t ArchPopCount(const uint64_t* words, size_t count);
+
+/// Call \p fn with the index of each 1-bit in \p x, starting from the
+/// least significant bit.
+template <class Fn>
+inline void
+ArchForEachSetBit(uint64_t x, Fn&& fn)
+{
+    while (x) {
+        fn(ArchCountTrailingZeros(x));
+        // Clear the lowest 1-bit.
+        x &= x - 1;
+    }
+}
+
+/// Deposit the low bits of \p x into the positions of the 1-bits of
+/// \p mask, from least to most significant, clearing the other bits.
+///
+/// This is the BMI2 \c pdep instruction, which is used if the CPU supports
+/// it.  Note that some CPUs implement it in microcode.
+ARCH_API
+uint64_t ArchDepositBits(uint64_t x, uint64_t mask);
+
+/// Extract the bits of \p x at the positions of the 1-bits of \p mask and
+/// pack them into the low bits of the result.
+///
+/// This is the BMI2 \c pext instruction, which is used if the CPU supports
+/// it.  Note that some CPUs implement it in microcode.
+ARCH_API
+uint64_t ArchExtractBits(uint64_t x, uint64_t mask);
+
+/// Return \p x with the order of its bytes reversed.
+ARCH_BITS_CONSTEXPR inline uint16_t
+ArchByteSwap(uint16_t x)
+{
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+    return __builtin_bswap16(x);
+#elif defined(ARCH_COMPILER_MSVC)
+    return _byteswap_ushort(x);
+#else
+    return static_cast<uint16_t>((x >> 8) | (x << 8));
+#endif
+}
+
+/// \overload
+ARCH_BITS_CONSTEXPR inline uint32_t
+ArchByteSwap(uint32_t x)
+{
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+    return __builtin_bswap32(x);
+#elif defined(ARCH_COMPILER_MSVC)
+    return _byteswap_ulong(x);
+#else
+    return ((x >> 24) & 0x000000ffu) | ((x >> 8) & 0x0000ff00u) |
+        ((x << 8) & 0x00ff0000u) | ((x << 24) & 0xff000000u);
+#endif
+}
+
+/// \overload
+ARCH_BITS_CONSTEXPR inline uint64_t
+ArchByteSwap(uint64_t x)
+{
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+    return __builtin_bswap64(x);
+#elif defined(ARCH_COMPILER_MSVC)
+    return _byteswap_uint64(x);
+#else
+    return (static_cast<uint64_t>(ArchByteSwap(static_cast<uint32_t>(x)))
+            << 32) | ArchByteSwap(static_cast<uint32_t>(x >> 32));
+#endif
+}
+
+/// \overload
+///
+/// Accepts the other unsigned integer types of 2, 4 or 8 bytes, such as
+/// \c unsigned \c long \c long on LP64 Linux or \c size_t on macOS, which
+/// would otherwise be ambiguous between the fixed width overloads.
+template <class T, class = typename std::enable_if<
+    std::is_integral<T>::value && std::is_unsigned<T>::value &&
+    (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)>::type>
+ARCH_BITS_CONSTEXPR inline T
+ArchByteSwap(T x)
+{
+    using U = typename std::conditional<sizeof(T) == 2, uint16_t,
+        typename std::conditional<sizeof(T) == 4, uint32_t,
+                                  uint64_t>::type>::type;
+    return static_cast<T>(ArchByteSwap(static_cast<U>(x)));
+}
+
 }  // namespace pxr
 
 #endif // PXR_ARCH_MATH_H
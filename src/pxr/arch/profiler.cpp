@@ -0,0 +1,424 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include "./profiler.h"
+#include "./defines.h"
+#include "./demangle.h"
+#include "./stackTrace.h"
+#include "./symbols.h"
+#include "./vsnprintf.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(ARCH_OS_LINUX)
+#include <dirent.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace pxr {
+
+namespace {
+
+// Maximum number of frames kept per sample.
+constexpr size_t _MaxSampleDepth = 64;
+
+// Maximum number of frames belonging to the signal handler itself that we
+// are willing to search through to find the interrupted frame.
+constexpr size_t _MaxHandlerDepth = 8;
+
+struct _Sample {
+    std::atomic<bool> ready;
+    uint32_t depth;
+    uintptr_t frames[_MaxSampleDepth];
+};
+
+// Storage for a single profiling run.  The sample array is allocated when
+// the profiler is started and never resized, so the signal handler only has
+// to claim a slot with an atomic increment.
+struct _Profile {
+    explicit _Profile(size_t capacity)
+        : active(true)
+        , next(0)
+        , dropped(0)
+        , capacity(capacity)
+        , samples(new _Sample[capacity]())
+    {}
+
+    std::atomic<bool> active;
+    std::atomic<size_t> next;
+    std::atomic<size_t> dropped;
+    const size_t capacity;
+    std::unique_ptr<_Sample[]> samples;
+};
+
+std::atomic<_Profile*> _profile{nullptr};
+
+// Number of signal handlers currently executing.  Used to make sure no
+// handler still refers to a profile before it is stopped or released.
+std::atomic<int> _handlersInFlight{0};
+
+// Serializes starting, stopping and registering threads.
+std::mutex _controlMutex;
+
+#if defined(ARCH_OS_LINUX)
+
+void
+_WaitForHandlers()
+{
+    while (_handlersInFlight.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+// Timers armed by the current run, with the thread each one targets.  Only
+// accessed with _controlMutex held.
+std::vector<std::pair<pid_t, timer_t>> _timers;
+long _intervalNanoseconds = 0;
+
+uintptr_t
+_GetInterruptedPC(void* uctx)
+{
+    ucontext_t* context = static_cast<ucontext_t*>(uctx);
+#if defined(ARCH_CPU_INTEL) && defined(ARCH_BITS_64)
+    return static_cast<uintptr_t>(context->uc_mcontext.gregs[REG_RIP]);
+#elif defined(ARCH_CPU_ARM) && defined(ARCH_BITS_64)
+    return static_cast<uintptr_t>(context->uc_mcontext.pc);
+#else
+    return 0;
+#endif
+}
+
+void
+_SigProfHandler(int, siginfo_t*, void* uctx)
+{
+    const int savedErrno = errno;
+    _handlersInFlight.fetch_add(1);
+
+    _Profile* profile = _profile.load();
+    if (profile && profile->active.load(std::memory_order_relaxed)) {
+        const size_t index = profile->next.fetch_add(1);
+        if (index < profile->capacity) {
+            uintptr_t frames[_MaxSampleDepth + _MaxHandlerDepth];
+            size_t depth = ArchGetStackFrames(
+                _MaxSampleDepth + _MaxHandlerDepth, 0, frames);
+            depth = std::find(frames, frames + depth, 0) - frames;
+
+            // Drop the frames of this handler and of the signal trampoline
+            // by looking for the interrupted program counter.  If it cannot
+            // be found, keep everything rather than guessing.
+            size_t first = 0;
+            const uintptr_t pc = _GetInterruptedPC(uctx);
+            for (size_t i = 0; pc && i < std::min(depth, _MaxHandlerDepth);
+                 ++i) {
+                if (frames[i] == pc) {
+                    first = i;
+                    break;
+                }
+            }
+
+            _Sample& sample = profile->samples[index];
+            sample.depth = static_cast<uint32_t>(
+                std::min(depth - first, _MaxSampleDepth));
+            std::copy(frames + first, frames + first + sample.depth,
+                      sample.frames);
+            sample.ready.store(true, std::memory_order_release);
+        }
+        else {
+            profile->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    _handlersInFlight.fetch_sub(1);
+    errno = savedErrno;
+}
+
+pid_t
+_GetThreadId()
+{
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+// Returns the CPU-time clock of thread \p tid.  This is the same encoding
+// the kernel uses for pthread_getcpuclockid(), but it also works for
+// threads other than the calling one.
+clockid_t
+_GetThreadCPUClock(pid_t tid)
+{
+    const clockid_t perThread = 4;
+    const clockid_t sched = 2;
+    return static_cast<clockid_t>((~static_cast<unsigned>(tid)) << 3)
+        | perThread | sched;
+}
+
+// Arms a timer for thread \p tid.  _controlMutex must be held.
+bool
+_ArmThreadTimer(pid_t tid)
+{
+    for (const auto& entry : _timers) {
+        if (entry.first == tid) {
+            return true;
+        }
+    }
+
+    struct sigevent event = {};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event._sigev_un._tid = tid;
+
+    timer_t timer;
+    if (timer_create(_GetThreadCPUClock(tid), &event, &timer) != 0) {
+        return false;
+    }
+
+    struct itimerspec spec = {};
+    spec.it_interval.tv_sec = _intervalNanoseconds / 1000000000;
+    spec.it_interval.tv_nsec = _intervalNanoseconds % 1000000000;
+    spec.it_value = spec.it_interval;
+    if (timer_settime(timer, 0, &spec, nullptr) != 0) {
+        timer_delete(timer);
+        return false;
+    }
+
+    _timers.emplace_back(tid, timer);
+    return true;
+}
+
+bool
+_InstallHandler()
+{
+    static bool installed = false;
+    if (installed) {
+        return true;
+    }
+
+    struct sigaction act = {};
+    act.sa_sigaction = _SigProfHandler;
+    act.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&act.sa_mask);
+    if (sigaction(SIGPROF, &act, nullptr) != 0) {
+        return false;
+    }
+
+    installed = true;
+    return true;
+}
+
+#endif // defined(ARCH_OS_LINUX)
+
+// Returns the name to report for the frame at \p address.
+std::string
+_GetFrameName(uintptr_t address)
+{
+    std::string objectPath, symbolName;
+    if (ArchGetAddressInfo(reinterpret_cast<void*>(address),
+                           &objectPath, nullptr,
+                           &symbolName, nullptr)) {
+        if (!symbolName.empty()) {
+            Arch_DemangleFunctionName(&symbolName);
+            return symbolName;
+        }
+        if (!objectPath.empty()) {
+            // Merge all unnamed code of a module into a single frame, the
+            // offsets would keep otherwise identical stacks apart.
+            const std::string::size_type slash = objectPath.rfind('/');
+            return "[" + (slash == std::string::npos ?
+                objectPath : objectPath.substr(slash + 1)) + "]";
+        }
+    }
+    ArchFormatBuffer buffer;
+    buffer.Append("0x").AppendHex(address);
+    return buffer.GetString();
+}
+
+} // anonymous namespace
+
+bool
+ArchStartProfiler(int intervalMicroseconds, size_t maxSamples)
+{
+#if defined(ARCH_OS_LINUX)
+    if (intervalMicroseconds <= 0 || maxSamples == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(_controlMutex);
+
+    _Profile* current = _profile.load();
+    if (current && current->active.load()) {
+        return false;
+    }
+
+    if (!_InstallHandler()) {
+        return false;
+    }
+
+    // Unwinding for the first time may load and initialize the unwinder,
+    // which must not happen inside the signal handler.
+    uintptr_t frames[_MaxSampleDepth];
+    ArchGetStackFrames(_MaxSampleDepth, 0, frames);
+
+    // Publish the new profile and release the previous one once no handler
+    // can still be looking at it.
+    _profile.store(new _Profile(maxSamples));
+    _WaitForHandlers();
+    delete current;
+
+    _intervalNanoseconds = static_cast<long>(intervalMicroseconds) * 1000;
+
+    DIR* dir = opendir("/proc/self/task");
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            const pid_t tid = static_cast<pid_t>(atoi(entry->d_name));
+            if (tid > 0) {
+                // Threads may exit while we enumerate them, so failing to
+                // arm some of them is not an error.
+                _ArmThreadTimer(tid);
+            }
+        }
+        closedir(dir);
+    }
+    else {
+        _ArmThreadTimer(_GetThreadId());
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+ArchProfilerRegisterThread()
+{
+#if defined(ARCH_OS_LINUX)
+    std::lock_guard<std::mutex> lock(_controlMutex);
+
+    _Profile* profile = _profile.load();
+    if (!profile || !profile->active.load()) {
+        return false;
+    }
+    return _ArmThreadTimer(_GetThreadId());
+#else
+    return false;
+#endif
+}
+
+void
+ArchStopProfiler()
+{
+#if defined(ARCH_OS_LINUX)
+    std::lock_guard<std::mutex> lock(_controlMutex);
+
+    _Profile* profile = _profile.load();
+    if (!profile || !profile->active.load()) {
+        return;
+    }
+
+    profile->active.store(false);
+    for (const auto& entry : _timers) {
+        timer_delete(entry.second);
+    }
+    _timers.clear();
+
+    _WaitForHandlers();
+#endif
+}
+
+bool
+ArchIsProfilerRunning()
+{
+    _Profile* profile = _profile.load();
+    return profile && profile->active.load();
+}
+
+size_t
+ArchGetProfilerSampleCount()
+{
+    _Profile* profile = _profile.load();
+    if (!profile) {
+        return 0;
+    }
+    return std::min(profile->next.load(), profile->capacity);
+}
+
+size_t
+ArchGetProfilerDroppedSampleCount()
+{
+    _Profile* profile = _profile.load();
+    return profile ? profile->dropped.load() : 0;
+}
+
+void
+ArchWriteProfileFolded(std::ostream& out)
+{
+    std::lock_guard<std::mutex> lock(_controlMutex);
+
+    _Profile* profile = _profile.load();
+    if (!profile) {
+        return;
+    }
+
+    // Count identical raw stacks first so each unique address is only
+    // symbolized once.
+    std::map<std::vector<uintptr_t>, size_t> rawStacks;
+    const size_t numSamples = std::min(profile->next.load(), profile->capacity);
+    for (size_t i = 0; i != numSamples; ++i) {
+        const _Sample& sample = profile->samples[i];
+        if (!sample.ready.load(std::memory_order_acquire)) {
+            continue;
+        }
+        ++rawStacks[std::vector<uintptr_t>(
+            sample.frames, sample.frames + sample.depth)];
+    }
+
+    // Symbolize and merge stacks that only differ by the addresses within
+    // the same functions.
+    std::unordered_map<uintptr_t, std::string> names;
+    std::map<std::string, size_t> foldedStacks;
+    for (const auto& entry : rawStacks) {
+        const std::vector<uintptr_t>& frames = entry.first;
+
+        std::string folded;
+        for (size_t i = frames.size(); i-- != 0; ) {
+            // Every frame but the innermost holds a return address, which
+            // may belong to the next function if the call was the last
+            // instruction of the caller.
+            const uintptr_t address = i == 0 ? frames[i] : frames[i] - 1;
+
+            auto it = names.find(address);
+            if (it == names.end()) {
+                it = names.emplace(address, _GetFrameName(address)).first;
+            }
+            if (!folded.empty()) {
+                folded += ';';
+            }
+            folded += it->second;
+        }
+        foldedStacks[folded] += entry.second;
+    }
+
+    for (const auto& entry : foldedStacks) {
+        out << entry.first << ' ' << entry.second << '\n';
+    }
+}
+
+}  // namespace pxr
@@ -0,0 +1,90 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#ifndef PXR_ARCH_PROFILER_H
+#define PXR_ARCH_PROFILER_H
+
+/// \file arch/profiler.h
+/// Architecture-specific sampling CPU profiler.
+
+#include "./api.h"
+#include "./defines.h"
+
+#include <cstddef>
+#include <iosfwd>
+
+namespace pxr {
+
+/// Starts the built-in sampling CPU profiler.
+///
+/// A per-thread CPU-time timer is armed for every thread currently in the
+/// process.  Each time a thread has consumed \p intervalMicroseconds of CPU
+/// time it receives \c SIGPROF, and the signal handler records the
+/// interrupted call stack with \c ArchGetStackFrames() into a buffer
+/// preallocated here to hold \p maxSamples samples.  Samples taken once the
+/// buffer is full are dropped and counted.  Nothing is allocated, locked or
+/// symbolized on the sampling path.
+///
+/// Threads created after this call are not sampled unless they call
+/// \c ArchProfilerRegisterThread().  The profiler installs its own
+/// \c SIGPROF handler and leaves it installed after it is stopped.
+///
+/// Starting the profiler discards the samples of any previous run.  Returns
+/// \c false if the profiler is already running, if the arguments are not
+/// positive, or if sampling is not supported on this platform (currently
+/// only Linux is supported).
+ARCH_API
+bool ArchStartProfiler(int intervalMicroseconds = 1000,
+                       size_t maxSamples = 16384);
+
+/// Arms the profiler timer for the calling thread.
+///
+/// This should be called by threads started after \c ArchStartProfiler().
+/// Returns \c false if the profiler is not running or if the timer could not
+/// be created.  Calling this on a thread that is already sampled has no
+/// effect.
+ARCH_API
+bool ArchProfilerRegisterThread();
+
+/// Stops the sampling profiler.
+///
+/// All timers are deleted and this waits for signal handlers still in
+/// flight to finish.  The recorded samples are kept until the profiler is
+/// started again.
+ARCH_API
+void ArchStopProfiler();
+
+/// Returns \c true if the sampling profiler is running.
+ARCH_API
+bool ArchIsProfilerRunning();
+
+/// Returns the number of samples recorded by the current or last run.
+ARCH_API
+size_t ArchGetProfilerSampleCount();
+
+/// Returns the number of samples dropped because the sample buffer was full.
+ARCH_API
+size_t ArchGetProfilerDroppedSampleCount();
+
+/// Writes the recorded samples to \p out in folded-stack format.
+///
+/// Each line holds one unique call stack, outermost frame first, with the
+/// frames separated by \c ';' and followed by a space and the number of
+/// samples with that stack.  This is the input format of \c flamegraph.pl
+/// and is understood by most flame graph viewers.  Frames are symbolized
+/// here, on the calling thread, using \c ArchGetAddressInfo(); frames
+/// without a symbol name are written as the name of their module in
+/// brackets, or as a raw address if the module is unknown.
+///
+/// This should be called after \c ArchStopProfiler().  Calling it while the
+/// profiler is running only reports the samples completed so far.
+ARCH_API
+void ArchWriteProfileFolded(std::ostream& out);
+
+}  // namespace pxr
+
+#endif // PXR_ARCH_PROFILER_H
@@ -0,0 +1,144 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include "./signalSafeWriter.h"
+#include "./vsnprintf.h"
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(ARCH_OS_WINDOWS)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace pxr {
+
+namespace {
+
+// Strings up to this size are copied into the buffer, longer ones are
+// written from where they are.
+constexpr size_t _maxCopySize = 128;
+
+} // anonymous namespace
+
+ArchSignalSafeWriter::~ArchSignalSafeWriter()
+{
+    Flush();
+}
+
+ArchSignalSafeWriter&
+ArchSignalSafeWriter::Write(const char* text)
+{
+    if (text) {
+        Write(text, strlen(text));
+    }
+    return *this;
+}
+
+ArchSignalSafeWriter&
+ArchSignalSafeWriter::Write(const char* text, size_t size)
+{
+    if (size == 0) {
+        return *this;
+    }
+
+    if (size > _maxCopySize) {
+        if (_numSegments == MaxSegments) {
+            Flush();
+        }
+        _segments[_numSegments].iov_base = const_cast<char*>(text);
+        _segments[_numSegments].iov_len = size;
+        ++_numSegments;
+        return *this;
+    }
+
+    if (_used + size > BufferSize || _numSegments == MaxSegments) {
+        Flush();
+    }
+
+    // Extend the last segment if it ends where the copy goes.
+    char* const dst = _buffer + _used;
+    memcpy(dst, text, size);
+    _used += size;
+    if (_numSegments != 0 &&
+        static_cast<char*>(_segments[_numSegments - 1].iov_base) +
+            _segments[_numSegments - 1].iov_len == dst) {
+        _segments[_numSegments - 1].iov_len += size;
+    }
+    else {
+        _segments[_numSegments].iov_base = dst;
+        _segments[_numSegments].iov_len = size;
+        ++_numSegments;
+    }
+    return *this;
+}
+
+ArchSignalSafeWriter&
+ArchSignalSafeWriter::WriteDecimal(long long value, int width)
+{
+    char storage[_maxCopySize];
+    ArchFormatBuffer buffer(storage, sizeof(storage));
+    buffer.AppendDecimal(value, width);
+    return Write(buffer.GetData(), buffer.GetSize());
+}
+
+ArchSignalSafeWriter&
+ArchSignalSafeWriter::WriteHex(unsigned long long value, int minDigits)
+{
+    char storage[_maxCopySize];
+    ArchFormatBuffer buffer(storage, sizeof(storage));
+    buffer.AppendHex(value, minDigits);
+    return Write(buffer.GetData(), buffer.GetSize());
+}
+
+bool
+ArchSignalSafeWriter::Flush()
+{
+    const int savedErrno = errno;
+
+    _Segment* segment = _segments;
+    size_t remaining = _numSegments;
+    while (remaining) {
+#if defined(ARCH_OS_WINDOWS)
+        const int written = _write(_fd, segment->iov_base,
+                                   static_cast<unsigned>(segment->iov_len));
+#else
+        const ssize_t written = writev(_fd, segment,
+                                       static_cast<int>(remaining));
+#endif
+        if (written <= 0) {
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            _failed = true;
+            break;
+        }
+
+        // Skip what was written, which may end inside a segment.
+        size_t n = static_cast<size_t>(written);
+        while (remaining && n >= segment->iov_len) {
+            n -= segment->iov_len;
+            ++segment;
+            --remaining;
+        }
+        if (remaining) {
+            segment->iov_base = static_cast<char*>(segment->iov_base) + n;
+            segment->iov_len -= n;
+        }
+    }
+
+    const bool ok = !_failed;
+    _used = 0;
+    _numSegments = 0;
+    _failed = false;
+    errno = savedErrno;
+    return ok;
+}
+
+}  // namespace pxr
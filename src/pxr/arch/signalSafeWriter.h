@@ -0,0 +1,120 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#ifndef PXR_ARCH_SIGNAL_SAFE_WRITER_H
+#define PXR_ARCH_SIGNAL_SAFE_WRITER_H
+
+/// \file arch/signalSafeWriter.h
+/// Formatted output that is safe to use in signal handlers.
+
+#include "./api.h"
+#include "./defines.h"
+
+#include <stddef.h>
+
+#if !defined(ARCH_OS_WINDOWS)
+#include <sys/uio.h>
+#endif
+
+namespace pxr {
+
+/// \class ArchSignalSafeWriter
+///
+/// Collects text, decimal and hexadecimal numbers for a file descriptor
+/// and writes them with a single system call.
+///
+/// The writer neither allocates nor takes locks and only calls
+/// async-signal-safe functions, so it can be used in signal handlers and
+/// in a child process between \c fork() and \c exec().  For example,
+/// \code
+///  ArchSignalSafeWriter writer(2);
+///  writer.Write("FAIL: Crash handler died: signal=")
+///        .WriteDecimal(WTERMSIG(status)).Write('\n');
+/// \endcode
+///
+/// Short strings and numbers are copied into a fixed buffer inside the
+/// writer.  Longer strings are not copied, so they must remain valid until
+/// the next \c Flush().  Everything collected is written with one
+/// \c writev(2) call when \c Flush() is called or the writer is
+/// destroyed, which keeps each flushed line in one piece when several
+/// threads or processes write to the same file.  If the buffer fills up
+/// the writer flushes early.
+///
+/// Writes interrupted by signals are retried and \c errno is preserved.
+///
+class ArchSignalSafeWriter {
+public:
+    /// Size of the buffer holding copied text.
+    static constexpr size_t BufferSize = 1024;
+
+    /// Maximum number of pieces written by a single flush.
+    static constexpr size_t MaxSegments = 32;
+
+    /// Creates a writer for the file descriptor \p fd.
+    explicit ArchSignalSafeWriter(int fd)
+        : _fd(fd), _used(0), _numSegments(0), _failed(false)
+    {
+    }
+
+    ArchSignalSafeWriter(const ArchSignalSafeWriter&) = delete;
+    ArchSignalSafeWriter& operator=(const ArchSignalSafeWriter&) = delete;
+
+    /// Flushes anything not yet written.
+    ARCH_API
+    ~ArchSignalSafeWriter();
+
+    /// Collects the \p size characters at \p text.
+    ARCH_API
+    ArchSignalSafeWriter& Write(const char* text, size_t size);
+
+    /// Collects the null terminated \p text, which may be \c NULL.
+    ARCH_API
+    ArchSignalSafeWriter& Write(const char* text);
+
+    /// Collects the character \p c.
+    ArchSignalSafeWriter& Write(char c)
+    {
+        return Write(&c, 1);
+    }
+
+    /// Collects \p value in decimal, padded with spaces to \p width
+    /// characters.  A negative \p width pads on the right.
+    ARCH_API
+    ArchSignalSafeWriter& WriteDecimal(long long value, int width = 0);
+
+    /// Collects \p value in lowercase hexadecimal without a prefix, padded
+    /// with zeros to at least \p minDigits digits.
+    ARCH_API
+    ArchSignalSafeWriter& WriteHex(unsigned long long value,
+                                   int minDigits = 1);
+
+    /// Writes everything collected so far.  Returns \c false if any write
+    /// since the previous flush failed.
+    ARCH_API
+    bool Flush();
+
+private:
+#if defined(ARCH_OS_WINDOWS)
+    struct _Segment {
+        void* iov_base;
+        size_t iov_len;
+    };
+#else
+    using _Segment = struct iovec;
+#endif
+
+    int _fd;
+    size_t _used;
+    size_t _numSegments;
+    bool _failed;
+    _Segment _segments[MaxSegments];
+    char _buffer[BufferSize];
+};
+
+}  // namespace pxr
+
+#endif // PXR_ARCH_SIGNAL_SAFE_WRITER_H
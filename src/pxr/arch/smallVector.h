@@ -0,0 +1,437 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#ifndef PXR_ARCH_SMALL_VECTOR_H
+#define PXR_ARCH_SMALL_VECTOR_H
+
+/// \file arch/smallVector.h
+/// Vector with inline storage for a small number of elements.
+
+#if !defined(__cplusplus)
+#error This include file can only be included in C++ programs.
+#endif
+
+#include "./align.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pxr {
+
+/// \class ArchSmallVector
+///
+/// A contiguous sequence container that keeps up to \p N elements in storage
+/// embedded in the object and only moves them to the heap when it grows
+/// beyond that.
+///
+/// Both the inline and the heap storage are aligned to \p Alignment bytes,
+/// which defaults to \c alignof(T).  Passing \c ARCH_CACHE_LINE_SIZE gives
+/// cache-line aligned SIMD buffers that usually never touch the allocator:
+///
+/// \code
+/// ArchSmallVector<float, 16, ARCH_CACHE_LINE_SIZE> weights;
+/// \endcode
+///
+/// The interface follows \c std::vector.  As with \c std::vector, growing,
+/// inserting and erasing invalidate iterators; unlike it, moving a vector
+/// whose elements are inline moves the elements one by one, so iterators
+/// into the source are invalidated too.
+///
+template <class T, size_t N, size_t Alignment = alignof(T)>
+class ArchSmallVector
+{
+    static_assert(N > 0, "ArchSmallVector needs inline capacity");
+
+    using _Allocator = ArchAlignedAllocator<T, Alignment>;
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = T*;
+    using const_iterator = const T*;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    /// The number of elements stored without allocating.
+    static constexpr size_t inline_capacity = N;
+
+    /// The alignment in bytes of the element storage.
+    static constexpr size_t alignment = _Allocator::alignment;
+
+    ArchSmallVector() noexcept : _data(_GetInline()) {}
+
+    explicit ArchSmallVector(size_t count) : ArchSmallVector()
+    {
+        resize(count);
+    }
+
+    ArchSmallVector(size_t count, const T& value) : ArchSmallVector()
+    {
+        resize(count, value);
+    }
+
+    template <class InputIt, class = typename std::enable_if<
+        std::is_base_of<std::input_iterator_tag,
+            typename std::iterator_traits<InputIt>::iterator_category>::value
+        >::type>
+    ArchSmallVector(InputIt first, InputIt last) : ArchSmallVector()
+    {
+        assign(first, last);
+    }
+
+    ArchSmallVector(std::initializer_list<T> values) : ArchSmallVector()
+    {
+        assign(values.begin(), values.end());
+    }
+
+    ArchSmallVector(const ArchSmallVector& other) : ArchSmallVector()
+    {
+        assign(other.begin(), other.end());
+    }
+
+    ArchSmallVector(ArchSmallVector&& other)
+        noexcept(std::is_nothrow_move_constructible<T>::value)
+        : ArchSmallVector()
+    {
+        _MoveFrom(other);
+    }
+
+    ~ArchSmallVector()
+    {
+        clear();
+        _FreeHeap();
+    }
+
+    ArchSmallVector& operator=(const ArchSmallVector& other)
+    {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    ArchSmallVector& operator=(ArchSmallVector&& other)
+        noexcept(std::is_nothrow_move_constructible<T>::value)
+    {
+        if (this != &other) {
+            clear();
+            _FreeHeap();
+            _MoveFrom(other);
+        }
+        return *this;
+    }
+
+    ArchSmallVector& operator=(std::initializer_list<T> values)
+    {
+        assign(values.begin(), values.end());
+        return *this;
+    }
+
+    /// Replace the contents with copies of the elements in [first, last).
+    template <class InputIt>
+    void assign(InputIt first, InputIt last)
+    {
+        clear();
+        if (std::is_base_of<std::forward_iterator_tag,
+                typename std::iterator_traits<InputIt>::iterator_category>
+                ::value) {
+            reserve(static_cast<size_t>(std::distance(first, last)));
+        }
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+
+    iterator begin() noexcept { return _data; }
+    const_iterator begin() const noexcept { return _data; }
+    const_iterator cbegin() const noexcept { return _data; }
+    iterator end() noexcept { return _data + _size; }
+    const_iterator end() const noexcept { return _data + _size; }
+    const_iterator cend() const noexcept { return _data + _size; }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const noexcept {
+        return const_reverse_iterator(end());
+    }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const noexcept {
+        return const_reverse_iterator(begin());
+    }
+
+    T* data() noexcept { return _data; }
+    const T* data() const noexcept { return _data; }
+
+    size_t size() const noexcept { return _size; }
+    size_t capacity() const noexcept { return _capacity; }
+    bool empty() const noexcept { return _size == 0; }
+    static constexpr size_t max_size() noexcept {
+        return _Allocator::max_size();
+    }
+
+    /// Return true if the elements are held in the inline storage.
+    bool is_inline() const noexcept { return _data == _GetInline(); }
+
+    T& operator[](size_t i) { return _data[i]; }
+    const T& operator[](size_t i) const { return _data[i]; }
+    T& front() { return _data[0]; }
+    const T& front() const { return _data[0]; }
+    T& back() { return _data[_size - 1]; }
+    const T& back() const { return _data[_size - 1]; }
+
+    /// Ensure room for at least \p count elements without reallocating.
+    void reserve(size_t count)
+    {
+        if (count > _capacity) {
+            _Reallocate(count);
+        }
+    }
+
+    /// Move the elements back into the inline storage if they fit, or
+    /// otherwise into a heap block of exactly size() elements.
+    void shrink_to_fit()
+    {
+        if (!is_inline() && _size < _capacity) {
+            _Reallocate(_size);
+        }
+    }
+
+    void clear() noexcept
+    {
+        std::destroy(begin(), end());
+        _size = 0;
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args)
+    {
+        if (_size == _capacity) {
+            // Construct the new element before moving the old ones so that
+            // arguments referring to existing elements stay valid.
+            const size_t newCapacity = _GrowCapacity(_size + 1);
+            T* newData = _Allocate(newCapacity);
+            try {
+                ::new (static_cast<void*>(newData + _size))
+                    T(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                _Deallocate(newData, newCapacity);
+                throw;
+            }
+            try {
+                _Relocate(newData, newCapacity);
+            }
+            catch (...) {
+                newData[_size].~T();
+                _Deallocate(newData, newCapacity);
+                throw;
+            }
+        }
+        else {
+            ::new (static_cast<void*>(_data + _size))
+                T(std::forward<Args>(args)...);
+        }
+        return _data[_size++];
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    void pop_back()
+    {
+        _data[--_size].~T();
+    }
+
+    /// Insert \p value before \p pos and return an iterator to it.
+    template <class... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        const size_t index = static_cast<size_t>(pos - begin());
+        emplace_back(std::forward<Args>(args)...);
+        std::rotate(begin() + index, end() - 1, end());
+        return begin() + index;
+    }
+
+    iterator insert(const_iterator pos, const T& value)
+    {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, T&& value)
+    {
+        return emplace(pos, std::move(value));
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, pos + 1);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        iterator dst = begin() + (first - cbegin());
+        if (first != last) {
+            iterator newEnd = std::move(
+                begin() + (last - cbegin()), end(), dst);
+            std::destroy(newEnd, end());
+            _size = static_cast<size_t>(newEnd - begin());
+        }
+        return dst;
+    }
+
+    void resize(size_t count)
+    {
+        _Resize(count, [](T* p) { ::new (static_cast<void*>(p)) T(); });
+    }
+
+    void resize(size_t count, const T& value)
+    {
+        if (count > _capacity) {
+            // Copy the value first in case it is one of our elements.
+            const T copy(value);
+            reserve(count);
+            _Resize(count, [&copy](T* p) {
+                ::new (static_cast<void*>(p)) T(copy); });
+        }
+        else {
+            _Resize(count, [&value](T* p) {
+                ::new (static_cast<void*>(p)) T(value); });
+        }
+    }
+
+    friend bool operator==(const ArchSmallVector& lhs,
+                           const ArchSmallVector& rhs)
+    {
+        return lhs.size() == rhs.size() &&
+            std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+    friend bool operator!=(const ArchSmallVector& lhs,
+                           const ArchSmallVector& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+private:
+    T* _GetInline() noexcept
+    {
+        return std::launder(reinterpret_cast<T*>(_inline));
+    }
+
+    const T* _GetInline() const noexcept
+    {
+        return std::launder(reinterpret_cast<const T*>(_inline));
+    }
+
+    static T* _Allocate(size_t count)
+    {
+        return _Allocator().allocate(count);
+    }
+
+    static void _Deallocate(T* ptr, size_t count) noexcept
+    {
+        _Allocator().deallocate(ptr, count);
+    }
+
+    void _FreeHeap() noexcept
+    {
+        if (!is_inline()) {
+            _Deallocate(_data, _capacity);
+            _data = _GetInline();
+            _capacity = N;
+        }
+    }
+
+    size_t _GrowCapacity(size_t minCapacity) const
+    {
+        return std::max(minCapacity, _capacity + _capacity / 2);
+    }
+
+    // Move the elements to newData, which must already be allocated with
+    // newCapacity elements, and release the old storage.
+    void _Relocate(T* newData, size_t newCapacity)
+    {
+        if (newData != _data) {
+            std::uninitialized_move(begin(), end(), newData);
+            std::destroy(begin(), end());
+        }
+        if (!is_inline()) {
+            _Deallocate(_data, _capacity);
+        }
+        _data = newData;
+        _capacity = newCapacity;
+    }
+
+    void _Reallocate(size_t newCapacity)
+    {
+        if (newCapacity <= N) {
+            _Relocate(_GetInline(), N);
+            return;
+        }
+        T* newData = _Allocate(newCapacity);
+        try {
+            _Relocate(newData, newCapacity);
+        }
+        catch (...) {
+            _Deallocate(newData, newCapacity);
+            throw;
+        }
+    }
+
+    template <class Construct>
+    void _Resize(size_t count, Construct&& construct)
+    {
+        if (count < _size) {
+            std::destroy(begin() + count, end());
+            _size = count;
+            return;
+        }
+        if (count > _capacity) {
+            _Reallocate(_GrowCapacity(count));
+        }
+        for (; _size != count; ++_size) {
+            construct(_data + _size);
+        }
+    }
+
+    void _MoveFrom(ArchSmallVector& other)
+    {
+        if (other.is_inline()) {
+            std::uninitialized_move(other.begin(), other.end(), _data);
+            _size = other._size;
+            other.clear();
+        }
+        else {
+            _data = other._data;
+            _size = other._size;
+            _capacity = other._capacity;
+            other._data = other._GetInline();
+            other._size = 0;
+            other._capacity = N;
+        }
+    }
+
+private:
+    T* _data;
+    size_t _size = 0;
+    size_t _capacity = N;
+    alignas(alignment) unsigned char _inline[N * sizeof(T)];
+};
+
+}  // namespace pxr
+
+#endif  // PXR_ARCH_SMALL_VECTOR_H
@@ -8,6 +8,7 @@
 #include "./defines.h"
 #include "./stackTrace.h"
 #include "./attributes.h"
+#include "./crashRecord.h"
 #include "./debugger.h"
 #include "./defines.h"
 #include "./demangle.h"
@@ -21,8 +22,11 @@
 #include <Winsock2.h>
 #endif
 #include "./fileSystem.h"
+#include "./hints.h"
 #include "./inttypes.h"
+#include "./signalSafeWriter.h"
 #include "./symbols.h"
+#include "./systemInfo.h"
 #include "./vsnprintf.h"
 #if defined(ARCH_OS_WINDOWS)
 #include <io.h>
@@ -59,7 +63,12 @@
    needs some work, this has been stubbed out for now.  */
 
 #if defined(ARCH_OS_LINUX)
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <sched.h>
 #include <ucontext.h>
+#include <sys/syscall.h>
 #endif
 
 #if defined(ARCH_OS_LINUX) && defined(ARCH_BITS_64)
@@ -86,6 +95,14 @@ namespace pxr {
 
 using namespace std;
 
+void Arch_InitDeferredConfig();
+const char* Arch_GetTmpDirIfResolved();
+#if defined(ARCH_OS_LINUX)
+bool Arch_VisitLoadedModules(
+    bool (*visitor)(const ArchModuleInfo&, const std::string&, void*),
+    void* data);
+#endif
+
 #define MAX_STACK_DEPTH 4096
 
 #if !defined(ARCH_OS_WINDOWS)
@@ -121,9 +138,13 @@ static const char* const* _sessionLogArgv = nullptr;
 static const char* const* _sessionCrashLogArgv = nullptr;
 
 // This string stores the program name to be used when
-// displaying error information.  Initialized in
-// Arch_InitConfig() to ArchGetExecutablePath()
+// displaying error information.  Set by ArchSetProgramNameForErrors().
 static char * _progNameForErrors = NULL;
+static std::atomic<bool> _progNameForErrorsSet{false};
+
+// The program name used if none has been set, resolved lazily from
+// ArchGetExecutablePath() by Arch_InitProgramNameForErrors().
+static std::atomic<const char*> _defaultProgNameForErrors{nullptr};
 
 // Flag indicating whether the crash signal handler has been invoked.
 // Use a type that's safe in the presence of asynchronous signals.
@@ -147,6 +168,10 @@ public:
 
     void PrintInfoForErrors() const;
 
+#if defined(ARCH_OS_LINUX)
+    bool WriteCrashRecordSections(int fd) const;
+#endif
+
 private:
     typedef std::map<std::string, std::string> _MapType;
     _MapType _progInfoMap;
@@ -155,6 +180,9 @@ private:
     // Printed version of _progInfo map, since we can't
     // traverse it during an error. 
     char *_progInfoForErrors;
+
+    // Crash record sections for the _progInfo map, for the same reason.
+    std::string _progInfoForCrashRecord;
 };
 
 Arch_ProgInfo::~Arch_ProgInfo() 
@@ -163,6 +191,25 @@ Arch_ProgInfo::~Arch_ProgInfo()
         free(_progInfoForErrors);
 }
 
+// Append a crash record section holding a key and a value to record.
+static void
+_AppendCrashRecordKeyValue(std::string* record, uint32_t type,
+                           const std::string& key, const std::string& value)
+{
+    const uint32_t keySize = static_cast<uint32_t>(key.size());
+    const uint32_t valueSize = static_cast<uint32_t>(value.size());
+    const ArchCrashRecordSectionHeader header = {
+        type,
+        static_cast<uint32_t>(2 * sizeof(uint32_t) + keySize + valueSize)
+    };
+    record->append(reinterpret_cast<const char*>(&header), sizeof(header));
+    record->append(reinterpret_cast<const char*>(&keySize), sizeof(keySize));
+    record->append(reinterpret_cast<const char*>(&valueSize),
+                   sizeof(valueSize));
+    record->append(key);
+    record->append(value);
+}
+
 void
 Arch_ProgInfo::SetProgramInfoForErrors(
     const std::string& key, const std::string& value)
@@ -176,13 +223,18 @@ Arch_ProgInfo::SetProgramInfoForErrors(
     }
 
     std::ostringstream ss;
+    std::string record;
 
     // update the error info string
     for(_MapType::iterator iter = _progInfoMap.begin();
         iter != _progInfoMap.end(); ++iter) {
 
         ss << iter->first << ": " << iter->second << '\n';
+        _AppendCrashRecordKeyValue(
+            &record, ArchCrashRecordSectionProgramInfo,
+            iter->first, iter->second);
     }
+    _progInfoForCrashRecord.swap(record);
 
     if (_progInfoForErrors)
         free(_progInfoForErrors);
@@ -235,6 +287,10 @@ public:
                                   std::vector<std::string> const *lines);
     void EmitAnyExtraLogInfo(FILE *outFile, size_t max = 0) const;
 
+#if defined(ARCH_OS_LINUX)
+    bool WriteCrashRecordSections(int fd) const;
+#endif
+
 private:
     typedef std::map<std::string, std::vector<std::string> const *> _LogInfoMap;
     _LogInfoMap _logInfoForErrors;
@@ -306,6 +362,57 @@ static const char* const* _fatalArgv = nullptr;
 
 static long _GetAppElapsedTime();
 
+// Resolves the temporary directory and the default program name for
+// errors.  Resolving them the first time they're used allocates, so this
+// is done whenever crash logging is configured rather than while crashing.
+static void
+_ResolveCrashLogNames()
+{
+    ArchGetTmpDir();
+    ArchGetProgramNameForErrors();
+}
+
+// Returns the program name for errors without resolving the default, or
+// "libArch" if it hasn't been resolved.  Safe to call while crashing.
+static const char*
+_GetProgramNameForErrorsIfResolved()
+{
+    if (const char* progName = _progNameForErrors) {
+        return progName;
+    }
+    if (!_progNameForErrorsSet.load(std::memory_order_acquire)) {
+        if (const char* progName =
+                _defaultProgNameForErrors.load(std::memory_order_acquire)) {
+            return progName;
+        }
+    }
+    return "libArch";
+}
+
+// Returns the temporary directory without resolving it.  If it hasn't been
+// resolved, returns the same directory as ArchGetTmpDir() without
+// allocating.  Safe to call while crashing.
+static const char*
+_GetTmpDirIfResolved()
+{
+    if (const char* tmpDir = Arch_GetTmpDirIfResolved()) {
+        return tmpDir;
+    }
+#if defined(ARCH_OS_WINDOWS)
+    return ".";
+#else
+    const char* tmpDir = getenv("TMPDIR");
+    if (tmpDir && tmpDir[0]) {
+        return tmpDir;
+    }
+#if defined(ARCH_OS_DARWIN)
+    return "/tmp";
+#else
+    return "/var/tmp";
+#endif
+#endif
+}
+
 namespace {
 
 // Return the length of s.
@@ -380,6 +487,15 @@ const char* asgetenv(const char* name)
     return nullptr;
 }
 
+// Write errno=<error> and its message, if there is one, to writer.
+void _WriteErrno(ArchSignalSafeWriter& writer, int error)
+{
+    writer.Write("errno=").WriteDecimal(error);
+    if (const char* message = ArchStrerrorSignalSafe(error)) {
+        writer.Write(" (").Write(message).Write(')');
+    }
+}
+
 // Minimum safe size for a buffer to hold a long converted to decimal ASCII.
 static constexpr int numericBufferSize =
     std::numeric_limits<long>::digits10
@@ -431,27 +547,21 @@ char* asitoa(char* s, long x)
     return end;
 }
 
-// Write a string to a file descriptor.
-void aswrite(int fd, const char* msg)
-{
-    int saved = errno;
-    write(fd, msg, asstrlen(msg));
-    errno = saved;
-}
-
 int _GetStackTraceName(char* buf, size_t len)
 {
     // Take care to avoid non-async-safe functions.
     // NOTE: This doesn't protect against other threads changing the
     //       temporary directory or program name for errors.
+    const char* tmpDir = _GetTmpDirIfResolved();
+    const char* progName = _GetProgramNameForErrorsIfResolved();
 
     // Count the string length required.
     size_t required =
-        asstrlen(ArchGetTmpDir()) +
+        asstrlen(tmpDir) +
         1 +     // "/"
         asstrlen(stackTracePrefix) +
         1 +     // "_"
-        asstrlen(ArchGetProgramNameForErrors()) +
+        asstrlen(progName) +
         1 +     // "."
         asNumDigits(getpid()) +
         1;      // "\0"
@@ -464,11 +574,11 @@ int _GetStackTraceName(char* buf, size_t len)
         return -1;
     }
     else {
-        end = asstrcpy(end, ArchGetTmpDir());
+        end = asstrcpy(end, tmpDir);
         end = asstrcpy(end, "/");
         end = asstrcpy(end, stackTracePrefix);
         end = asstrcpy(end, "_");
-        end = asstrcpy(end, ArchGetProgramNameForErrors());
+        end = asstrcpy(end, progName);
         end = asstrcpy(end, ".");
         end = asitoa(end, getpid());
     }
@@ -725,8 +835,8 @@ int _LogStackTraceForPid(bool isFatal,
     static constexpr size_t maxArgs = 32;
     const char* argv[maxArgs];
     if (!_MakeArgv(argv, maxArgs, cmd, cmdArgv, substitutions, 4)) {
-        static const char msg[] = "Too many arguments to postmortem command\n";
-        aswrite(2, msg);
+        ArchSignalSafeWriter(2).Write(
+            "Too many arguments to postmortem command\n");
         return 0;
     }
 
@@ -741,11 +851,644 @@ ArchSetProcessStateLogCommand(const char* command,
                               const char *const argv[], 
                               const char *const fatalArgv[])
 {
+    _ResolveCrashLogNames();
+
     _processStateCmd  = command;
     _nonFatalArgv = argv;
     _fatalArgv = fatalArgv;
 }
 
+#if defined(ARCH_OS_LINUX)
+
+namespace {
+
+// Limits of the in-process crash reporter.  Threads beyond the first
+// _crashMaxThreads are not reported.
+constexpr size_t _crashMaxThreads = 1024;
+constexpr size_t _crashMaxDepth = 128;
+constexpr size_t _crashMaxRegisters = 64;
+
+// How long the reporting thread waits for the other threads to unwind.
+constexpr int _crashWaitMilliseconds = 1000;
+
+// Unwinding slot of a single thread.  The reporting thread fills in tid and
+// sets the state to Requested before signalling the thread, whose signal
+// handler claims the slot, unwinds its own stack and sets the state to Done.
+struct Arch_CrashThreadSlot {
+    enum State : int { Empty, Requested, Capturing, Done };
+
+    std::atomic<int> state;
+    std::atomic<pid_t> tid;
+    size_t depth;
+    uintptr_t frames[_crashMaxDepth];
+    size_t numRegisters;
+    uint64_t registers[_crashMaxRegisters];
+};
+
+// Everything the in-process crash reporter needs, allocated up front by
+// ArchSetInProcessCrashReporting().
+struct Arch_CrashReportStorage {
+    Arch_CrashThreadSlot threads[_crashMaxThreads];
+    char dirents[8192];
+    char lines[8192];
+};
+
+// Serializes the users of the crash report storage.
+std::atomic_flag _crashStorageBusy = ATOMIC_FLAG_INIT;
+
+// Acquires _crashStorageBusy, waiting a bounded amount of time for another
+// report to finish.  Returns false if it's still busy, as it is forever if
+// the reporter itself crashed while holding it.
+bool
+_LockCrashStorage()
+{
+    for (int i = 0; _crashStorageBusy.test_and_set(std::memory_order_acquire);
+         ++i) {
+        if (i == _crashWaitMilliseconds) {
+            return false;
+        }
+        struct timespec delay = { 0, 1000000 };
+        nanosleep(&delay, nullptr);
+    }
+    return true;
+}
+
+// Layout of the records returned by the getdents64 system call.
+struct Arch_LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+std::atomic<bool> _inProcessCrashReporting{false};
+Arch_CrashReportStorage* _crashStorage = nullptr;
+
+int _GetCrashReportSignal()
+{
+    return SIGRTMAX - 1;
+}
+
+pid_t asgettid()
+{
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+// Return the non-negative decimal number at s, or -1 if s holds anything
+// else.
+long asatoi(const char* s)
+{
+    if (!*s) {
+        return -1;
+    }
+    long result = 0;
+    for (; *s; ++s) {
+        if (*s < '0' || *s > '9') {
+            return -1;
+        }
+        result = result * 10 + (*s - '0');
+    }
+    return result;
+}
+
+// Copy the general purpose registers of the machine context uctx to
+// registers, returning their number.
+size_t
+_GetRegisters(const void* uctx, uint64_t* registers)
+{
+    const ucontext_t* context = static_cast<const ucontext_t*>(uctx);
+    size_t n = 0;
+#if defined(ARCH_CPU_INTEL) && defined(ARCH_BITS_64)
+    static_assert(NGREG <= _crashMaxRegisters, "Too many registers");
+    for (; n != NGREG; ++n) {
+        registers[n] = static_cast<uint64_t>(context->uc_mcontext.gregs[n]);
+    }
+#elif defined(ARCH_CPU_ARM) && defined(ARCH_BITS_64)
+    for (; n != 31; ++n) {
+        registers[n] = context->uc_mcontext.regs[n];
+    }
+    registers[n++] = context->uc_mcontext.sp;
+    registers[n++] = context->uc_mcontext.pc;
+    registers[n++] = context->uc_mcontext.pstate;
+#else
+    (void)context;
+    (void)registers;
+#endif
+    return n;
+}
+
+// Return the ELF machine number of this platform.
+uint32_t
+_GetElfMachine()
+{
+#if defined(ARCH_CPU_INTEL) && defined(ARCH_BITS_64)
+    return EM_X86_64;
+#elif defined(ARCH_CPU_ARM) && defined(ARCH_BITS_64)
+    return EM_AARCH64;
+#else
+    return EM_NONE;
+#endif
+}
+
+void
+_CrashReportSignalHandler(int, siginfo_t*, void* uctx)
+{
+    const int saved = errno;
+    if (Arch_CrashReportStorage* storage = _crashStorage) {
+        const pid_t tid = asgettid();
+        for (Arch_CrashThreadSlot& slot : storage->threads) {
+            int requested = Arch_CrashThreadSlot::Requested;
+            if (slot.tid.load(std::memory_order_acquire) == tid &&
+                slot.state.compare_exchange_strong(
+                    requested, Arch_CrashThreadSlot::Capturing)) {
+                slot.depth =
+                    ArchGetStackFrames(_crashMaxDepth, 0, slot.frames);
+                slot.numRegisters = _GetRegisters(uctx, slot.registers);
+                slot.state.store(Arch_CrashThreadSlot::Done);
+                break;
+            }
+        }
+    }
+    errno = saved;
+}
+
+// Ask every thread of the process to unwind itself into storage, and wait
+// for them to be done.  The registers of the calling thread are taken from
+// context if given.  Returns the number of slots used.
+size_t
+_UnwindAllThreads(Arch_CrashReportStorage* storage,
+                  const void* context = nullptr)
+{
+    const pid_t pid = getpid();
+    const pid_t self = asgettid();
+
+    size_t numThreads = 0;
+    auto addThread = [&](pid_t tid) {
+        if (numThreads == _crashMaxThreads) {
+            return;
+        }
+        Arch_CrashThreadSlot& slot = storage->threads[numThreads++];
+        slot.tid.store(tid, std::memory_order_release);
+        slot.depth = 0;
+        slot.numRegisters = 0;
+        if (tid == self) {
+            slot.depth = ArchGetStackFrames(_crashMaxDepth, 0, slot.frames);
+            ucontext_t current;
+            if (context) {
+                slot.numRegisters = _GetRegisters(context, slot.registers);
+            }
+            else if (getcontext(&current) == 0) {
+                slot.numRegisters = _GetRegisters(&current, slot.registers);
+            }
+            slot.state.store(Arch_CrashThreadSlot::Done);
+        }
+        else {
+            slot.state.store(Arch_CrashThreadSlot::Requested);
+            if (syscall(SYS_tgkill, pid, tid, _GetCrashReportSignal()) != 0) {
+                slot.state.store(Arch_CrashThreadSlot::Empty);
+            }
+        }
+    };
+
+    const int dirFd = open("/proc/self/task", O_RDONLY | O_DIRECTORY);
+    if (dirFd != -1) {
+        long n;
+        while ((n = syscall(SYS_getdents64, dirFd, storage->dirents,
+                            sizeof(storage->dirents))) > 0) {
+            for (long offset = 0; offset < n; ) {
+                const Arch_LinuxDirent64* entry =
+                    reinterpret_cast<const Arch_LinuxDirent64*>(
+                        storage->dirents + offset);
+                offset += entry->d_reclen;
+                const long tid = asatoi(entry->d_name);
+                if (tid > 0) {
+                    addThread(static_cast<pid_t>(tid));
+                }
+            }
+        }
+        close(dirFd);
+    }
+    if (numThreads == 0) {
+        addThread(self);
+    }
+
+    // Give the other threads a bounded amount of time to respond.  Threads
+    // blocking the signal or stuck in the kernel are reported as such.
+    for (int i = 0; i != _crashWaitMilliseconds; ++i) {
+        bool pending = false;
+        for (size_t j = 0; j != numThreads; ++j) {
+            const int state = storage->threads[j].state.load();
+            pending |= state == Arch_CrashThreadSlot::Requested ||
+                       state == Arch_CrashThreadSlot::Capturing;
+        }
+        if (!pending) {
+            break;
+        }
+        struct timespec delay = { 0, 1000000 };
+        nanosleep(&delay, nullptr);
+    }
+
+    // Withdraw requests that were not answered so a late handler does not
+    // write into a slot that is being reported.
+    for (size_t j = 0; j != numThreads; ++j) {
+        int requested = Arch_CrashThreadSlot::Requested;
+        storage->threads[j].state.compare_exchange_strong(
+            requested, Arch_CrashThreadSlot::Empty);
+    }
+
+    return numThreads;
+}
+
+// Copy the executable mappings of /proc/self/maps to fd.
+void
+_WriteExecutableMappings(int fd, Arch_CrashReportStorage* storage)
+{
+    const int mapsFd = open("/proc/self/maps", O_RDONLY);
+    if (mapsFd == -1) {
+        ArchSignalSafeWriter(fd).Write("<unavailable>\n");
+        return;
+    }
+
+    // Each line is "start-end perms offset dev inode path", write the ones
+    // whose permissions include 'x'.
+    auto writeLine = [fd](const char* line, size_t len) {
+        const char* perms = line;
+        while (perms != line + len && *perms != ' ') {
+            ++perms;
+        }
+        if (line + len - perms > 4 && perms[3] == 'x') {
+            write(fd, line, len);
+        }
+    };
+
+    char* const buffer = storage->lines;
+    const size_t capacity = sizeof(storage->lines);
+    size_t used = 0;
+    ssize_t n;
+    while ((n = read(mapsFd, buffer + used, capacity - used)) > 0) {
+        used += n;
+        size_t start = 0;
+        for (size_t i = 0; i != used; ++i) {
+            if (buffer[i] == '\n') {
+                writeLine(buffer + start, i + 1 - start);
+                start = i + 1;
+            }
+        }
+        if (start == 0 && used == capacity) {
+            // A line longer than the buffer, which should not happen.
+            start = used;
+        }
+        memmove(buffer, buffer + start, used - start);
+        used -= start;
+    }
+    close(mapsFd);
+}
+
+// Write size bytes at data to fd, retrying partial writes.
+bool aswriteall(int fd, const void* data, size_t size)
+{
+    const char* p = static_cast<const char*>(data);
+    while (size) {
+        const ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool
+_WriteCrashRecordSectionHeader(int fd, uint32_t type, size_t size)
+{
+    const ArchCrashRecordSectionHeader header = {
+        type, static_cast<uint32_t>(size)
+    };
+    return aswriteall(fd, &header, sizeof(header));
+}
+
+// Writes a module section for \p module with its executable range to the
+// crash record open on the descriptor pointed to by \p data.
+bool
+_WriteCrashRecordModule(
+    const ArchModuleInfo& module, const std::string& buildId, void* data)
+{
+    uint64_t range[3] = {
+        module.loadBias, std::numeric_limits<uint64_t>::max(), 0
+    };
+    for (const ArchModuleInfo::Segment& segment : module.segments) {
+        if (segment.executable) {
+            range[1] = std::min<uint64_t>(range[1], segment.start);
+            range[2] = std::max<uint64_t>(range[2], segment.end);
+        }
+    }
+    if (range[2] == 0) {
+        // No code, e.g. the vDSO data pages.
+        return true;
+    }
+
+    const int fd = *static_cast<int*>(data);
+    const uint32_t sizes[2] = {
+        static_cast<uint32_t>(buildId.size()),
+        static_cast<uint32_t>(module.path.size())
+    };
+    return _WriteCrashRecordSectionHeader(
+            fd, ArchCrashRecordSectionModule,
+            sizeof(range) + sizeof(sizes) + sizes[0] + sizes[1]) &&
+        aswriteall(fd, range, sizeof(range)) &&
+        aswriteall(fd, sizes, sizeof(sizes)) &&
+        aswriteall(fd, buildId.data(), sizes[0]) &&
+        aswriteall(fd, module.path.data(), sizes[1]);
+}
+
+// Write a crash record for the numThreads threads unwound into storage.
+bool
+_WriteCrashRecord(int fd, Arch_CrashReportStorage* storage,
+                  size_t numThreads, const char* reason)
+{
+    ArchCrashRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCH_CRASH_RECORD_MAGIC, sizeof(header.magic));
+    header.version = ARCH_CRASH_RECORD_VERSION;
+    header.machine = _GetElfMachine();
+    header.pid = static_cast<uint64_t>(getpid());
+    header.time = static_cast<int64_t>(time(nullptr));
+    bool ok = aswriteall(fd, &header, sizeof(header));
+
+    if (reason) {
+        const size_t size = asstrlen(reason);
+        ok = ok &&
+            _WriteCrashRecordSectionHeader(
+                fd, ArchCrashRecordSectionReason, size) &&
+            aswriteall(fd, reason, size);
+    }
+
+    const pid_t self = asgettid();
+    for (size_t i = 0; i != numThreads && ok; ++i) {
+        const Arch_CrashThreadSlot& slot = storage->threads[i];
+        const bool done = slot.state.load() == Arch_CrashThreadSlot::Done;
+
+        const pid_t threadId = slot.tid.load(std::memory_order_acquire);
+        uint32_t info[4] = { 0, 0, 0, 0 };
+        if (threadId == self) {
+            info[0] |= ArchCrashRecordThreadReporting;
+        }
+        if (done) {
+            info[1] = static_cast<uint32_t>(slot.numRegisters);
+            info[2] = static_cast<uint32_t>(slot.depth);
+            while (info[2] && !slot.frames[info[2] - 1]) {
+                --info[2];
+            }
+        }
+        else {
+            info[0] |= ArchCrashRecordThreadNoResponse;
+        }
+
+        const uint64_t tid = static_cast<uint64_t>(threadId);
+        ok = _WriteCrashRecordSectionHeader(
+                fd, ArchCrashRecordSectionThread,
+                sizeof(tid) + sizeof(info) +
+                (info[1] + info[2]) * sizeof(uint64_t)) &&
+            aswriteall(fd, &tid, sizeof(tid)) &&
+            aswriteall(fd, info, sizeof(info)) &&
+            aswriteall(fd, slot.registers, info[1] * sizeof(uint64_t));
+        if constexpr (sizeof(uintptr_t) == sizeof(uint64_t)) {
+            ok = ok &&
+                aswriteall(fd, slot.frames, info[2] * sizeof(uint64_t));
+        }
+        else {
+            // Widen each frame on 32-bit platforms.
+            for (uint32_t j = 0; j != info[2] && ok; ++j) {
+                const uint64_t frame = slot.frames[j];
+                ok = aswriteall(fd, &frame, sizeof(frame));
+            }
+        }
+    }
+
+    ok = ok && Arch_VisitLoadedModules(_WriteCrashRecordModule, &fd);
+
+    ok = ok &&
+        ArchStackTrace_GetProgInfo().WriteCrashRecordSections(fd) &&
+        ArchStackTrace_GetLogInfo().WriteCrashRecordSections(fd);
+
+    return ok;
+}
+
+} // anonymous namespace
+
+bool
+Arch_ProgInfo::WriteCrashRecordSections(int fd) const
+{
+    // Skip the program info rather than risk a deadlock if the crash
+    // happened while it was being modified.
+    std::unique_lock<std::mutex> lock(
+        _progInfoForErrorsMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return true;
+    }
+    return aswriteall(fd, _progInfoForCrashRecord.data(),
+                      _progInfoForCrashRecord.size());
+}
+
+bool
+Arch_LogInfo::WriteCrashRecordSections(int fd) const
+{
+    std::unique_lock<std::mutex> lock(
+        _logInfoForErrorsMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return true;
+    }
+    for (const auto& entry : _logInfoForErrors) {
+        size_t valueSize = 0;
+        for (const std::string& line : *entry.second) {
+            valueSize += line.size();
+        }
+        const uint32_t sizes[2] = {
+            static_cast<uint32_t>(entry.first.size()),
+            static_cast<uint32_t>(valueSize)
+        };
+        if (!_WriteCrashRecordSectionHeader(
+                fd, ArchCrashRecordSectionExtraLogInfo,
+                sizeof(sizes) + sizes[0] + sizes[1]) ||
+            !aswriteall(fd, sizes, sizeof(sizes)) ||
+            !aswriteall(fd, entry.first.data(), sizes[0])) {
+            return false;
+        }
+        for (const std::string& line : *entry.second) {
+            if (!aswriteall(fd, line.data(), line.size())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+#endif // defined(ARCH_OS_LINUX)
+
+/*
+ * Write the raw stack frames of every thread and the executable mappings to
+ * logfile, without running any external program.  A crash record with the
+ * same information is written next to it.
+ *
+ * This is an internal function used by ArchLogFatalProcessState() when the
+ * in-process crash reporter is enabled.  It must call only async-safe
+ * functions.
+ */
+static
+int _LogStackTraceInProcess(bool isFatal,
+                            const char *logfile, const char *reason)
+{
+#if defined(ARCH_OS_LINUX)
+    Arch_CrashReportStorage* storage = _crashStorage;
+    if (!storage) {
+        return 0;
+    }
+
+    // If another report holds the storage, fall back to the process state
+    // log command.
+    if (!_LockCrashStorage()) {
+        return _LogStackTraceForPid(isFatal, logfile, reason);
+    }
+
+    const int fd = open(logfile, O_WRONLY | O_APPEND);
+    if (fd == -1) {
+        _crashStorageBusy.clear(std::memory_order_release);
+        return 0;
+    }
+
+    const size_t numThreads = _UnwindAllThreads(storage);
+    const pid_t self = asgettid();
+
+    // Write each line with a single system call so lines stay whole.
+    ArchSignalSafeWriter writer(fd);
+    for (size_t i = 0; i != numThreads; ++i) {
+        const Arch_CrashThreadSlot& slot = storage->threads[i];
+        const pid_t tid = slot.tid.load(std::memory_order_acquire);
+        writer.Write("\nThread ").WriteDecimal(tid)
+              .Write(tid == self ? " (reporting):\n" : ":\n").Flush();
+        if (slot.state.load() != Arch_CrashThreadSlot::Done) {
+            writer.Write("<no response>\n").Flush();
+            continue;
+        }
+        for (size_t j = 0; j != slot.depth && slot.frames[j]; ++j) {
+            writer.Write(" #").WriteDecimal(static_cast<long long>(j))
+                  .Write(" 0x").WriteHex(slot.frames[j], 16).Write('\n')
+                  .Flush();
+        }
+    }
+
+    writer.Write("\nExecutable mappings:\n").Flush();
+    _WriteExecutableMappings(fd, storage);
+
+    static const char recordSuffix[] = ".crash";
+    char recordPath[1024];
+    if (asstrlen(logfile) + sizeof(recordSuffix) <= sizeof(recordPath)) {
+        asstrcpy(asstrcpy(recordPath, logfile), recordSuffix);
+        const int recordFd =
+            open(recordPath, O_CREAT | O_WRONLY | O_TRUNC, 0640);
+        if (recordFd != -1) {
+            if (_WriteCrashRecord(recordFd, storage, numThreads, reason)) {
+                writer.Write("\nCrash record: ").Write(recordPath)
+                      .Write('\n').Flush();
+            }
+            close(recordFd);
+        }
+    }
+
+    _crashStorageBusy.clear(std::memory_order_release);
+
+    close(fd);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+bool
+ArchWriteCrashRecord(int fd, const char* reason, const void* context)
+{
+#if defined(ARCH_OS_LINUX)
+    Arch_CrashReportStorage* storage = _crashStorage;
+    if (!storage || !_inProcessCrashReporting) {
+        return false;
+    }
+
+    if (!_LockCrashStorage()) {
+        return false;
+    }
+
+    const size_t numThreads = _UnwindAllThreads(storage, context);
+    const bool ok = _WriteCrashRecord(fd, storage, numThreads, reason);
+
+    _crashStorageBusy.clear(std::memory_order_release);
+    return ok;
+#else
+    (void)fd;
+    (void)reason;
+    (void)context;
+    return false;
+#endif
+}
+
+void
+ArchSetInProcessCrashReporting(bool enable)
+{
+#if defined(ARCH_OS_LINUX)
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (enable) {
+        _ResolveCrashLogNames();
+    }
+
+    if (enable && !_crashStorage) {
+        // Value-initialize so every page is touched now rather than while
+        // crashing.
+        _crashStorage = new Arch_CrashReportStorage();
+
+        // Unwinding for the first time may load and initialize the
+        // unwinder, which must not happen while crashing.
+        ArchGetStackFrames(_crashMaxDepth, 0, _crashStorage->threads[0].frames);
+
+        struct sigaction act;
+        memset(&act, 0, sizeof(act));
+        act.sa_sigaction = _CrashReportSignalHandler;
+        act.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigemptyset(&act.sa_mask);
+        if (sigaction(_GetCrashReportSignal(), &act, nullptr) != 0) {
+            ARCH_WARNING("Unable to install the crash report signal handler");
+            delete _crashStorage;
+            _crashStorage = nullptr;
+        }
+    }
+
+    if (enable && _crashStorage) {
+        // Crash records list the modules in the registry, which cannot
+        // be built safely while crashing.
+        ArchRefreshModuleRegistry();
+    }
+
+    _inProcessCrashReporting = enable && _crashStorage;
+#else
+    (void)enable;
+#endif
+}
+
+bool
+ArchGetInProcessCrashReporting()
+{
+#if defined(ARCH_OS_LINUX)
+    return _inProcessCrashReporting;
+#else
+    return false;
+#endif
+}
+
 /*
  * Arch_SetAppLaunchTime()
  * -------------------------------
@@ -783,6 +1526,9 @@ ArchGetAppLaunchTime()
 void
 ArchSetFatalStackLogging( bool flag )
 {
+    if (flag) {
+        _ResolveCrashLogNames();
+    }
     _shouldLogStackToDb = flag;   
 }
 
@@ -835,14 +1581,40 @@ ArchSetProgramNameForErrors( const char *progName )
         _progNameForErrors = strdup(getBase(progName).c_str());
     else
         _progNameForErrors = NULL;
+
+    _progNameForErrorsSet.store(true, std::memory_order_release);
+}
+
+/*
+ * Arch_InitProgramNameForErrors
+ * -----------------------------
+ * Resolves the default program name from the executable path.  This is
+ * done on first use, or at load time if ARCH_EAGER_INIT is set.  The name
+ * is published with a compare-and-swap so readers never block.
+ */
+ARCH_HIDDEN
+void
+Arch_InitProgramNameForErrors()
+{
+    if (_defaultProgNameForErrors.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    char* progName = strdup(getBase(ArchGetExecutablePath().c_str()).c_str());
+    const char* expected = nullptr;
+    if (!_defaultProgNameForErrors.compare_exchange_strong(
+            expected, progName, std::memory_order_acq_rel)) {
+        free(progName);
+    }
 }
 
 /*
  * ArchGetProgramNameForErrors
  * ----------------------------
  * Returns the currently set program name used for
- * reporting error information.  Returns "libArch"
- * if a value hasn't been set.
+ * reporting error information.  Returns the name of the
+ * executable if a value hasn't been set and "libArch"
+ * if it was set to NULL.
  */
 const char *
 ArchGetProgramNameForErrors()
@@ -850,6 +1622,17 @@ ArchGetProgramNameForErrors()
     if (_progNameForErrors)
         return _progNameForErrors;
 
+    if (!_progNameForErrorsSet.load(std::memory_order_acquire)) {
+        const char* progName =
+            _defaultProgNameForErrors.load(std::memory_order_acquire);
+        if (ARCH_UNLIKELY(!progName)) {
+            Arch_InitDeferredConfig();
+            progName =
+                _defaultProgNameForErrors.load(std::memory_order_acquire);
+        }
+        return progName;
+    }
+
     return "libArch";
 }
 
@@ -922,8 +1705,8 @@ _InvokeSessionLogger(const char* progname, const char *stackTrace)
     static constexpr size_t maxArgs = 32;
     const char* argv[maxArgs];
     if (!_MakeArgv(argv, maxArgs, cmd, srcArgv, substitutions, 4)) {
-        static const char msg[] = "Too many arguments to log session command\n";
-        aswrite(2, msg);
+        ArchSignalSafeWriter(2).Write(
+            "Too many arguments to log session command\n");
         return;
     }
 
@@ -980,6 +1763,8 @@ ArchSetLogSession(
     const char* const argv[],
     const char* const crashArgv[])
 {
+    _ResolveCrashLogNames();
+
     _logStackToDbCmd     = command;
     _sessionLogArgv      = argv;
     _sessionCrashLogArgv = crashArgv;
@@ -1020,8 +1805,12 @@ _ArchLogProcessStateHelper(bool isFatal,
     if (isFatal) {
         _SetAppIsCrashing(true);
     }
+    else {
+        // Not crashing, so they can be resolved now if they weren't.
+        _ResolveCrashLogNames();
+    }
 
-    const char* progname = ArchGetProgramNameForErrors();
+    const char* progname = _GetProgramNameForErrorsIfResolved();
 
     // If we can attach a debugger then just exit here.
     if (ArchDebuggerAttach()) {
@@ -1033,8 +1822,7 @@ _ArchLogProcessStateHelper(bool isFatal,
     char logfile[1024];
     if (_GetStackTraceName(logfile, sizeof(logfile)) == -1) {
         // Cannot create the logfile.
-        static const char msg[] = "Cannot create a log file\n";
-        aswrite(2, msg);
+        ArchSignalSafeWriter(2).Write("Cannot create a log file\n");
         busy.clear(std::memory_order_release);
         return;
     }
@@ -1113,7 +1901,11 @@ _ArchLogProcessStateHelper(bool isFatal,
     fputs(" ] ...", stderr);
     fflush(stderr);
 
-    int loggedStack = reason ?
+    int loggedStack =
+         ArchGetInProcessCrashReporting() ?
+         _LogStackTraceInProcess(isFatal, logfile,
+                                 reason ? reason : message) :
+         reason ?
          _LogStackTraceForPid(isFatal, logfile, reason) :
          _LogStackTraceForPid(isFatal, logfile, message);
     fputs(" done.\n", stderr);
@@ -1445,7 +2237,9 @@ Arch_DefaultStackTraceCallback(uintptr_t address)
         Arch_DemangleFunctionName(&symbolName);
         const uintptr_t symbolOffset =
             (uint64_t)(address - (uintptr_t)symbolAddress);
-        return ArchStringPrintf("%s+%#0lx", symbolName.c_str(), symbolOffset);
+        ArchFormatBuffer buffer;
+        buffer.Append(symbolName).Append("+0x").AppendHex(symbolOffset);
+        return buffer.GetString();
     }
     else {
         return "<unknown>";
@@ -1509,13 +2303,17 @@ Arch_GetStackTrace(const vector<uintptr_t> &frames,
         callback = Arch_DefaultStackTraceCallback;
     }
     int n = 0;
+    ArchFormatBuffer buffer;
     for (size_t i = 0; i < frames.size(); i++) {
         const std::string symbolic = callback(frames[i]);
         if (skipUnknownFrames && symbolic == "<unknown>") {
             continue;
         }
-        rv.push_back(ArchStringPrintf(" #%-3i 0x%016lx in %s",
-                                      n++, frames[i], symbolic.c_str()));
+        buffer.Clear();
+        buffer.Append(" #").AppendDecimal(n++, -3)
+              .Append(" 0x").AppendHex(frames[i], 16)
+              .Append(" in ").Append(symbolic);
+        rv.push_back(buffer.GetString());
     }
 
     return rv;
@@ -1541,6 +2339,115 @@ archAlarmHandler(int /*sig */)
     /* do nothing.  we just have to wake up. */
 }
 
+#if !defined(ARCH_OS_WINDOWS)
+/* Executes the crash handler in the child process.  This only uses
+ * async-signal-safe calls and doesn't touch the heap so it can run in a
+ * child that shares the parent's memory.
+ */
+[[noreturn]] static void
+archExecCrashHandler(const char* pathname, char *const argv[])
+{
+    // Call setsid() in the child, which is intended to start a new
+    // "session", and detach from the controlling tty.  We do this because
+    // the stack tracing stuff invokes gdb, which wants to fiddle with the
+    // tty, and if we're run in the background, that blocks, so we hang
+    // trying to take the stacktrace.  This seems to fix that.
+    //
+    // If standard input is not a TTY then skip this.  This ensures
+    // the child is part of the same process group as this process,
+    // which is important on the renderfarm.
+    if (isatty(0)) {
+        setsid();
+    }
+
+    // Exec the handler.
+    nonLockingExecv(pathname, argv);
+
+    /* Exec failed */
+    const int error = errno;
+    ArchSignalSafeWriter writer(2);
+    writer.Write("FAIL: Unable to exec crash handler ")
+          .Write(pathname).Write(": ");
+    _WriteErrno(writer, error);
+    writer.Write('\n').Flush();
+    _exit(127);
+}
+#endif
+
+#if defined(ARCH_OS_LINUX)
+namespace {
+
+struct _CrashHandlerLaunch {
+    const char* pathname;
+    char *const *argv;
+    const sigset_t* mask;
+};
+
+// Stack for the child started by _SpawnCrashHandler().  It's static since
+// we may be running on a small alternate signal stack.
+constexpr size_t _crashHandlerStackSize = 64 * 1024;
+alignas(16) char _crashHandlerStack[_crashHandlerStackSize];
+std::atomic_flag _crashHandlerStackBusy = ATOMIC_FLAG_INIT;
+
+int
+_CrashHandlerChild(void* data)
+{
+    const _CrashHandlerLaunch* launch =
+        static_cast<const _CrashHandlerLaunch*>(data);
+
+    // The parent's handlers must not run in this child since it shares
+    // the parent's memory.  Reset them before unblocking signals, as
+    // posix_spawn() does.
+    for (int sig = 1; sig < NSIG; ++sig) {
+        struct sigaction action;
+        if (sigaction(sig, NULL, &action) == 0 &&
+            action.sa_handler != SIG_DFL && action.sa_handler != SIG_IGN) {
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = 0;
+            action.sa_handler = SIG_DFL;
+            sigaction(sig, &action, NULL);
+        }
+    }
+    sigprocmask(SIG_SETMASK, launch->mask, NULL);
+
+    archExecCrashHandler(launch->pathname, launch->argv);
+}
+
+/* Starts the crash handler with clone(CLONE_VM | CLONE_VFORK).  Unlike
+ * fork() this doesn't copy the parent's page tables, which can take a long
+ * time for a large process.  The parent is suspended until the child has
+ * exec'd or exited.  Returns the child's pid or -1 on failure, in which
+ * case the caller should fall back to forking.
+ */
+pid_t
+_SpawnCrashHandler(const char* pathname, char *const argv[])
+{
+    if (_crashHandlerStackBusy.test_and_set(std::memory_order_acquire)) {
+        return -1;
+    }
+
+    // Block all signals so no handler runs in the child before it has
+    // reset them.
+    sigset_t all, old;
+    sigfillset(&all);
+    sigprocmask(SIG_SETMASK, &all, &old);
+
+    _CrashHandlerLaunch launch = { pathname, argv, &old };
+    const pid_t pid = clone(_CrashHandlerChild,
+                            _crashHandlerStack + _crashHandlerStackSize,
+                            CLONE_VM | CLONE_VFORK | SIGCHLD, &launch);
+    const int savedErrno = errno;
+
+    sigprocmask(SIG_SETMASK, &old, NULL);
+    _crashHandlerStackBusy.clear(std::memory_order_release);
+
+    errno = savedErrno;
+    return pid;
+}
+
+}
+#endif
+
 /*
  * Replacement for 'system' safe for a crash handler
  *
@@ -1551,7 +2458,9 @@ archAlarmHandler(int /*sig */)
  * for example, to print a '.' repeatedly to show progress.  The alarm
  * used in this function could interfere with setitimer or other calls
  * to alarm, and this function uses non-locking fork and exec if available
- * so should  not generally be used except following a catastrophe.
+ * so should  not generally be used except following a catastrophe.  On
+ * Linux the child shares this process's memory until it execs so starting
+ * it doesn't depend on the size of this process.
  */
 int
 ArchCrashHandlerSystemv(const char* pathname, char *const argv[],
@@ -1565,42 +2474,25 @@ ArchCrashHandlerSystemv(const char* pathname, char *const argv[],
     struct sigaction act, oldact;
     int retval = 0;
     int savedErrno;
+#if defined(ARCH_OS_LINUX)
+    /* share the address space if possible, otherwise fork */
+    pid_t pid = _SpawnCrashHandler(pathname, argv);
+    if (pid == -1) {
+        pid = nonLockingFork(); /* use non-locking fork */
+    }
+#else
     pid_t pid = nonLockingFork(); /* use non-locking fork */
+#endif
     if (pid == -1) {
         /* fork() failed */
-        char errBuffer[numericBufferSize];
-        asitoa(errBuffer, errno);
-        aswrite(2, "FAIL: Unable to fork() crash handler: errno=");
-        aswrite(2, errBuffer);
-        aswrite(2, "\n");
+        ArchSignalSafeWriter writer(2);
+        writer.Write("FAIL: Unable to fork() crash handler: ");
+        _WriteErrno(writer, errno);
+        writer.Write('\n');
         return -1;
     }
     else if (pid == 0) {
-        // Call setsid() in the child, which is intended to start a new
-        // "session", and detach from the controlling tty.  We do this because
-        // the stack tracing stuff invokes gdb, which wants to fiddle with the
-        // tty, and if we're run in the background, that blocks, so we hang
-        // trying to take the stacktrace.  This seems to fix that.
-        //
-        // If standard input is not a TTY then skip this.  This ensures
-        // the child is part of the same process group as this process,
-        // which is important on the renderfarm.
-        if (isatty(0)) {
-            setsid();
-        }
-
-        // Exec the handler.
-        nonLockingExecv(pathname, argv);
-
-        /* Exec failed */
-        char errBuffer[numericBufferSize];
-        asitoa(errBuffer, errno);
-        aswrite(2, "FAIL: Unable to exec crash handler ");
-        aswrite(2, pathname);
-        aswrite(2, ": errno=");
-        aswrite(2, errBuffer);
-        aswrite(2, "\n");
-        _exit(127);
+        archExecCrashHandler(pathname, argv);
     }
     else {
         int delta = 0;
@@ -1630,11 +2522,10 @@ ArchCrashHandlerSystemv(const char* pathname, char *const argv[],
                 /* waitpid error.  return if not due to signal. */
                 if (errno != EINTR) {
                     retval = -1;
-                    char errBuffer[numericBufferSize];
-                    asitoa(errBuffer, errno);
-                    aswrite(2, "FAIL: Crash handler wait failed: errno=");
-                    aswrite(2, errBuffer);
-                    aswrite(2, "\n");
+                    ArchSignalSafeWriter writer(2);
+                    writer.Write("FAIL: Crash handler wait failed: ");
+                    _WriteErrno(writer, errno);
+                    writer.Write('\n');
                     goto out;
                 }
                 /* continue below */
@@ -1649,7 +2540,8 @@ ArchCrashHandlerSystemv(const char* pathname, char *const argv[],
                     retval = WEXITSTATUS(status);
                     if (retval == 127) {
                         errno = ENOENT;
-                        aswrite(2, "FAIL: Crash handler failed to exec\n");
+                        ArchSignalSafeWriter(2).Write(
+                            "FAIL: Crash handler failed to exec\n");
                     }
                     goto out;
                 }
@@ -1658,21 +2550,17 @@ ArchCrashHandlerSystemv(const char* pathname, char *const argv[],
                     /* child died due to uncaught signal */
                     errno = EINTR;
                     retval = -1;
-                    char sigBuffer[numericBufferSize];
-                    asitoa(sigBuffer, WTERMSIG(status));
-                    aswrite(2, "FAIL: Crash handler died: signal=");
-                    aswrite(2, sigBuffer);
-                    aswrite(2, "\n");
+                    ArchSignalSafeWriter(2)
+                        .Write("FAIL: Crash handler died: signal=")
+                        .WriteDecimal(WTERMSIG(status)).Write('\n');
                     goto out;
                 }
                 /* child died for an unknown reason */
                 errno = EINTR;
                 retval = -1;
-                char statusBuffer[numericBufferSize];
-                asitoa(statusBuffer, status);
-                aswrite(2, "FAIL: Crash handler unexpected wait status=");
-                aswrite(2, statusBuffer);
-                aswrite(2, "\n");
+                ArchSignalSafeWriter(2)
+                    .Write("FAIL: Crash handler unexpected wait status=")
+                    .WriteDecimal(status).Write('\n');
                 goto out;
             }
 
@@ -1694,7 +2582,7 @@ ArchCrashHandlerSystemv(const char* pathname, char *const argv[],
          */
         errno = EBUSY;
         retval = -1;
-        aswrite(2, "FAIL: Crash handler timed out\n");
+        ArchSignalSafeWriter(2).Write("FAIL: Crash handler timed out\n");
     }
 
   out:
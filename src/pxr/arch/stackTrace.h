@@ -95,6 +95,40 @@ void ArchSetProcessStateLogCommand(const char* command,
                                    const char *const argv[],
                                    const char* const fatalArgv[]);
 
+/// Enables or disables the in-process crash reporter.
+///
+/// When enabled, \c ArchLogFatalProcessState() and
+/// \c ArchLogCurrentProcessState() no longer run the process state log
+/// command.  Instead the report is written by the process itself: every
+/// thread is sent a signal and unwinds its own stack, and the raw frame
+/// addresses of all threads are written to the log file followed by the
+/// executable mappings of the process.  Symbolization is left to a
+/// post-mortem tool, which needs the mappings to relate each address to a
+/// module and offset.
+///
+/// A binary crash record with the same information is written next to the
+/// log file, see \c ArchWriteCrashRecord().  The list of loaded modules it
+/// holds comes from the registry used by \c ArchFindModule(), which is
+/// refreshed by this call and, while this is enabled, whenever libraries
+/// are loaded with \c ArchLibraryOpen() or \c ArchPreloadLibraries().
+/// Call \c ArchRefreshModuleRegistry() after loading libraries by other
+/// means whose frames should be symbolized.
+///
+/// This avoids forking a process that may be very large or running out of
+/// memory.  All the memory the report needs is allocated by this call, and
+/// the report itself only uses async-safe functions.  The reporter uses the
+/// real-time signal \c SIGRTMAX-1 to interrupt the other threads.
+///
+/// This is only supported on Linux and has no effect elsewhere.
+ARCH_API
+void ArchSetInProcessCrashReporting(bool enable);
+
+/// Returns \c true if the in-process crash reporter is enabled.
+///
+/// \sa ArchSetInProcessCrashReporting
+ARCH_API
+bool ArchGetInProcessCrashReporting();
+
 /// Returns true if the fatal signal handler ArchLogFatalProcessState
 /// has been invoked.
 ARCH_API
@@ -203,12 +237,14 @@ bool ArchGetFatalStackLogging();
 
 /// Sets the program name to be used in diagnostic output
 ///
-/// The default value is initialized to ArchGetExecutablePath().
+/// The default value is the name of ArchGetExecutablePath().
 ARCH_API
 void ArchSetProgramNameForErrors(const char * progName);
 
 /// Returns the currently set program name for reporting errors.
-/// Defaults to ArchGetExecutablePath().
+/// Defaults to the name of ArchGetExecutablePath(), which is resolved on the
+/// first call or when the arch library is loaded if \c ARCH_EAGER_INIT is
+/// set.
 ARCH_API
 const char * ArchGetProgramNameForErrors();
 
@@ -324,7 +360,9 @@ typedef void (*ArchCrashHandlerSystemCB)(void* userData);
 /// to show progress.  The alarm used in this function could interfere with
 /// setitimer or other calls to alarm, and this function uses non-locking fork
 /// and exec if available so should not generally be used except following a
-/// catastrophe.
+/// catastrophe.  On Linux the child is started with \c clone(2) sharing this
+/// process's memory until it execs, so the launch time doesn't depend on the
+/// size of this process.
 ARCH_API
 int ArchCrashHandlerSystemv(const char* pathname, char *const argv[],
 			    int timeout, ArchCrashHandlerSystemCB callback, 
@@ -8,9 +8,21 @@
 #include "./fileSystem.h"
 #include "./symbols.h"
 #include "./defines.h"
+#include "./stackTrace.h"
+#include "./systemInfo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
 
 #if defined(ARCH_OS_LINUX)
 #include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <unistd.h>
 #elif defined(ARCH_OS_DARWIN)
 #include <dlfcn.h>
 #elif defined(ARCH_OS_WINDOWS)
@@ -21,12 +33,397 @@
 
 namespace pxr {
 
+#if defined(ARCH_OS_LINUX)
+
+namespace {
+
+// An immutable list of the loaded modules.  Snapshots are published
+// through _moduleSnapshot and never destroyed so readers need no locks and
+// the modules they return stay valid.
+struct _ModuleSnapshot {
+    // A segment and the index of its module, sorted by start.
+    struct Range {
+        uintptr_t start;
+        uintptr_t end;
+        size_t module;
+    };
+
+    std::vector<ArchModuleInfo> modules;
+    std::vector<std::string> rawBuildIds;
+    std::vector<Range> ranges;
+    unsigned long long adds = 0;
+    unsigned long long subs = 0;
+};
+
+std::atomic<const _ModuleSnapshot*> _moduleSnapshot{nullptr};
+std::mutex _moduleSnapshotMutex;
+
+// Set when libraries were loaded or unloaded since the snapshot was built.
+// The snapshot is rebuilt by the next lookup rather than on every change,
+// so loading many libraries in a row doesn't rebuild it each time.
+std::atomic<bool> _moduleSnapshotStale{false};
+
+// The number of batches of library loads in progress, during which the
+// snapshot is not rebuilt eagerly.
+std::atomic<int> _moduleChangeBatches{0};
+
+bool
+_HasLoaderCounts(const struct dl_phdr_info*, size_t size)
+{
+    return size >= offsetof(struct dl_phdr_info, dlpi_subs) +
+        sizeof(((struct dl_phdr_info*)nullptr)->dlpi_subs);
+}
+
+// Returns the dynamic loader's counts of loaded and unloaded objects.
+void
+_GetLoaderCounts(unsigned long long* adds, unsigned long long* subs)
+{
+    struct Counts {
+        unsigned long long adds = 0;
+        unsigned long long subs = 0;
+    } counts;
+    dl_iterate_phdr([](struct dl_phdr_info* info, size_t size, void* data) {
+        if (_HasLoaderCounts(info, size)) {
+            static_cast<Counts*>(data)->adds = info->dlpi_adds;
+            static_cast<Counts*>(data)->subs = info->dlpi_subs;
+        }
+        return 1;
+    }, &counts);
+    *adds = counts.adds;
+    *subs = counts.subs;
+}
+
+// Returns the GNU build ID note in the PT_NOTE segment \p phdr.
+std::string
+_GetBuildId(uintptr_t loadBias, const ElfW(Phdr)& phdr)
+{
+    const char* note = reinterpret_cast<const char*>(loadBias + phdr.p_vaddr);
+    const char* end = note + phdr.p_memsz;
+    while (note + sizeof(ElfW(Nhdr)) <= end) {
+        const ElfW(Nhdr)* nhdr = reinterpret_cast<const ElfW(Nhdr)*>(note);
+        const char* name = note + sizeof(ElfW(Nhdr));
+        const char* desc = name + ((nhdr->n_namesz + 3) & ~3u);
+        if (desc + nhdr->n_descsz > end) {
+            break;
+        }
+        if (nhdr->n_type == NT_GNU_BUILD_ID &&
+            nhdr->n_namesz == 4 && memcmp(name, "GNU", 4) == 0) {
+            return std::string(desc, nhdr->n_descsz);
+        }
+        note = desc + ((nhdr->n_descsz + 3) & ~3u);
+    }
+    return std::string();
+}
+
+std::string
+_ToHex(const std::string& bytes)
+{
+    static const char digit[] = "0123456789abcdef";
+    std::string result;
+    result.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes) {
+        result += digit[c >> 4];
+        result += digit[c & 0xf];
+    }
+    return result;
+}
+
+int
+_AddModule(struct dl_phdr_info* info, size_t size, void* data)
+{
+    _ModuleSnapshot* snapshot = static_cast<_ModuleSnapshot*>(data);
+    if (_HasLoaderCounts(info, size)) {
+        snapshot->adds = info->dlpi_adds;
+        snapshot->subs = info->dlpi_subs;
+    }
+
+    static const uintptr_t pageMask = ~uintptr_t(ArchGetPageSize() - 1);
+
+    ArchModuleInfo module;
+    module.loadBias = info->dlpi_addr;
+    module.baseAddress = std::numeric_limits<uintptr_t>::max();
+    std::string rawBuildId;
+    for (ElfW(Half) i = 0; i != info->dlpi_phnum; ++i) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type == PT_LOAD) {
+            const uintptr_t start = info->dlpi_addr + phdr.p_vaddr;
+            module.segments.push_back({
+                start, start + phdr.p_memsz, (phdr.p_flags & PF_X) != 0 });
+            module.baseAddress =
+                std::min(module.baseAddress, start & pageMask);
+        }
+        else if (phdr.p_type == PT_NOTE && rawBuildId.empty()) {
+            rawBuildId = _GetBuildId(info->dlpi_addr, phdr);
+        }
+    }
+    if (module.segments.empty()) {
+        return 0;
+    }
+
+    // The main program is reported first and with an empty name.
+    if (info->dlpi_name && info->dlpi_name[0]) {
+        module.path = info->dlpi_name;
+    }
+    else if (snapshot->modules.empty()) {
+        module.path = ArchGetExecutablePath();
+    }
+    std::sort(module.segments.begin(), module.segments.end(),
+              [](const ArchModuleInfo::Segment& a,
+                 const ArchModuleInfo::Segment& b) {
+                  return a.start < b.start;
+              });
+    module.buildId = _ToHex(rawBuildId);
+
+    for (const ArchModuleInfo::Segment& segment : module.segments) {
+        snapshot->ranges.push_back(
+            { segment.start, segment.end, snapshot->modules.size() });
+    }
+    snapshot->modules.push_back(std::move(module));
+    snapshot->rawBuildIds.push_back(std::move(rawBuildId));
+    return 0;
+}
+
+// Builds and publishes a new snapshot.  The caller must hold
+// _moduleSnapshotMutex.
+const _ModuleSnapshot*
+_PublishModuleSnapshot()
+{
+    // Changes reported while the snapshot is built mark it stale again.
+    _moduleSnapshotStale.store(false, std::memory_order_relaxed);
+
+    std::unique_ptr<_ModuleSnapshot> snapshot(new _ModuleSnapshot);
+    dl_iterate_phdr(_AddModule, snapshot.get());
+
+    // Order the modules by address, keeping the ranges in step.
+    const size_t numModules = snapshot->modules.size();
+    std::vector<size_t> order(numModules);
+    for (size_t i = 0; i != numModules; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return snapshot->modules[a].baseAddress <
+            snapshot->modules[b].baseAddress;
+    });
+    std::vector<size_t> position(numModules);
+    std::vector<ArchModuleInfo> modules(numModules);
+    std::vector<std::string> rawBuildIds(numModules);
+    for (size_t i = 0; i != numModules; ++i) {
+        position[order[i]] = i;
+        modules[i] = std::move(snapshot->modules[order[i]]);
+        rawBuildIds[i] = std::move(snapshot->rawBuildIds[order[i]]);
+    }
+    snapshot->modules.swap(modules);
+    snapshot->rawBuildIds.swap(rawBuildIds);
+    for (_ModuleSnapshot::Range& range : snapshot->ranges) {
+        range.module = position[range.module];
+    }
+    std::sort(snapshot->ranges.begin(), snapshot->ranges.end(),
+              [](const _ModuleSnapshot::Range& a,
+                 const _ModuleSnapshot::Range& b) {
+                  return a.start < b.start;
+              });
+
+    // The previous snapshot is leaked since readers may still use it.
+    const _ModuleSnapshot* result = snapshot.release();
+    _moduleSnapshot.store(result, std::memory_order_release);
+    return result;
+}
+
+// Returns the current snapshot, building it if there is none or libraries
+// were loaded or unloaded since.
+const _ModuleSnapshot*
+_GetModuleSnapshot()
+{
+    const _ModuleSnapshot* snapshot =
+        _moduleSnapshot.load(std::memory_order_acquire);
+    if (snapshot && !_moduleSnapshotStale.load(std::memory_order_acquire)) {
+        return snapshot;
+    }
+    std::lock_guard<std::mutex> lock(_moduleSnapshotMutex);
+    snapshot = _moduleSnapshot.load(std::memory_order_acquire);
+    if (snapshot && !_moduleSnapshotStale.load(std::memory_order_acquire)) {
+        return snapshot;
+    }
+    return _PublishModuleSnapshot();
+}
+
+// Rebuilds the snapshot if the dynamic loader reports a change since
+// \p snapshot was built.  Returns the current snapshot.
+const _ModuleSnapshot*
+_UpdateModuleSnapshot(const _ModuleSnapshot* snapshot)
+{
+    std::lock_guard<std::mutex> lock(_moduleSnapshotMutex);
+    const _ModuleSnapshot* current =
+        _moduleSnapshot.load(std::memory_order_acquire);
+    if (current != snapshot) {
+        return current;
+    }
+    if (_moduleSnapshotStale.load(std::memory_order_acquire)) {
+        return _PublishModuleSnapshot();
+    }
+    unsigned long long adds, subs;
+    _GetLoaderCounts(&adds, &subs);
+    if (adds == snapshot->adds && subs == snapshot->subs) {
+        return snapshot;
+    }
+    return _PublishModuleSnapshot();
+}
+
+const ArchModuleInfo*
+_FindModule(const _ModuleSnapshot* snapshot, uintptr_t address)
+{
+    auto i = std::upper_bound(
+        snapshot->ranges.begin(), snapshot->ranges.end(), address,
+        [](uintptr_t address, const _ModuleSnapshot::Range& range) {
+            return address < range.start;
+        });
+    if (i == snapshot->ranges.begin() || address >= (--i)->end) {
+        return nullptr;
+    }
+    return &snapshot->modules[i->module];
+}
+
+} // anonymous namespace
+
+/// \private
+/// Calls \p visitor with each registered module and its raw build ID until
+/// it returns \c false.  This neither locks nor allocates so it's safe to
+/// use while crashing, but only sees modules registered beforehand.
+ARCH_HIDDEN
+bool
+Arch_VisitLoadedModules(
+    bool (*visitor)(const ArchModuleInfo&, const std::string&, void*),
+    void* data)
+{
+    const _ModuleSnapshot* snapshot =
+        _moduleSnapshot.load(std::memory_order_acquire);
+    if (!snapshot) {
+        return true;
+    }
+    for (size_t i = 0; i != snapshot->modules.size(); ++i) {
+        if (!visitor(snapshot->modules[i], snapshot->rawBuildIds[i], data)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rebuilds the snapshot if there is one and it's stale.
+static void
+_RefreshStaleModuleSnapshot()
+{
+    std::lock_guard<std::mutex> lock(_moduleSnapshotMutex);
+    if (_moduleSnapshot.load(std::memory_order_acquire) &&
+        _moduleSnapshotStale.load(std::memory_order_acquire)) {
+        _PublishModuleSnapshot();
+    }
+}
+
+/// \private
+/// Marks the module registry stale after a library was loaded or unloaded.
+/// It's rebuilt by the next lookup, except while in-process crash reporting
+/// is enabled: crash records list the modules in the registry and it can't
+/// be rebuilt while crashing, so it's rebuilt now.
+ARCH_HIDDEN
+void
+Arch_NotifyModulesChanged()
+{
+    _moduleSnapshotStale.store(true, std::memory_order_release);
+    if (ArchGetInProcessCrashReporting() &&
+        _moduleChangeBatches.load(std::memory_order_acquire) == 0) {
+        _RefreshStaleModuleSnapshot();
+    }
+}
+
+/// \private
+/// Starts a batch of library loads, during which the module registry isn't
+/// rebuilt eagerly.
+ARCH_HIDDEN
+void
+Arch_BeginModuleChanges()
+{
+    ++_moduleChangeBatches;
+}
+
+/// \private
+/// Ends a batch of library loads, rebuilding the module registry once if
+/// it's in use and was changed.
+ARCH_HIDDEN
+void
+Arch_EndModuleChanges()
+{
+    if (--_moduleChangeBatches == 0) {
+        _RefreshStaleModuleSnapshot();
+    }
+}
+
+#endif // defined(ARCH_OS_LINUX)
+
+const ArchModuleInfo*
+ArchFindModule(const void* address)
+{
+#if defined(ARCH_OS_LINUX)
+    if (!address) {
+        return nullptr;
+    }
+    const uintptr_t value = reinterpret_cast<uintptr_t>(address);
+    const _ModuleSnapshot* snapshot = _GetModuleSnapshot();
+    if (const ArchModuleInfo* module = _FindModule(snapshot, value)) {
+        return module;
+    }
+
+    // The address may be in a library loaded since the snapshot was built.
+    const _ModuleSnapshot* current = _UpdateModuleSnapshot(snapshot);
+    return current == snapshot ? nullptr : _FindModule(current, value);
+#else
+    (void)address;
+    return nullptr;
+#endif
+}
+
+std::vector<ArchModuleInfo>
+ArchGetLoadedModules()
+{
+#if defined(ARCH_OS_LINUX)
+    return _UpdateModuleSnapshot(_GetModuleSnapshot())->modules;
+#else
+    return std::vector<ArchModuleInfo>();
+#endif
+}
+
+void
+ArchRefreshModuleRegistry()
+{
+#if defined(ARCH_OS_LINUX)
+    std::lock_guard<std::mutex> lock(_moduleSnapshotMutex);
+    _PublishModuleSnapshot();
+#endif
+}
+
 bool
 ArchGetAddressInfo(
     void* address,
     std::string* objectPath, void** baseAddress,
     std::string* symbolName, void** symbolAddress)
 {
+#if defined(ARCH_OS_LINUX)
+
+    // Answer object queries from the module registry rather than asking
+    // the dynamic loader.
+    if (!symbolName && !symbolAddress) {
+        if (const ArchModuleInfo* module = ArchFindModule(address)) {
+            if (objectPath) {
+                *objectPath = ArchAbsPath(module->path);
+            }
+            if (baseAddress) {
+                *baseAddress = reinterpret_cast<void*>(module->baseAddress);
+            }
+            return true;
+        }
+    }
+
+#endif
+
 #if defined(_GNU_SOURCE) || defined(ARCH_OS_DARWIN)
 
     Dl_info info;
@@ -12,7 +12,9 @@
 /// Architecture-specific symbol lookup routines.
 
 #include "./api.h"
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace pxr {
 
@@ -33,6 +35,65 @@ bool ArchGetAddressInfo(void* address,
                         std::string* objectPath, void** baseAddress,
                         std::string* symbolName, void** symbolAddress);
 
+/// Describes an executable or shared library loaded in the running program.
+///
+/// \see ArchFindModule
+struct ArchModuleInfo {
+    /// An address range \c [start, end) mapped from a loadable segment.
+    struct Segment {
+        uintptr_t start;
+        uintptr_t end;
+        bool executable;
+    };
+
+    /// Absolute path of the main program, otherwise the path of the
+    /// library as given to the dynamic loader.
+    std::string path;
+
+    /// Lowest address the module is mapped at.
+    uintptr_t baseAddress = 0;
+
+    /// Difference between the addresses in the module's file and the
+    /// addresses it's loaded at.
+    uintptr_t loadBias = 0;
+
+    /// The loadable segments, sorted by address.
+    std::vector<Segment> segments;
+
+    /// The GNU build ID in lowercase hexadecimal, or empty if the module
+    /// has none.
+    std::string buildId;
+};
+
+/// Returns the module containing \p address, or \c NULL if there is none.
+///
+/// Loaded modules are kept in a registry sorted by address so lookups are
+/// a lock-free binary search rather than a query to the dynamic loader.
+/// The registry is refreshed by the first lookup after libraries are loaded
+/// or unloaded with ArchLibraryOpen() and ArchLibraryClose(), right away if
+/// in-process crash reporting is enabled, and when a lookup misses after
+/// the dynamic loader reports a change.  A module
+/// unloaded by other means may be returned until the next refresh.
+///
+/// The returned object is never destroyed and never changes.  This is
+/// only implemented on Linux and returns \c NULL elsewhere.
+ARCH_API
+const ArchModuleInfo* ArchFindModule(const void* address);
+
+/// Returns the modules loaded in the running program, sorted by address.
+///
+/// This is only implemented on Linux and returns an empty vector elsewhere.
+ARCH_API
+std::vector<ArchModuleInfo> ArchGetLoadedModules();
+
+/// Rebuilds the registry used by ArchFindModule() from the dynamic loader.
+///
+/// This is only needed after loading or unloading libraries without
+/// ArchLibraryOpen() and ArchLibraryClose() when modules that are still
+/// loaded must no longer be reported as such.
+ARCH_API
+void ArchRefreshModuleRegistry();
+
 }  // namespace pxr
 
 #endif // PXR_ARCH_SYMBOLS_H
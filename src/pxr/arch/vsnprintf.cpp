@@ -7,6 +7,8 @@
 
 #include "./vsnprintf.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 
 using std::string;
@@ -57,4 +59,186 @@ ArchStringPrintf(const char *fmt, ...)
     return s;
 }
 
+namespace {
+
+// The two decimal digits of every value below 100.
+const char _digitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the decimal digits of value so they end just before end and
+// returns a pointer to the first digit.
+char*
+_FormatDecimal(unsigned long long value, char* end)
+{
+    while (value >= 100) {
+        const unsigned int pair = static_cast<unsigned int>(value % 100) * 2;
+        value /= 100;
+        *--end = _digitPairs[pair + 1];
+        *--end = _digitPairs[pair];
+    }
+    if (value >= 10) {
+        const unsigned int pair = static_cast<unsigned int>(value) * 2;
+        *--end = _digitPairs[pair + 1];
+        *--end = _digitPairs[pair];
+    }
+    else {
+        *--end = static_cast<char>('0' + value);
+    }
+    return end;
+}
+
+// Appends the first size characters of digits padded to width as in
+// ArchFormatBuffer::AppendDecimal().
+void
+_AppendPadded(ArchFormatBuffer* buffer,
+              const char* digits, size_t size, int width)
+{
+    static const char spaces[] = "                                ";
+    const size_t padding = static_cast<size_t>(std::abs(width)) > size ?
+        static_cast<size_t>(std::abs(width)) - size : 0;
+    if (width > 0) {
+        for (size_t n = padding; n; n -= std::min(n, sizeof(spaces) - 1)) {
+            buffer->Append(spaces, std::min(n, sizeof(spaces) - 1));
+        }
+    }
+    buffer->Append(digits, size);
+    if (width < 0) {
+        for (size_t n = padding; n; n -= std::min(n, sizeof(spaces) - 1)) {
+            buffer->Append(spaces, std::min(n, sizeof(spaces) - 1));
+        }
+    }
+}
+
+} // anonymous namespace
+
+ArchFormatBuffer::~ArchFormatBuffer()
+{
+    if (_data != _inline && !_external) {
+        free(_data);
+    }
+}
+
+bool
+ArchFormatBuffer::_Reserve(size_t size)
+{
+    if (_size + size < _capacity) {
+        return true;
+    }
+    if (_external) {
+        return false;
+    }
+
+    const size_t capacity = std::max(_capacity * 2, _size + size + 1);
+    char* data = static_cast<char*>(
+        _data == _inline ? malloc(capacity) : realloc(_data, capacity));
+    if (!data) {
+        return false;
+    }
+    if (_data == _inline) {
+        memcpy(data, _inline, _size + 1);
+    }
+    _data = data;
+    _capacity = capacity;
+    return true;
+}
+
+void
+ArchFormatBuffer::_AppendSlow(const char* text, size_t size)
+{
+    if (!_Reserve(size)) {
+        // Keep what fits.
+        _truncated = true;
+        size = _capacity - 1 - _size;
+    }
+    memcpy(_data + _size, text, size);
+    _size += size;
+    _data[_size] = '\0';
+}
+
+ArchFormatBuffer&
+ArchFormatBuffer::AppendDecimal(long long value, int width)
+{
+    char digits[24];
+    char* const end = digits + sizeof(digits);
+    const unsigned long long magnitude = value < 0 ?
+        0ull - static_cast<unsigned long long>(value) :
+        static_cast<unsigned long long>(value);
+    char* first = _FormatDecimal(magnitude, end);
+    if (value < 0) {
+        *--first = '-';
+    }
+    _AppendPadded(this, first, end - first, width);
+    return *this;
+}
+
+ArchFormatBuffer&
+ArchFormatBuffer::AppendUnsigned(unsigned long long value, int width)
+{
+    char digits[24];
+    char* const end = digits + sizeof(digits);
+    char* const first = _FormatDecimal(value, end);
+    _AppendPadded(this, first, end - first, width);
+    return *this;
+}
+
+ArchFormatBuffer&
+ArchFormatBuffer::AppendHex(unsigned long long value, int minDigits)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    char digits[2 * sizeof(value)];
+    char* const end = digits + sizeof(digits);
+    char* first = end;
+    do {
+        *--first = hexDigits[value & 0xf];
+        value >>= 4;
+    } while (value);
+
+    for (int n = minDigits - static_cast<int>(end - first); n > 0; ) {
+        static const char zeros[] = "0000000000000000";
+        const int count = std::min(n, static_cast<int>(sizeof(zeros) - 1));
+        Append(zeros, count);
+        n -= count;
+    }
+    return Append(first, end - first);
+}
+
+ArchFormatBuffer&
+ArchFormatBuffer::AppendPrintf(const char* format, ...)
+{
+    va_list ap, apcopy;
+    va_start(ap, format);
+    va_copy(apcopy, ap);
+
+    const size_t available = _capacity - _size;
+    const int needed = ArchVsnprintf(_data + _size, available, format, ap);
+    if (needed < 0) {
+        _data[_size] = '\0';
+    }
+    else if (static_cast<size_t>(needed) < available) {
+        _size += needed;
+    }
+    else if (_Reserve(needed)) {
+        ArchVsnprintf(_data + _size, needed + 1, format, apcopy);
+        _size += needed;
+    }
+    else {
+        // Keep what fits, which vsnprintf already wrote.
+        _truncated = true;
+        _size = _capacity - 1;
+    }
+
+    va_end(apcopy);
+    va_end(ap);
+    return *this;
+}
+
 }  // namespace pxr
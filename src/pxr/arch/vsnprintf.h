@@ -16,6 +16,8 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
 #include <string>
 
 namespace pxr {
@@ -77,6 +79,151 @@ std::string ArchVStringPrintf(const char *fmt, va_list ap)
 #endif /* doxygen */
     ;
 
+/// \class ArchFormatBuffer
+///
+/// Builds a string by appending to a buffer without going through
+/// printf() for common conversions.
+///
+/// \c ArchFormatBuffer appends text, decimal and hexadecimal integers
+/// with hand-written conversions, and falls back to a printf()-like
+/// specification only where needed.  Each append has its argument types
+/// checked at compile time: the typed appends by their signatures and
+/// \c AppendPrintf() by \c ARCH_PRINTF_FUNCTION.  For example,
+/// \code
+///  ArchFormatBuffer buffer;
+///  buffer.Append(" #").AppendDecimal(n, -3)
+///        .Append(" 0x").AppendHex(address, 16)
+///        .Append(" in ").Append(name);
+///  return buffer.GetString();
+/// \endcode
+///
+/// A default-constructed buffer starts with a small inline buffer and
+/// moves to the heap if the result outgrows it.  A buffer constructed
+/// over caller storage never allocates and instead drops whatever does
+/// not fit, see \c IsTruncated().  The contents are always null
+/// terminated.
+///
+class ArchFormatBuffer {
+public:
+    /// Size of the inline buffer, including the terminating null.
+    static constexpr size_t InlineCapacity = 256;
+
+    /// Creates an empty buffer using inline storage.
+    ArchFormatBuffer()
+        : _data(_inline), _size(0), _capacity(InlineCapacity)
+        , _external(false), _truncated(false)
+    {
+        _inline[0] = '\0';
+    }
+
+    /// Creates an empty buffer over the \p capacity bytes at \p buffer,
+    /// which must be at least one.  Appending never allocates.
+    ArchFormatBuffer(char* buffer, size_t capacity)
+        : _data(buffer), _size(0), _capacity(capacity)
+        , _external(true), _truncated(false)
+    {
+        _data[0] = '\0';
+    }
+
+    ArchFormatBuffer(const ArchFormatBuffer&) = delete;
+    ArchFormatBuffer& operator=(const ArchFormatBuffer&) = delete;
+
+    ARCH_API
+    ~ArchFormatBuffer();
+
+    /// Appends the \p size characters at \p text.
+    ArchFormatBuffer& Append(const char* text, size_t size)
+    {
+        if (_size + size < _capacity) {
+            memcpy(_data + _size, text, size);
+            _size += size;
+            _data[_size] = '\0';
+        }
+        else {
+            _AppendSlow(text, size);
+        }
+        return *this;
+    }
+
+    /// Appends the null terminated \p text.
+    ArchFormatBuffer& Append(const char* text)
+    {
+        return Append(text, strlen(text));
+    }
+
+    /// Appends \p text.
+    ArchFormatBuffer& Append(const std::string& text)
+    {
+        return Append(text.data(), text.size());
+    }
+
+    /// Appends the character \p c.
+    ArchFormatBuffer& Append(char c)
+    {
+        return Append(&c, 1);
+    }
+
+    /// Appends \p value in decimal, padded with spaces to \p width
+    /// characters.  A negative \p width pads on the right, like \c "%-*d".
+    ARCH_API
+    ArchFormatBuffer& AppendDecimal(long long value, int width = 0);
+
+    /// Appends \p value in decimal, padded as in \c AppendDecimal().
+    ARCH_API
+    ArchFormatBuffer& AppendUnsigned(unsigned long long value, int width = 0);
+
+    /// Appends \p value in lowercase hexadecimal without a prefix, padded
+    /// with zeros to at least \p minDigits digits.
+    ARCH_API
+    ArchFormatBuffer& AppendHex(unsigned long long value, int minDigits = 1);
+
+    /// Appends the result of a printf()-like specification.  The
+    /// specification is formatted directly into the buffer, so only a
+    /// result that doesn't fit is formatted twice.
+    ARCH_API
+    ArchFormatBuffer& AppendPrintf(const char* format, ...)
+#ifndef doxygen
+        ARCH_PRINTF_FUNCTION(2, 3)
+#endif /* doxygen */
+        ;
+
+    /// Removes the contents.
+    void Clear()
+    {
+        _size = 0;
+        _data[0] = '\0';
+        _truncated = false;
+    }
+
+    /// Returns the null terminated contents.
+    const char* GetData() const { return _data; }
+
+    /// Returns the number of characters, not including the null.
+    size_t GetSize() const { return _size; }
+
+    /// Returns a copy of the contents.
+    std::string GetString() const { return std::string(_data, _size); }
+
+    /// Returns \c true if anything was dropped because it didn't fit in
+    /// the caller's storage.
+    bool IsTruncated() const { return _truncated; }
+
+private:
+    ARCH_API
+    void _AppendSlow(const char* text, size_t size);
+
+    // Makes room for \p size more characters and the null, returning
+    // false if that's not possible.
+    bool _Reserve(size_t size);
+
+    char* _data;
+    size_t _size;
+    size_t _capacity;
+    bool _external;
+    bool _truncated;
+    char _inline[InlineCapacity];
+};
+
 }  // namespace pxr
     
 #endif // PXR_ARCH_VSNPRINTF_H
@@ -0,0 +1,174 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/align.h>
+#include <pxr/arch/smallVector.h>
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pxr;
+
+template <class T>
+static bool
+_IsAligned(const T* ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+TEST(AlignTest, AlignedAlloc)
+{
+    for (size_t alignment : {8, 16, 64, 4096}) {
+        void* ptr = ArchAlignedAlloc(alignment, 3 * alignment);
+        ASSERT_NE(ptr, nullptr);
+        ASSERT_TRUE(_IsAligned(static_cast<char*>(ptr), alignment));
+        ArchAlignedFree(ptr);
+    }
+}
+
+TEST(AlignTest, AlignedAllocator)
+{
+    static_assert(ArchAlignedAllocator<char>::alignment ==
+                  ARCH_CACHE_LINE_SIZE, "");
+    static_assert(ArchAlignedAllocator<double, 1>::alignment ==
+                  alignof(double), "");
+    static_assert(ArchAlignedAllocator<int>() ==
+                  ArchAlignedAllocator<float>(), "");
+
+    std::vector<float, ArchAlignedAllocator<float>> samples;
+    for (int i = 0; i != 1000; ++i) {
+        samples.push_back(static_cast<float>(i));
+        ASSERT_TRUE(_IsAligned(samples.data(), ARCH_CACHE_LINE_SIZE));
+    }
+    ASSERT_EQ(samples[999], 999.0f);
+
+    std::vector<char, ArchAlignedAllocator<char, 4096>> page(10);
+    ASSERT_TRUE(_IsAligned(page.data(), 4096));
+
+    // Node-based containers rebind the allocator.
+    std::list<int, ArchAlignedAllocator<int>> nodes = { 1, 2, 3 };
+    for (const int& node : nodes) {
+        ASSERT_TRUE(_IsAligned(&node, alignof(int)));
+    }
+
+    ArchAlignedAllocator<double> allocator;
+    double* empty = allocator.allocate(0);
+    ASSERT_NE(empty, nullptr);
+    allocator.deallocate(empty, 0);
+
+    ASSERT_THROW(allocator.allocate(allocator.max_size() + 1),
+                 std::bad_array_new_length);
+}
+
+TEST(AlignTest, SmallVectorInline)
+{
+    ArchSmallVector<int, 4> values;
+    ASSERT_TRUE(values.empty());
+    ASSERT_TRUE(values.is_inline());
+    ASSERT_EQ(values.capacity(), 4u);
+
+    for (int i = 0; i != 4; ++i) {
+        values.push_back(i);
+    }
+    ASSERT_TRUE(values.is_inline());
+    ASSERT_EQ(values, (ArchSmallVector<int, 4>{ 0, 1, 2, 3 }));
+
+    // Growing past the inline capacity moves the elements to the heap.
+    values.push_back(4);
+    ASSERT_FALSE(values.is_inline());
+    ASSERT_GE(values.capacity(), 5u);
+    ASSERT_EQ(values, (ArchSmallVector<int, 4>{ 0, 1, 2, 3, 4 }));
+
+    // Shrinking back to fit returns them to the inline storage.
+    values.pop_back();
+    values.shrink_to_fit();
+    ASSERT_TRUE(values.is_inline());
+    ASSERT_EQ(values, (ArchSmallVector<int, 4>{ 0, 1, 2, 3 }));
+
+    // Appending one of our own elements while growing.
+    values.push_back(values[0]);
+    ASSERT_EQ(values.back(), 0);
+    values.resize(64, values[1]);
+    ASSERT_EQ(values.size(), 64u);
+    ASSERT_EQ(values.back(), 1);
+}
+
+TEST(AlignTest, SmallVectorAlignment)
+{
+    using Buffer = ArchSmallVector<float, 16, ARCH_CACHE_LINE_SIZE>;
+    static_assert(alignof(Buffer) == ARCH_CACHE_LINE_SIZE, "");
+
+    Buffer buffer(16, 1.0f);
+    ASSERT_TRUE(buffer.is_inline());
+    ASSERT_TRUE(_IsAligned(buffer.data(), ARCH_CACHE_LINE_SIZE));
+
+    buffer.resize(100);
+    ASSERT_FALSE(buffer.is_inline());
+    ASSERT_TRUE(_IsAligned(buffer.data(), ARCH_CACHE_LINE_SIZE));
+    ASSERT_EQ(buffer[15], 1.0f);
+    ASSERT_EQ(buffer[99], 0.0f);
+}
+
+TEST(AlignTest, SmallVectorModifiers)
+{
+    ArchSmallVector<std::string, 2> names = { "b", "d" };
+    names.insert(names.begin(), "a");
+    names.insert(names.begin() + 2, "c");
+    names.emplace(names.end(), 1, 'e');
+    ASSERT_EQ(names, (ArchSmallVector<std::string, 2>{
+        "a", "b", "c", "d", "e" }));
+
+    ASSERT_EQ(*names.erase(names.begin() + 1), "c");
+    const auto last = names.erase(names.begin() + 2, names.end());
+    ASSERT_EQ(last, names.end());
+    ASSERT_EQ(names, (ArchSmallVector<std::string, 2>{ "a", "c" }));
+
+    const std::vector<std::string> source = { "x", "y", "z" };
+    ArchSmallVector<std::string, 2> copy(source.begin(), source.end());
+    ASSERT_EQ(copy.size(), 3u);
+    ASSERT_EQ(*copy.rbegin(), "z");
+
+    names.resize(1);
+    ASSERT_EQ(names.size(), 1u);
+    names.clear();
+    ASSERT_TRUE(names.empty());
+}
+
+TEST(AlignTest, SmallVectorCopyAndMove)
+{
+    // Inline elements are moved one by one.
+    ArchSmallVector<std::unique_ptr<int>, 2> small;
+    small.push_back(std::make_unique<int>(1));
+    ArchSmallVector<std::unique_ptr<int>, 2> movedSmall(std::move(small));
+    ASSERT_TRUE(small.empty());
+    ASSERT_EQ(*movedSmall[0], 1);
+
+    // Heap storage is stolen.
+    ArchSmallVector<std::unique_ptr<int>, 2> large;
+    for (int i = 0; i != 8; ++i) {
+        large.push_back(std::make_unique<int>(i));
+    }
+    const std::unique_ptr<int>* data = large.data();
+    movedSmall = std::move(large);
+    ASSERT_TRUE(large.empty());
+    ASSERT_TRUE(large.is_inline());
+    ASSERT_EQ(movedSmall.data(), data);
+    ASSERT_EQ(*movedSmall[7], 7);
+
+    ArchSmallVector<std::string, 3> original = { "one", "two" };
+    ArchSmallVector<std::string, 3> copy = original;
+    ASSERT_EQ(copy, original);
+    copy = { "three", "four", "five", "six" };
+    original = copy;
+    ASSERT_EQ(original.size(), 4u);
+    ASSERT_EQ(original, copy);
+    ASSERT_NE(original.data(), copy.data());
+}
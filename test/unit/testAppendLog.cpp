@@ -0,0 +1,191 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/appendLog.h>
+#include <pxr/arch/fileSystem.h>
+#include <pxr/arch/systemInfo.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pxr;
+
+static std::string
+_ReadFile(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(input),
+                       std::istreambuf_iterator<char>());
+}
+
+#if !defined(ARCH_OS_WINDOWS)
+#include <sys/resource.h>
+#endif
+
+#if !defined(ARCH_OS_WINDOWS)
+
+TEST(AppendLogTest, Append)
+{
+    const std::string path = ArchMakeTmpFileName("archAppendLog");
+    const size_t pageSize = ArchGetPageSize();
+
+    // Use one page extents so records straddle extent boundaries.
+    ArchAppendLog log(path, 1, 64 * pageSize);
+    ASSERT_TRUE(log) << log.GetError();
+    ASSERT_EQ(log.GetCommittedSize(), 0u);
+
+    std::string expected;
+    for (int i = 0; i != 1000; ++i) {
+        const std::string record = "record " + std::to_string(i) + "\n";
+        ASSERT_TRUE(log.Append(record.data(), record.size()));
+        expected += record;
+    }
+    ASSERT_EQ(log.GetCommittedSize(), expected.size());
+    ASSERT_TRUE(log.Flush());
+
+    // The file is preallocated while open and truncated when closed.
+    ASSERT_GE(ArchGetFileLength(path.c_str()), int64_t(expected.size()));
+    ASSERT_TRUE(log.Close()) << log.GetError();
+    ASSERT_FALSE(log);
+    ASSERT_EQ(_ReadFile(path), expected);
+
+    // Reopening appends to the existing contents.
+    ArchAppendLog reopened(path, 1, 64 * pageSize);
+    ASSERT_TRUE(reopened) << reopened.GetError();
+    ASSERT_EQ(reopened.GetCommittedSize(), expected.size());
+    ASSERT_TRUE(reopened.Append("more\n", 5));
+    ASSERT_TRUE(reopened.Close());
+    ASSERT_EQ(_ReadFile(path), expected + "more\n");
+
+    ArchUnlinkFile(path.c_str());
+}
+
+TEST(AppendLogTest, ConcurrentReserveAndCommit)
+{
+    struct Record {
+        uint32_t thread;
+        uint32_t sequence;
+        char payload[24];
+    };
+    const size_t numThreads = 8;
+    const size_t numRecords = 20000;
+
+    const std::string path = ArchMakeTmpFileName("archAppendLog");
+    {
+        ArchAppendLog log(path, 1 << 20);
+        ASSERT_TRUE(log) << log.GetError();
+
+        std::vector<std::thread> threads;
+        for (uint32_t t = 0; t != numThreads; ++t) {
+            threads.emplace_back([&log, t]() {
+                for (uint32_t i = 0; i != numRecords; ++i) {
+                    Record record = { t, i, "payload" };
+                    uint64_t offset;
+                    char* slot = log.Reserve(sizeof(record), &offset);
+                    ASSERT_NE(slot, nullptr);
+                    memcpy(slot, &record, sizeof(record));
+                    ASSERT_TRUE(log.Commit(offset, sizeof(record)));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        ASSERT_EQ(log.GetCommittedSize(),
+                  numThreads * numRecords * sizeof(Record));
+    }
+
+    // Every record is present, and each thread's appear in order.
+    const std::string contents = _ReadFile(path);
+    ASSERT_EQ(contents.size(), numThreads * numRecords * sizeof(Record));
+    std::vector<uint32_t> next(numThreads, 0);
+    for (size_t i = 0; i != contents.size(); i += sizeof(Record)) {
+        Record record;
+        memcpy(&record, contents.data() + i, sizeof(record));
+        ASSERT_LT(record.thread, numThreads);
+        ASSERT_EQ(record.sequence, next[record.thread]++);
+        ASSERT_STREQ(record.payload, "payload");
+    }
+
+    ArchUnlinkFile(path.c_str());
+}
+
+TEST(AppendLogTest, MaxSize)
+{
+    const std::string path = ArchMakeTmpFileName("archAppendLog");
+    const size_t pageSize = ArchGetPageSize();
+
+    ArchAppendLog log(path, pageSize, 2 * pageSize);
+    ASSERT_TRUE(log) << log.GetError();
+    const std::vector<char> page(pageSize, 'x');
+    ASSERT_TRUE(log.Append(page.data(), page.size()));
+    uint64_t offset;
+    ASSERT_EQ(log.Reserve(pageSize + 1, &offset), nullptr);
+    ASSERT_TRUE(log.Append(page.data(), page.size()));
+    ASSERT_FALSE(log.Append("x", 1));
+    ASSERT_TRUE(log.Close());
+    ASSERT_EQ(ArchGetFileLength(path.c_str()), int64_t(2 * pageSize));
+
+    ArchUnlinkFile(path.c_str());
+}
+
+TEST(AppendLogTest, FailedPreGrow)
+{
+    const std::string path = ArchMakeTmpFileName("archAppendLog");
+    const size_t pageSize = ArchGetPageSize();
+
+    ArchAppendLog log(path, pageSize, 64 * pageSize);
+    ASSERT_TRUE(log) << log.GetError();
+
+    // Keep the file from growing past its first extent while the flush
+    // thread tries to map the next one.
+    struct rlimit limit;
+    ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &limit), 0);
+    const struct rlimit restricted = { pageSize, limit.rlim_max };
+    void (*handler)(int) = signal(SIGXFSZ, SIG_IGN);
+    ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &restricted), 0);
+
+    const std::string record(pageSize * 3 / 4, 'x');
+    ASSERT_TRUE(log.Append(record.data(), record.size()));
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(3 * ArchAppendLog::FlushIntervalMs));
+
+    ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+    signal(SIGXFSZ, handler);
+
+    // No record was lost, so the failure isn't reported.
+    ASSERT_TRUE(log.GetError().empty()) << log.GetError();
+    ASSERT_TRUE(log.Append(record.data(), record.size()));
+    ASSERT_TRUE(log.Close()) << log.GetError();
+    ASSERT_EQ(_ReadFile(path), record + record);
+
+    ArchUnlinkFile(path.c_str());
+}
+
+#endif
+
+TEST(AppendLogTest, Closed)
+{
+    ArchAppendLog log;
+    ASSERT_FALSE(log);
+    uint64_t offset;
+    ASSERT_EQ(log.Reserve(1, &offset), nullptr);
+    ASSERT_FALSE(log.Append("x", 1));
+    ASSERT_TRUE(log.Close());
+
+    ArchAppendLog missing("/nonexistent/dir/archAppendLog");
+    ASSERT_FALSE(missing);
+    ASSERT_FALSE(missing.GetError().empty());
+}
@@ -6,12 +6,17 @@
 // Modified by Jeremy Retailleau.
 
 #include <pxr/arch/library.h>
+#include <pxr/arch/symbols.h>
 #include <pxr/arch/systemInfo.h>
 #include <archTest/abi.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <cstdlib>
+#include <exception>
 #include <string>
+#include <utility>
+#include <vector>
 
 using namespace pxr;
 
@@ -47,6 +52,13 @@ TEST(ArchABITest, Library)
         (NewDerived)ArchLibraryGetSymbolAddress(plugin, "newDerived");
     ASSERT_NE(newPluginDerived, nullptr);
 
+#if defined(ARCH_OS_LINUX)
+    // The module registry knows about the library.
+    const ArchModuleInfo* module = ArchFindModule((void*)newPluginDerived);
+    ASSERT_NE(module, nullptr);
+    ASSERT_NE(module->path.find("libarchTestPlugin"), std::string::npos);
+#endif
+
     // Fail to get symbol from library.
     auto symbol =
         (NewDerived)ArchLibraryGetSymbolAddress(plugin, "incorrect");
@@ -66,6 +78,141 @@ TEST(ArchABITest, Library)
     ASSERT_EQ(status, 0);
 }
 
+TEST(ArchABITest, LibraryClass)
+{
+    std::string path = std::getenv("PLUGIN_PATH");
+#if defined(ARCH_OS_WINDOWS)
+    path += "\\archTestPlugin.dll";
+#elif defined(ARCH_OS_DARWIN)
+    path += "/libarchTestPlugin.dylib";
+#else
+    path += "/libarchTestPlugin.so";
+#endif
+
+    for (unsigned int options : { 0u, unsigned(ArchLibrary::USE_SYMBOL_TABLE) }) {
+        ArchLibrary plugin(path, ARCH_LIBRARY_NOW, options);
+        ASSERT_TRUE(plugin);
+        ASSERT_EQ(plugin.GetError(), "");
+        ASSERT_NE(plugin.GetHandle(), nullptr);
+
+        void* expected =
+            ArchLibraryGetSymbolAddress(plugin.GetHandle(), "newDerived");
+        ASSERT_NE(expected, nullptr);
+
+        // Resolve in a batch, including a missing symbol.
+        const char* names[] = { "newDerived", "incorrect", "newDerived" };
+        void* addresses[3];
+        ASSERT_EQ(plugin.GetSymbolAddresses(names, 3, addresses), 2u);
+        ASSERT_EQ(addresses[0], expected);
+        ASSERT_EQ(addresses[1], nullptr);
+        ASSERT_EQ(addresses[2], expected);
+
+        // Cached lookups.
+        ASSERT_EQ(plugin.GetSymbolAddress("newDerived"), expected);
+        ASSERT_EQ(plugin.GetSymbolAddress("incorrect"), nullptr);
+
+        using NewDerived = ArchAbiBase2* (*)();
+        ArchAbiBase2* derived = ((NewDerived)expected)();
+        ASSERT_NE(derived, nullptr);
+        delete derived;
+    }
+
+    // Move assignment closes the target and takes over the source.
+    ArchLibrary library;
+    ASSERT_FALSE(library);
+    library = ArchLibrary(path, ARCH_LIBRARY_NOW);
+    ASSERT_TRUE(library);
+    ASSERT_NE(library.GetSymbolAddress("newDerived"), nullptr);
+    ArchLibrary moved(std::move(library));
+    ASSERT_TRUE(moved);
+    ASSERT_NE(moved.GetSymbolAddress("newDerived"), nullptr);
+    library = std::move(moved);
+    ASSERT_TRUE(library);
+
+#if defined(ARCH_OS_LINUX)
+    // The symbol table must agree with dlsym, including for versioned
+    // symbols, indirect functions and symbols from dependencies.
+    ArchLibrary libm("libm.so.6", ARCH_LIBRARY_NOW,
+                     ArchLibrary::USE_SYMBOL_TABLE);
+    ASSERT_TRUE(libm) << libm.GetError();
+    const char* names[] = {
+        "cos", "sin", "exp", "log", "pow", "lgamma", "fabs", "signgam",
+        "malloc", "missing_symbol"
+    };
+    void* addresses[10];
+    libm.GetSymbolAddresses(names, 10, addresses);
+    for (size_t i = 0; i != 10; ++i) {
+        ASSERT_EQ(addresses[i],
+                  ArchLibraryGetSymbolAddress(libm.GetHandle(), names[i]))
+            << names[i];
+    }
+#endif
+}
+
+TEST(ArchABITest, LibraryClassOpenError)
+{
+    ArchLibrary library("/incorrect", ARCH_LIBRARY_LAZY);
+    ASSERT_FALSE(library);
+    ASSERT_NE(library.GetError(), "");
+    ASSERT_EQ(library.GetHandle(), nullptr);
+    ASSERT_EQ(library.GetSymbolAddress("main"), nullptr);
+}
+
+TEST(ArchABITest, PreloadLibraries)
+{
+    std::string path = std::getenv("PLUGIN_PATH");
+#if defined(ARCH_OS_WINDOWS)
+    path += "\\archTestPlugin.dll";
+#elif defined(ARCH_OS_DARWIN)
+    path += "/libarchTestPlugin.dylib";
+#else
+    path += "/libarchTestPlugin.so";
+#endif
+
+    // The arch library needs the C++ standard library.
+    std::string archPath, stdPath;
+    ASSERT_TRUE(ArchGetAddressInfo(
+        reinterpret_cast<void*>(&ArchLibraryOpen),
+        &archPath, nullptr, nullptr, nullptr));
+    ASSERT_TRUE(ArchGetAddressInfo(
+        reinterpret_cast<void*>(&std::terminate),
+        &stdPath, nullptr, nullptr, nullptr));
+
+    const std::vector<ArchPreloadedLibrary> libraries = ArchPreloadLibraries(
+        { path, "/incorrect", archPath, stdPath }, ARCH_LIBRARY_LAZY, 4);
+    ASSERT_EQ(libraries.size(), 4u);
+
+    const ArchPreloadedLibrary& plugin = libraries[0];
+    ASSERT_EQ(plugin.path, path);
+    ASSERT_NE(plugin.handle, nullptr) << plugin.error;
+    ASSERT_EQ(plugin.error, "");
+    ASSERT_GT(plugin.nanoseconds, 0);
+    ASSERT_NE(ArchLibraryGetSymbolAddress(plugin.handle, "newDerived"),
+              nullptr);
+
+    const ArchPreloadedLibrary& missing = libraries[1];
+    ASSERT_EQ(missing.handle, nullptr);
+    ASSERT_NE(missing.error, "");
+
+    const ArchPreloadedLibrary& arch = libraries[2];
+    const ArchPreloadedLibrary& stdLib = libraries[3];
+    ASSERT_NE(arch.handle, nullptr) << arch.error;
+    ASSERT_NE(stdLib.handle, nullptr) << stdLib.error;
+
+#if defined(ARCH_OS_LINUX)
+    ASSERT_NE(std::find(arch.needed.begin(), arch.needed.end(),
+                        "libstdc++.so.6"), arch.needed.end());
+    ASSERT_EQ(stdLib.batch, 0);
+    ASSERT_EQ(arch.batch, 1);
+#endif
+
+    for (const ArchPreloadedLibrary& library : libraries) {
+        if (library.handle) {
+            ASSERT_EQ(ArchLibraryClose(library.handle), 0);
+        }
+    }
+}
+
 TEST(ArchABITest, LibraryOpenError)
 {
     std::string path = "/incorrect";
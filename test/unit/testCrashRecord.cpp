@@ -0,0 +1,159 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/crashRecord.h>
+#include <pxr/arch/defines.h>
+#include <pxr/arch/fileSystem.h>
+#include <pxr/arch/library.h>
+#include <pxr/arch/stackTrace.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(ARCH_OS_WINDOWS)
+#include <unistd.h>
+#endif
+
+using namespace pxr;
+
+TEST(CrashRecordTest, ReadInvalid)
+{
+    const std::string path = ArchMakeTmpFileName("crashRecordInvalid");
+    FILE* file = ArchOpenFile(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    fputs("not a crash record", file);
+    fclose(file);
+
+    ArchCrashRecord record;
+    std::string error;
+    ASSERT_FALSE(ArchReadCrashRecord(path, &record, &error));
+    ASSERT_FALSE(error.empty());
+    ArchUnlinkFile(path.c_str());
+
+    ASSERT_FALSE(ArchReadCrashRecord(path, &record, &error));
+}
+
+#if defined(ARCH_OS_LINUX)
+
+TEST(CrashRecordTest, WriteAndSymbolize)
+{
+    std::string path;
+    const int fd = ArchMakeTmpFile("crashRecord", &path);
+    ASSERT_NE(fd, -1);
+
+    // Not enabled.
+    ASSERT_FALSE(ArchWriteCrashRecord(fd, "Test"));
+
+    ArchSetInProcessCrashReporting(true);
+    ArchSetProgramInfoForErrors("CrashRecordTest", "some value");
+    const std::vector<std::string> lines = { "first line\n", "second line\n" };
+    ArchSetExtraLogInfoForErrors("CrashRecordLog", &lines);
+
+    std::atomic<bool> done{false};
+    std::thread thread([&done]() {
+        while (!done) {
+            std::this_thread::yield();
+        }
+    });
+
+    const bool written = ArchWriteCrashRecord(fd, "Test Crash Record");
+    done = true;
+    thread.join();
+    close(fd);
+
+    ArchSetExtraLogInfoForErrors("CrashRecordLog", nullptr);
+    ArchSetProgramInfoForErrors("CrashRecordTest", "");
+    ArchSetInProcessCrashReporting(false);
+    ASSERT_TRUE(written);
+
+    ArchCrashRecord record;
+    std::string error;
+    ASSERT_TRUE(ArchReadCrashRecord(path, &record, &error)) << error;
+    ArchUnlinkFile(path.c_str());
+
+    ASSERT_EQ(record.version, unsigned(ARCH_CRASH_RECORD_VERSION));
+    ASSERT_EQ(record.pid, uint64_t(getpid()));
+    ASSERT_EQ(record.reason, "Test Crash Record");
+
+    ASSERT_GE(record.threads.size(), 2u);
+    size_t numReporting = 0;
+    for (const ArchCrashRecord::Thread& t : record.threads) {
+        ASSERT_FALSE(t.flags & ArchCrashRecordThreadNoResponse);
+        ASSERT_FALSE(t.frames.empty());
+        ASSERT_FALSE(t.registers.empty());
+        if (t.flags & ArchCrashRecordThreadReporting) {
+            ++numReporting;
+        }
+    }
+    ASSERT_EQ(numReporting, 1u);
+
+    bool foundArch = false;
+    for (const ArchCrashRecord::Module& module : record.modules) {
+        ASSERT_LT(module.start, module.end);
+        if (module.path.find("libPxrArch") != std::string::npos) {
+            foundArch = true;
+        }
+    }
+    ASSERT_TRUE(foundArch);
+
+    ASSERT_EQ(record.programInfo.size(), 1u);
+    ASSERT_EQ(record.programInfo[0].first, "CrashRecordTest");
+    ASSERT_EQ(record.programInfo[0].second, "some value");
+    ASSERT_EQ(record.extraLogInfo.size(), 1u);
+    ASSERT_EQ(record.extraLogInfo[0].first, "CrashRecordLog");
+    ASSERT_EQ(record.extraLogInfo[0].second, "first line\nsecond line\n");
+
+    std::ostringstream out;
+    ArchSymbolizeCrashRecord(record, out);
+    const std::string report = out.str();
+    ASSERT_NE(report.find("Reason: Test Crash Record"), std::string::npos)
+        << report;
+    ASSERT_NE(report.find("pxr::ArchWriteCrashRecord"), std::string::npos)
+        << report;
+}
+
+TEST(CrashRecordTest, LibraryLoadedAfterEnabling)
+{
+    const std::string pluginPath =
+        std::string(std::getenv("PLUGIN_PATH")) + "/libarchTestPlugin.so";
+
+    // Crash records can't refresh the module registry, so loading a
+    // library while they're enabled must.
+    ArchSetInProcessCrashReporting(true);
+    void* plugin = ArchLibraryOpen(pluginPath, ARCH_LIBRARY_NOW);
+    ASSERT_NE(plugin, nullptr) << ArchLibraryError();
+
+    std::string path;
+    const int fd = ArchMakeTmpFile("crashRecord", &path);
+    ASSERT_NE(fd, -1);
+    const bool written = ArchWriteCrashRecord(fd, "Test Plugin");
+    close(fd);
+    ArchSetInProcessCrashReporting(false);
+    ArchLibraryClose(plugin);
+    ASSERT_TRUE(written);
+
+    ArchCrashRecord record;
+    std::string error;
+    ASSERT_TRUE(ArchReadCrashRecord(path, &record, &error)) << error;
+    ArchUnlinkFile(path.c_str());
+
+    bool foundPlugin = false;
+    for (const ArchCrashRecord::Module& module : record.modules) {
+        if (module.path.find("libarchTestPlugin") != std::string::npos) {
+            foundPlugin = true;
+        }
+    }
+    ASSERT_TRUE(foundPlugin);
+}
+
+#endif
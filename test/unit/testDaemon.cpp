@@ -0,0 +1,109 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/daemon.h>
+#include <pxr/arch/defines.h>
+#include <gtest/gtest.h>
+
+#if defined(ARCH_OS_LINUX) || defined(ARCH_OS_DARWIN)
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+
+using namespace pxr;
+
+static bool
+IsOpen(int fd)
+{
+    return fcntl(fd, F_GETFD) != -1;
+}
+
+// Runs ArchCloseAllFiles() in a child process and returns its exit status.
+// The child exits with 0 only if exactly the exceptions remain open.
+static int
+CloseAllFilesInChild(int nOpen, const int* openFds,
+                     int nExcept, const int* exceptFds)
+{
+    const pid_t pid = fork();
+    if (pid == 0) {
+        if (ArchCloseAllFiles(nExcept, exceptFds) != 0) {
+            _exit(1);
+        }
+        for (int i = 0; i != nOpen; ++i) {
+            bool excepted = false;
+            for (int j = 0; j != nExcept; ++j) {
+                excepted |= (exceptFds[j] == openFds[i]);
+            }
+            if (IsOpen(openFds[i]) != excepted) {
+                _exit(2 + i);
+            }
+        }
+        _exit(0);
+    }
+
+    int status = 0;
+    if (pid == -1 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+        return -1;
+    }
+    return WEXITSTATUS(status);
+}
+
+TEST(DaemonTest, CloseAllFiles)
+{
+    // Open a few descriptors, including a high one.
+    int fds[5];
+    for (int i = 0; i != 4; ++i) {
+        fds[i] = open("/dev/null", O_RDONLY);
+        ASSERT_NE(fds[i], -1);
+    }
+    fds[4] = dup2(fds[0], 1000);
+    ASSERT_EQ(fds[4], 1000);
+
+    // Close everything.
+    ASSERT_EQ(CloseAllFilesInChild(5, fds, 0, nullptr), 0);
+
+    // Keep some, unsorted, with duplicates and invalid descriptors.
+    const int except[] = { fds[4], -1, fds[1], 1000, fds[3], 5000 };
+    ASSERT_EQ(CloseAllFilesInChild(5, fds, 6, except), 0);
+
+    // Keep one.
+    ASSERT_EQ(CloseAllFilesInChild(5, fds, 1, &fds[2]), 0);
+
+    for (int fd : fds) {
+        close(fd);
+    }
+}
+
+TEST(DaemonTest, CloseAllFilesHighLimit)
+{
+    // Raise the limit on open files as far as allowed.  Closing all files
+    // shouldn't take time proportional to it.
+    struct rlimit limits;
+    ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &limits), 0);
+    const struct rlimit saved = limits;
+    limits.rlim_cur = limits.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limits);
+
+    const int fd = open("/dev/null", O_RDONLY);
+    ASSERT_NE(fd, -1);
+
+    const auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(CloseAllFilesInChild(1, &fd, 0, nullptr), 0);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    RecordProperty("Milliseconds", std::to_string(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            elapsed).count()));
+
+    close(fd);
+    setrlimit(RLIMIT_NOFILE, &saved);
+}
+
+#endif
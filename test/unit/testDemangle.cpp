@@ -5,10 +5,21 @@
 //
 // Modified by Jeremy Retailleau.
 
+#include <pxr/arch/defines.h>
 #include <pxr/arch/demangle.h>
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+#include <cxxabi.h>
+#endif
 
 using namespace pxr;
 
@@ -36,6 +47,11 @@ class MangledClass2 {
     };
 };
 
+namespace {
+struct MangledAnonymousStruct {
+};
+}
+
 TEST(DemangleTest, Bool)
 {
     const std::type_info& typeInfo = typeid(bool);
@@ -240,3 +256,232 @@ TEST(DemangleTest, IncorrectType)
     ASSERT_EQ(ArchGetDemangled(badType), "");
 #endif
 }
+
+TEST(DemangleTest, Cached)
+{
+    const std::type_info& typeInfo = typeid(MangledClass2::SubClass);
+    const std::string_view cached = ArchGetDemangledCached(typeInfo);
+
+    ASSERT_EQ(cached, ArchGetDemangled(std::string(typeInfo.name())));
+    ASSERT_EQ(cached, "MangledClass2::SubClass");
+
+    // Repeated lookups return the same storage, whether by type or by name.
+    ASSERT_EQ(ArchGetDemangledCached(typeInfo).data(), cached.data());
+    ASSERT_EQ(ArchGetDemangledCached<MangledClass2::SubClass>().data(),
+              cached.data());
+    const std::string mangledName = typeInfo.name();
+    ASSERT_EQ(ArchGetDemangledCached(mangledName).data(), cached.data());
+
+#if !defined(ARCH_OS_WINDOWS)
+    ASSERT_TRUE(ArchGetDemangledCached("type_that_doesnt_exist").empty());
+    ASSERT_TRUE(ArchGetDemangledCached("type_that_doesnt_exist").empty());
+#endif
+}
+
+TEST(DemangleTest, CachedThreads)
+{
+    std::vector<std::string_view> results(8);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i != results.size(); ++i) {
+        threads.emplace_back([&results, i]() {
+            for (int j = 0; j != 1000; ++j) {
+                results[i] = ArchGetDemangledCached<
+                    MangledTemplatedClass<MangledEnum>>();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (const std::string_view& result : results) {
+        ASSERT_EQ(result, "MangledTemplatedClass<MangledEnum>");
+        ASSERT_EQ(result.data(), results[0].data());
+    }
+}
+
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+
+static std::string
+_CxaDemangle(const char* mangled)
+{
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    std::string result = demangled ? demangled : "";
+    free(demangled);
+    return result;
+}
+
+TEST(DemangleTest, ToBuffer)
+{
+    const char* const symbols[] = {
+        "_Z3foov",
+        "_Z3fooidPKcRKSsOi",
+        "_ZNK3Foo3barEv",
+        "_ZNVK3Foo3barEv",
+        "_ZNR3Foo3barEv",
+        "_ZNO3Foo3barEv",
+        "_ZN3FooC2Ev",
+        "_ZN3FooD0Ev",
+        "_ZN3Foo3BarIiEC1ERKS1_",
+        "_ZNSsC1Ev",
+        "_ZNKSs4sizeEv",
+        "_ZlsRSoRKSs",
+        "_ZNSt6vectorIiSaIiEE9push_backERKi",
+        "_ZNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEC1EPKcRKS3_",
+        "_ZNSt3mapIiSt4pairIKiPvESt4lessIiESaIS3_EEixERS2_",
+        "_Z3fooIiEvT_",
+        "_ZN1AIiE1fIcEEvT_",
+        "_Z1fILb1ELi5ELj3ELc65EEvv",
+        "_Z1fILln5EEvv",
+        "_Z1fILy7ELs2EEvv",
+        "_Z1fIlEvv",
+        "_Z1fIJidEEvDpT_",
+        "_Z1fIJEEvDpT_",
+        "_Z1fIJEiEvv",
+        "_Z1fIiJEEvv",
+        "_Z1fI1AIiJEEJEEvv",
+        "_Z1fIJiEEvDpRKT_",
+        "_Z1fIRiEvOT_",
+        "_Z1fIOiEvRT_",
+        "_Z1fIOiEvOT_",
+        "_ZNSt6vectorImSaImEE17_M_realloc_insertIJRKmEEEvN9__gnu_cxx"
+            "17__normal_iteratorIPmS1_EEDpOT_",
+        "_ZNSt5dequeIlSaIlEE16_M_push_back_auxIJRKlEEEvDpOT_",
+        "_Z1fISt8functionIFviEEEvv",
+        "_ZN3FooltIiEEbv",
+        "_ZN3FoocviEv",
+        "_ZN3FooplERKS_",
+        "_Znwm",
+        "_ZdlPv",
+        "_Z3fooB5cxx11v",
+        "_ZN1AB3fooC1Ev",
+        "_ZN1AB3fooB3barD2Ev",
+        "_ZN1AB3fooIiEC1Ev",
+        "_ZNSt8ios_base7failureB5cxx11C1EPKcRKSt10error_code",
+        "_ZNSt8ios_base7failureB5cxx11D0Ev",
+        "_ZL3foov",
+        "_ZN3pxrL9_FunctionEv",
+        "_ZZL3foovE1x",
+        "_ZN12_GLOBAL__N_13fooEv",
+        "_ZZ3fooiE3bar",
+        "_ZZ4mainENKUlvE_clEv",
+        "_ZZ4mainENKUliRKdE0_clEiS1_",
+        "_ZZ3foovE1x_0",
+        "_ZZNKSt7__cxx1112regex_traitsIcE16lookup_classnameIPKcEENS1_"
+            "10_RegexMaskET_S6_bE12__classnames",
+        "_ZGVZ1fIiEvvE1x",
+        "_Z3foov.constprop.0",
+        "_Z3foov.part.0.isra.0",
+        "_ZTV3Foo",
+        "_ZTI3Foo",
+        "_ZTS3Foo",
+        "_ZTT3Foo",
+        "_ZThn8_N3Foo3barEv",
+        "_ZTv0_n24_N3Foo3barEv",
+        "_ZGVZ3foovE1x",
+        "_ZTW1x",
+        "_Z3fooPVKiPrPc",
+        "_Z3fooDnDiDs",
+        "i",
+        "PKc",
+        "3Foo",
+        "N3Foo3BarE",
+        "St6vectorIiSaIiEE",
+        typeid(MangledClass2::SubClass).name(),
+        typeid(MangledTemplatedClass<MangledTemplatedClass<int>>).name(),
+        typeid(std::vector<std::string>).name(),
+    };
+
+    char buffer[512];
+    for (const char* symbol : symbols) {
+        ASSERT_TRUE(ArchDemangleToBuffer(symbol, buffer, sizeof(buffer)))
+            << symbol;
+        ASSERT_EQ(std::string(buffer), _CxaDemangle(symbol)) << symbol;
+    }
+}
+
+TEST(DemangleTest, ToBufferOverflow)
+{
+    const char* const symbol = "_ZNSt6vectorIiSaIiEE9push_backERKi";
+    const std::string expected = _CxaDemangle(symbol);
+
+    std::vector<char> buffer(expected.size() + 1, 'x');
+    ASSERT_TRUE(ArchDemangleToBuffer(symbol, buffer.data(), buffer.size()));
+    ASSERT_EQ(std::string(buffer.data()), expected);
+
+    buffer.assign(expected.size(), 'x');
+    ASSERT_FALSE(ArchDemangleToBuffer(symbol, buffer.data(), buffer.size()));
+    ASSERT_EQ(buffer[0], '\0');
+    ASSERT_FALSE(ArchDemangleToBuffer(symbol, buffer.data(), 0));
+}
+
+TEST(DemangleTest, ToBufferFallback)
+{
+    // Pointers to functions, including function types reached through
+    // substitutions, decorated pack expansions of more than one element and
+    // destructors of lambdas are not handled by the allocation-free subset.
+    char buffer[128];
+    for (const char* symbol : {"_Z3fooPFviE", "_Z1fIFviEEvPT_",
+                               "_Z1fFviEPS_", "_Z1fIJidEEvDpRKT_",
+                               "_Z1fIJEEvDpOT_", "_ZZ4mainENUlvE_D2Ev"}) {
+        ASSERT_FALSE(ArchDemangleToBuffer(symbol, buffer, sizeof(buffer)))
+            << symbol;
+        ASSERT_TRUE(ArchDemangleToBuffer(symbol, buffer, sizeof(buffer),
+                                         true)) << symbol;
+        ASSERT_EQ(std::string(buffer), _CxaDemangle(symbol)) << symbol;
+    }
+
+    for (const char* invalid : {"", "_Z", "_Z3fo", "_ZN3Foo", "_Z3foov.",
+                                "_ZNSt6vectorIiSaIiEE9push_backERKS9_"}) {
+        ASSERT_FALSE(ArchDemangleToBuffer(invalid, buffer, sizeof(buffer)))
+            << invalid;
+    }
+}
+
+#endif
+
+template <class T>
+static void
+_TestTypeName()
+{
+    ASSERT_EQ(ArchGetTypeName<T>(), ArchGetDemangled<T>());
+}
+
+TEST(DemangleTest, TypeName)
+{
+    static_assert(ArchGetTypeName<int>() == "int");
+    static_assert(ArchGetTypeName<const MangledStruct&>() == "MangledStruct");
+
+    _TestTypeName<bool>();
+    _TestTypeName<char>();
+    _TestTypeName<unsigned char>();
+    _TestTypeName<short>();
+    _TestTypeName<unsigned short>();
+    _TestTypeName<long>();
+    _TestTypeName<unsigned long>();
+    _TestTypeName<long long>();
+    _TestTypeName<unsigned long long>();
+    _TestTypeName<double>();
+    _TestTypeName<int*>();
+    _TestTypeName<const char*>();
+    _TestTypeName<const volatile int*>();
+    _TestTypeName<const int&>();
+    _TestTypeName<MangledStruct>();
+    _TestTypeName<MangledStructAlias>();
+    _TestTypeName<MangledEnum>();
+    _TestTypeName<MangledClass2::SubClass>();
+    _TestTypeName<std::string>();
+    _TestTypeName<MangledTemplatedClass<int>>();
+    _TestTypeName<MangledTemplatedClass<const char*>>();
+    _TestTypeName<MangledTemplatedClass<std::string>>();
+    _TestTypeName<MangledTemplatedClass<MangledTemplatedClass<long>>>();
+    _TestTypeName<
+        MangledTemplatedClass<MangledTemplatedClass<std::string>>>();
+    _TestTypeName<MangledTemplatedClass<const std::string*>>();
+    _TestTypeName<MangledAnonymousStruct>();
+    _TestTypeName<MangledTemplatedClass<MangledAnonymousStruct>>();
+    _TestTypeName<std::function<void()>>();
+    _TestTypeName<std::function<int(double, const char*)>>();
+    _TestTypeName<std::nullptr_t>();
+    _TestTypeName<std::nullptr_t*>();
+}
@@ -0,0 +1,146 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/env.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace pxr;
+
+TEST(EnvTest, Cached)
+{
+    ASSERT_TRUE(ArchSetEnv("ARCH_TEST_ENV_CACHED", "first", true));
+    ArchRemoveEnv("ARCH_TEST_ENV_MISSING");
+    ArchRefreshEnvCache();
+
+    ASSERT_TRUE(ArchHasEnvCached("ARCH_TEST_ENV_CACHED"));
+    ASSERT_EQ(ArchGetEnvCached("ARCH_TEST_ENV_CACHED"), "first");
+    ASSERT_FALSE(ArchHasEnvCached("ARCH_TEST_ENV_MISSING"));
+    ASSERT_TRUE(ArchGetEnvCached("ARCH_TEST_ENV_MISSING").empty());
+
+    // Changes are only visible after a refresh, and values returned by
+    // the previous snapshot remain valid.
+    const std::string_view first = ArchGetEnvCached("ARCH_TEST_ENV_CACHED");
+    ASSERT_TRUE(ArchSetEnv("ARCH_TEST_ENV_CACHED", "second", true));
+    ASSERT_TRUE(ArchSetEnv("ARCH_TEST_ENV_MISSING", "", true));
+    ASSERT_EQ(ArchGetEnvCached("ARCH_TEST_ENV_CACHED"), "first");
+    ASSERT_FALSE(ArchHasEnvCached("ARCH_TEST_ENV_MISSING"));
+
+    ArchRefreshEnvCache();
+    ASSERT_EQ(ArchGetEnvCached("ARCH_TEST_ENV_CACHED"), "second");
+    ASSERT_TRUE(ArchHasEnvCached("ARCH_TEST_ENV_MISSING"));
+    ASSERT_TRUE(ArchGetEnvCached("ARCH_TEST_ENV_MISSING").empty());
+    ASSERT_EQ(first, "first");
+
+    ASSERT_TRUE(ArchRemoveEnv("ARCH_TEST_ENV_CACHED"));
+    ASSERT_TRUE(ArchRemoveEnv("ARCH_TEST_ENV_MISSING"));
+    ArchRefreshEnvCache();
+    ASSERT_FALSE(ArchHasEnvCached("ARCH_TEST_ENV_CACHED"));
+}
+
+TEST(EnvTest, CachedMatchesEnviron)
+{
+    ArchRefreshEnvCache();
+    for (char** entry = ArchEnviron(); entry && *entry; ++entry) {
+        const std::string_view variable(*entry);
+        const size_t separator = variable.find('=');
+        if (separator == std::string_view::npos || separator == 0) {
+            continue;
+        }
+        const std::string name(variable.substr(0, separator));
+        ASSERT_EQ(ArchGetEnvCached(name), ArchGetEnv(name)) << name;
+    }
+}
+
+TEST(EnvTest, CachedThreads)
+{
+    ASSERT_TRUE(ArchSetEnv("ARCH_TEST_ENV_THREADS", "value", true));
+    ArchRefreshEnvCache();
+
+    std::vector<int> matches(4, 0);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i != matches.size(); ++i) {
+        threads.emplace_back([&matches, i]() {
+            for (int j = 0; j != 10000; ++j) {
+                matches[i] +=
+                    ArchGetEnvCached("ARCH_TEST_ENV_THREADS") == "value";
+            }
+        });
+    }
+
+    // Publishing new snapshots must not disturb the readers.
+    for (int i = 0; i != 10; ++i) {
+        ArchRefreshEnvCache();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int count : matches) {
+        ASSERT_EQ(count, 10000);
+    }
+    ASSERT_TRUE(ArchRemoveEnv("ARCH_TEST_ENV_THREADS"));
+}
+
+#if defined(ARCH_OS_WINDOWS)
+#define REF(name) "%" name "%"
+#else
+#define REF(name) "${" name "}"
+#endif
+
+TEST(EnvTest, ExpandCached)
+{
+    ASSERT_TRUE(ArchSetEnv("ARCH_TEST_ENV_A", "alpha", true));
+    ASSERT_TRUE(ArchSetEnv("ARCH_TEST_ENV_B", REF("ARCH_TEST_ENV_A"), true));
+    ArchRemoveEnv("ARCH_TEST_ENV_UNSET");
+    ArchRefreshEnvCache();
+
+    // Inputs for which single-pass expansion agrees with the legacy one.
+    const std::vector<std::string> inputs = {
+        "",
+        "no references",
+        REF("ARCH_TEST_ENV_A"),
+        "x" REF("ARCH_TEST_ENV_A") "/" REF("ARCH_TEST_ENV_A") "y",
+        "a" REF("ARCH_TEST_ENV_UNSET") "b",
+#if !defined(ARCH_OS_WINDOWS)
+        "${}${ARCH_TEST_ENV_A}",
+        "$ARCH_TEST_ENV_A ${ARCH_TEST_ENV_A",
+        "$${ARCH_TEST_ENV_A}}",
+#endif
+    };
+    for (const std::string& input : inputs) {
+        ASSERT_EQ(ArchExpandEnvironmentVariablesCached(input),
+                  ArchExpandEnvironmentVariables(input)) << input;
+    }
+
+    // Values are not expanded again.
+    ASSERT_EQ(ArchExpandEnvironmentVariablesCached(REF("ARCH_TEST_ENV_B")),
+              REF("ARCH_TEST_ENV_A"));
+    ASSERT_EQ(ArchExpandEnvironmentVariables(REF("ARCH_TEST_ENV_B")),
+              "alpha");
+
+    // The output buffer is reused.
+    std::string result;
+    ArchExpandEnvironmentVariablesCached(
+        "a/" REF("ARCH_TEST_ENV_A") "/b", &result);
+    ASSERT_EQ(result, "a/alpha/b");
+    ArchExpandEnvironmentVariablesCached(REF("ARCH_TEST_ENV_A"), &result);
+    ASSERT_EQ(result, "alpha");
+
+    const std::vector<std::string> batch =
+        ArchExpandEnvironmentVariablesCached(inputs);
+    ASSERT_EQ(batch.size(), inputs.size());
+    for (size_t i = 0; i != inputs.size(); ++i) {
+        ASSERT_EQ(batch[i], ArchExpandEnvironmentVariables(inputs[i]));
+    }
+
+    ASSERT_TRUE(ArchRemoveEnv("ARCH_TEST_ENV_A"));
+    ASSERT_TRUE(ArchRemoveEnv("ARCH_TEST_ENV_B"));
+}
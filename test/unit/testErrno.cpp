@@ -8,6 +8,11 @@
 #include <pxr/arch/errno.h>
 #include <gtest/gtest.h>
 
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <vector>
+
 using namespace pxr;
 
 TEST(ErrnoTest, ErrorMessages)
@@ -16,3 +21,49 @@ TEST(ErrnoTest, ErrorMessages)
         ASSERT_NE(ArchStrerror(i), "");
     }
 }
+
+TEST(ErrnoTest, ErrorMessageViews)
+{
+    // The cached messages match the uncached ones.
+    for (int i = 0; i < 10; i++) {
+        ASSERT_EQ(ArchStrerrorView(i), ArchStrerror(i));
+    }
+    ASSERT_EQ(ArchStrerrorView(ENOENT), ArchStrerror(ENOENT));
+    ASSERT_NE(ArchStrerrorView(-1), "");
+    ASSERT_NE(ArchStrerrorView(1 << 20), "");
+
+    // Views remain valid and are shared.
+    ASSERT_EQ(ArchStrerrorView(EINVAL).data(), ArchStrerrorView(EINVAL).data());
+
+    errno = EACCES;
+    ASSERT_EQ(ArchStrerrorView(), ArchStrerror(EACCES));
+    ASSERT_EQ(errno, EACCES);
+
+    // Concurrent lookups agree.
+    std::vector<std::thread> threads;
+    std::vector<const char*> results(8);
+    for (size_t i = 0; i != results.size(); ++i) {
+        threads.emplace_back([&results, i]() {
+            results[i] = ArchStrerrorView(EPERM).data();
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (const char* result : results) {
+        ASSERT_EQ(result, results.front());
+    }
+}
+
+TEST(ErrnoTest, SignalSafeErrorMessages)
+{
+    // Look up the messages so every platform has them.
+    ArchStrerrorView(0);
+
+    const char* message = ArchStrerrorSignalSafe(ENOENT);
+    ASSERT_NE(message, nullptr);
+    ASSERT_GT(strlen(message), 0u);
+    ASSERT_NE(ArchStrerrorSignalSafe(EINVAL), nullptr);
+    ASSERT_STRNE(ArchStrerrorSignalSafe(EINVAL), message);
+}
+
@@ -6,10 +6,18 @@
 // Modified by Jeremy Retailleau.
 
 #include <pxr/arch/fileSystem.h>
+#include <pxr/arch/systemInfo.h>
 #include <gtest/gtest.h>
 
 #include <algorithm>
 #include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(ARCH_OS_LINUX)
+#include <sys/mman.h>
+#endif
 
 using namespace pxr;
 
@@ -72,6 +80,144 @@ TEST(FileSystemTest, FileOperations)
     ArchRmDir(retpath.c_str());
 }
 
+static void
+_WriteFile(std::string const& path, char const* content)
+{
+    FILE *file = ArchOpenFile(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    fputs(content, file);
+    fclose(file);
+}
+
+TEST(FileSystemTest, SharedFileMapping)
+{
+    const std::string name = ArchMakeTmpFileName("archFSShared");
+    char const * const testContent = "shared contents";
+    _WriteFile(name, testContent);
+
+    const ArchFileMappingCacheStats before = ArchGetFileMappingCacheStats();
+
+    // Requests for the same file share one mapping.
+    ArchSharedFileMapping first = ArchMapFileReadOnlyShared(name);
+    ArchSharedFileMapping second = ArchMapFileReadOnlyShared(name);
+    ASSERT_TRUE(first);
+    ASSERT_EQ(first.get(), second.get());
+    ASSERT_EQ(ArchGetFileMappingLength(first), strlen(testContent));
+    ASSERT_EQ(memcmp(testContent, first.get(), strlen(testContent)), 0);
+
+    ArchFileMappingCacheStats stats = ArchGetFileMappingCacheStats();
+    ASSERT_EQ(stats.misses, before.misses + 1);
+    ASSERT_EQ(stats.hits, before.hits + 1);
+    ASSERT_EQ(stats.mappings, before.mappings + 1);
+
+    // Unreferenced mappings stay cached and are handed out again.
+    char const *address = first.get();
+    first.reset();
+    second.reset();
+    stats = ArchGetFileMappingCacheStats();
+    ASSERT_EQ(stats.idleMappings, before.idleMappings + 1);
+    first = ArchMapFileReadOnlyShared(name);
+    ASSERT_EQ(first.get(), address);
+    ASSERT_EQ(ArchGetFileMappingCacheStats().hits, before.hits + 2);
+
+    // Replacing the file maps the new contents and releases the old mapping
+    // once it's no longer referenced.
+    const std::string replacement = name + ".new";
+    char const * const newContent = "replaced contents!";
+    _WriteFile(replacement, newContent);
+    ASSERT_EQ(rename(replacement.c_str(), name.c_str()), 0);
+    second = ArchMapFileReadOnlyShared(name);
+    ASSERT_TRUE(second);
+    ASSERT_NE(first.get(), second.get());
+    ASSERT_EQ(ArchGetFileMappingLength(second), strlen(newContent));
+    ASSERT_EQ(memcmp(newContent, second.get(), strlen(newContent)), 0);
+    ASSERT_EQ(memcmp(testContent, first.get(), strlen(testContent)), 0);
+    first.reset();
+    stats = ArchGetFileMappingCacheStats();
+    ASSERT_EQ(stats.mappings, before.mappings + 1);
+    ASSERT_EQ(stats.evictions, before.evictions + 1);
+
+    // Idle mappings beyond the budget are evicted.
+    const size_t budget = ArchGetFileMappingCacheBudget();
+    ArchSetFileMappingCacheBudget(0);
+    second.reset();
+    stats = ArchGetFileMappingCacheStats();
+    ASSERT_EQ(stats.mappings, before.mappings);
+    ASSERT_EQ(stats.idleBytes, 0u);
+    ArchSetFileMappingCacheBudget(budget);
+
+    std::string errMsg;
+    ArchUnlinkFile(name.c_str());
+    ASSERT_FALSE(ArchMapFileReadOnlyShared(name, &errMsg));
+    ASSERT_FALSE(errMsg.empty());
+    ASSERT_EQ(ArchGetFileMappingLength(ArchSharedFileMapping()), 0u);
+}
+
+#if defined(ARCH_OS_LINUX)
+
+TEST(FileSystemTest, MemoryResidency)
+{
+    // Make pages 0-3 and 8 of an anonymous mapping resident.
+    const size_t pageSize = ArchGetPageSize();
+    const size_t numPages = 16;
+    char *base = static_cast<char *>(
+        mmap(nullptr, numPages * pageSize, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    ASSERT_NE(base, MAP_FAILED);
+    madvise(base, numPages * pageSize, MADV_NOHUGEPAGE);
+    for (size_t page : {0, 1, 2, 3, 8}) {
+        base[page * pageSize] = 1;
+    }
+
+    ArchMemoryResidency residency;
+    ASSERT_TRUE(ArchGetMappedMemoryResidency(
+        base, numPages * pageSize, &residency));
+    ASSERT_EQ(residency.pages, numPages);
+    ASSERT_EQ(residency.residentPages, 5u);
+    ASSERT_DOUBLE_EQ(residency.residentRatio, 5.0 / numPages);
+    ASSERT_EQ(residency.runs.size(), 4u);
+    ASSERT_EQ(residency.runs[0].offset, 0u);
+    ASSERT_EQ(residency.runs[0].length, 4 * pageSize);
+    ASSERT_TRUE(residency.runs[0].resident);
+    ASSERT_EQ(residency.runs[1].offset, 4 * pageSize);
+    ASSERT_FALSE(residency.runs[1].resident);
+    ASSERT_EQ(residency.runs[2].offset, 8 * pageSize);
+    ASSERT_EQ(residency.runs[2].length, pageSize);
+    ASSERT_TRUE(residency.runs[2].resident);
+    ASSERT_EQ(residency.runs[3].length, 7 * pageSize);
+
+    // Unaligned ranges are clipped.
+    ASSERT_TRUE(ArchGetMappedMemoryResidency(
+        base + 100, 4 * pageSize, &residency));
+    ASSERT_EQ(residency.pages, 5u);
+    ASSERT_EQ(residency.runs.size(), 2u);
+    ASSERT_EQ(residency.runs[0].length, 4 * pageSize - 100);
+    ASSERT_EQ(residency.runs[1].offset, 4 * pageSize - 100);
+    ASSERT_EQ(residency.runs[1].length, 100u);
+
+    ASSERT_DOUBLE_EQ(ArchEstimateMappedMemoryResidency(
+        base, numPages * pageSize, numPages), 5.0 / numPages);
+    // Sampling the middle of each quarter only hits page 2.
+    ASSERT_DOUBLE_EQ(ArchEstimateMappedMemoryResidency(
+        base, numPages * pageSize, 4), 0.25);
+    ASSERT_DOUBLE_EQ(ArchEstimateMappedMemoryResidency(base, 0), 1.0);
+
+    const ArchMemoryRange ranges[] = {
+        { base + 4 * pageSize, 4 * pageSize },  // Not resident.
+        { base, 4 * pageSize },                 // Resident.
+        { base + 8 * pageSize, 2 * pageSize },  // Half resident.
+        { base + 12 * pageSize, pageSize },     // Not resident.
+    };
+    ASSERT_EQ(ArchOrderByResidency(ranges, 4, /*prefetch=*/false),
+              (std::vector<size_t>{ 1, 2, 0, 3 }));
+    ASSERT_EQ(ArchOrderByResidency(ranges, 4),
+              (std::vector<size_t>{ 1, 2, 0, 3 }));
+
+    munmap(base, numPages * pageSize);
+}
+
+#endif
+
 TEST(FileSystemTest, NormPath)
 {
     ASSERT_EQ(ArchNormPath(""), ".");
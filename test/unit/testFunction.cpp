@@ -8,8 +8,40 @@
 #include <pxr/arch/function.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <string_view>
+
 using namespace pxr;
 
+template <class T>
+struct Widget {
+    template <class U>
+    static std::string_view GetConstantName(U)
+    {
+        static constexpr auto name = ARCH_PRETTIER_FUNCTION_NAME_CONSTANT;
+        return name;
+    }
+
+    template <class U>
+    static const std::string& GetCachedName(U)
+    {
+        return ARCH_PRETTIER_FUNCTION_NAME;
+    }
+
+    template <class U>
+    static std::string GetExpectedName(U)
+    {
+        return ArchGetPrettierFunctionName(
+            __ARCH_FUNCTION__, __ARCH_PRETTY_FUNCTION__);
+    }
+};
+
+static const std::string&
+GetCachedFreeName()
+{
+    return ARCH_PRETTIER_FUNCTION_NAME;
+}
+
 TEST(FunctionTest, GetPrettierFunctionName)
 {
     // Non-member
@@ -84,3 +116,30 @@ TEST(FunctionTest, GetPrettierFunctionName)
         ArchGetPrettierFunctionName("operator<<", "int operator<<(X, int)"),
         "operator<<");
 }
+
+TEST(FunctionTest, PrettierFunctionNameMacros)
+{
+    ASSERT_EQ(GetCachedFreeName(), "GetCachedFreeName");
+
+    // The name is only computed once per call site and instantiation.
+    ASSERT_EQ(&Widget<int>::GetCachedName(1.0),
+              &Widget<int>::GetCachedName(2.0));
+    ASSERT_NE(&Widget<int>::GetCachedName(1.0),
+              &Widget<float>::GetCachedName(1.0));
+
+    static constexpr auto constantName = ARCH_PRETTIER_FUNCTION_NAME_CONSTANT;
+    ASSERT_EQ(std::string_view(constantName),
+              ArchGetPrettierFunctionName(
+                  __ARCH_FUNCTION__, __ARCH_PRETTY_FUNCTION__));
+
+    const std::string expected = Widget<int>::GetExpectedName('a');
+#if !defined(ARCH_OS_WINDOWS)
+    ASSERT_EQ(expected, "Widget<T>::GetExpectedName [with T = int]");
+#endif
+    std::string cachedName = Widget<int>::GetCachedName('a');
+    std::string constantMemberName(Widget<int>::GetConstantName('a'));
+    ASSERT_EQ(cachedName.replace(cachedName.find("Cached"), 6, "Expected"),
+              expected);
+    ASSERT_EQ(constantMemberName.replace(constantMemberName.find("Constant"), 8,
+                                    "Expected"), expected);
+}
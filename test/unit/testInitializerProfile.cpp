@@ -0,0 +1,87 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/attributes.h>
+#include <pxr/arch/fileSystem.h>
+#include <pxr/arch/initializerProfile.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace pxr;
+
+static const int64_t sleepNanoseconds = 5000000;
+
+ARCH_CONSTRUCTOR(TestSlowConstructor, 200, void)
+{
+    std::this_thread::sleep_for(std::chrono::nanoseconds(sleepNanoseconds));
+}
+
+static const ArchInitializerTiming*
+FindTiming(const std::vector<ArchInitializerTiming>& timings,
+           const std::string& name)
+{
+    for (const ArchInitializerTiming& timing : timings) {
+        if (timing.name == name) {
+            return &timing;
+        }
+    }
+    return nullptr;
+}
+
+TEST(InitializerProfileTest, Timings)
+{
+    ASSERT_TRUE(ArchIsInitializerProfilingEnabled());
+
+    const std::vector<ArchInitializerTiming> timings =
+        ArchGetInitializerTimings();
+
+    const ArchInitializerTiming* config = FindTiming(timings, "Arch_InitConfig");
+    ASSERT_NE(config, nullptr);
+    ASSERT_EQ(config->priority, 2);
+    ASSERT_FALSE(config->isDestructor);
+    ASSERT_NE(config->library.find("PxrArch"), std::string::npos)
+        << config->library;
+
+    const ArchInitializerTiming* slow =
+        FindTiming(timings, "TestSlowConstructor");
+    ASSERT_NE(slow, nullptr);
+    ASSERT_EQ(slow->priority, 200);
+    ASSERT_FALSE(slow->isDestructor);
+    ASSERT_GE(slow->nanoseconds, sleepNanoseconds);
+    ASSERT_NE(slow->library.find("testArchInitializerProfile"),
+              std::string::npos) << slow->library;
+
+    // The library is loaded before the executable so its constructors run
+    // first.
+    ASSERT_LT(config, slow);
+}
+
+TEST(InitializerProfileTest, Print)
+{
+    const std::string path = ArchMakeTmpFileName("initializerProfile");
+    FILE* file = ArchOpenFile(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    ArchPrintInitializerTimings(file);
+    fclose(file);
+
+    std::ifstream input(path);
+    std::stringstream contents;
+    contents << input.rdbuf();
+    const std::string report = contents.str();
+    ArchUnlinkFile(path.c_str());
+
+    ASSERT_EQ(report.find("Initializer timings"), 0u) << report;
+    ASSERT_NE(report.find("Arch_InitConfig"), std::string::npos) << report;
+    ASSERT_NE(report.find("TestSlowConstructor"), std::string::npos) << report;
+    ASSERT_NE(report.find("total"), std::string::npos) << report;
+}
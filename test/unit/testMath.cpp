@@ -6,9 +6,16 @@
 // Modified by Jeremy Retailleau.
 
 #include <pxr/arch/math.h>
+#include <pxr/arch/timing.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
 #include <string>
+#include <vector>
 
 using namespace pxr;
 
@@ -66,3 +73,229 @@ TEST(MathTest, CountTrailingZeros)
     ASSERT_EQ(ArchCountTrailingZeros(~((1ull << 32ull) - 1ull)), 32);
     ASSERT_EQ(ArchCountTrailingZeros(1ull << 63ull), 63);
 }
+
+// Returns the error of value in units of the last place of expected, or
+// in multiples of absolute if expected is smaller than threshold.
+template <class T>
+static double
+_Error(T value, long double expected, long double threshold, T absolute)
+{
+    if (std::fabs(expected) < threshold) {
+        return static_cast<double>(std::fabs(value - expected) / absolute);
+    }
+    const T rounded = static_cast<T>(std::fabs(expected));
+    const T ulp = std::nextafter(rounded, std::numeric_limits<T>::max()) -
+        rounded;
+    return static_cast<double>(std::fabs(value - expected) / ulp);
+}
+
+// Overloads dispatching to the double or float functions.
+static void
+_SinCos(const double* values, size_t count, double* sines, double* cosines)
+{
+    ArchSinCos(values, count, sines, cosines);
+}
+
+static void
+_SinCos(const float* values, size_t count, float* sines, float* cosines)
+{
+    ArchSinCosf(values, count, sines, cosines);
+}
+
+static void
+_SinCos(double value, double* sine, double* cosine)
+{
+    ArchSinCos(value, sine, cosine);
+}
+
+static void
+_SinCos(float value, float* sine, float* cosine)
+{
+    ArchSinCosf(value, sine, cosine);
+}
+
+template <class T>
+static void
+_TestSinCosArray(T maxValue, double maxUlp, long double threshold,
+                 T absolute)
+{
+    // Random values, values near the zeros of sine and cosine, and an
+    // odd count so the scalar tail is used.
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<T> distribution(-maxValue, maxValue);
+    std::vector<T> values(100001);
+    for (size_t i = 0; i != values.size(); ++i) {
+        values[i] = i % 2 ? distribution(generator) :
+            static_cast<T>(static_cast<long double>(i / 2 % 1000) *
+                           1.5707963267948966192313216916397514L);
+    }
+
+    std::vector<T> sines(values.size()), cosines(values.size());
+    _SinCos(values.data(), values.size(), sines.data(), cosines.data());
+    for (size_t i = 0; i != values.size(); ++i) {
+        const long double value = values[i];
+        ASSERT_LE(_Error(sines[i], sinl(value), threshold, absolute), maxUlp)
+            << "sin(" << values[i] << ")";
+        ASSERT_LE(_Error(cosines[i], cosl(value), threshold, absolute), maxUlp)
+            << "cos(" << values[i] << ")";
+    }
+
+    // Arguments out of range use the scalar functions.
+    const T special[] = {
+        maxValue * 4, -maxValue * 1000, std::numeric_limits<T>::max(),
+        std::numeric_limits<T>::infinity(),
+        std::numeric_limits<T>::quiet_NaN(), 0, 1, 2
+    };
+    const size_t count = sizeof(special) / sizeof(special[0]);
+    T s[count], c[count];
+    _SinCos(special, count, s, c);
+    for (size_t i = 0; i != 5; ++i) {
+        T expectedSine, expectedCosine;
+        _SinCos(special[i], &expectedSine, &expectedCosine);
+        if (std::isnan(expectedSine)) {
+            ASSERT_TRUE(std::isnan(s[i]));
+            ASSERT_TRUE(std::isnan(c[i]));
+        }
+        else {
+            ASSERT_EQ(s[i], expectedSine);
+            ASSERT_EQ(c[i], expectedCosine);
+        }
+    }
+
+    // Results may overwrite the arguments.
+    T inPlace[count];
+    std::copy(special, special + count, inPlace);
+    _SinCos(inPlace, count, inPlace, c);
+    for (size_t i = 0; i != count; ++i) {
+        if (std::isnan(s[i])) {
+            ASSERT_TRUE(std::isnan(inPlace[i]));
+        }
+        else {
+            ASSERT_EQ(inPlace[i], s[i]);
+        }
+    }
+
+    // The sign of zero and tiny arguments is kept, in vectors and in the
+    // scalar tail.
+    const T tiny[] = { -0.0, 0.0, -std::numeric_limits<T>::denorm_min(),
+                       std::numeric_limits<T>::min(), -0.0 };
+    const size_t tinyCount = sizeof(tiny) / sizeof(tiny[0]);
+    _SinCos(tiny, tinyCount, s, c);
+    for (size_t i = 0; i != tinyCount; ++i) {
+        ASSERT_EQ(s[i], tiny[i]);
+        ASSERT_EQ(std::signbit(s[i]), std::signbit(tiny[i]));
+        ASSERT_EQ(c[i], 1);
+    }
+}
+
+TEST(MathTest, SinCosArray)
+{
+    _TestSinCosArray<double>(823549.0, 2.5, 0x1p-30L, 0x1p-80);
+    _TestSinCosArray<float>(8192.0f, 2.0, 0x1p-12L, 0x1p-24f);
+}
+
+TEST(MathTest, SinCosArrayBenchmark)
+{
+    std::vector<double> values(1 << 20);
+    for (size_t i = 0; i != values.size(); ++i) {
+        values[i] = static_cast<double>(i) * 0.001;
+    }
+    std::vector<double> sines(values.size()), cosines(values.size());
+
+    auto measure = [&](auto&& function) {
+        uint64_t best = std::numeric_limits<uint64_t>::max();
+        for (int i = 0; i != 5; ++i) {
+            ArchIntervalTimer timer;
+            function();
+            best = std::min(best, timer.GetElapsedTicks());
+        }
+        return ArchTicksToNanoseconds(best) / 1e6;
+    };
+
+    const double scalar = measure([&]() {
+        for (size_t i = 0; i != values.size(); ++i) {
+            ArchSinCos(values[i], &sines[i], &cosines[i]);
+        }
+    });
+    const double batch = measure([&]() {
+        ArchSinCos(values.data(), values.size(),
+                   sines.data(), cosines.data());
+    });
+
+    std::cout << "ArchSinCos of " << values.size() << " doubles: scalar "
+              << scalar << " ms, array " << batch << " ms\n";
+}
+
+TEST(MathTest, BitManipulation)
+{
+#if defined(ARCH_COMPILER_GCC) || defined(ARCH_COMPILER_CLANG)
+    static_assert(ArchPopCount(0xffull) == 8, "");
+    static_assert(ArchCountLeadingZeros(1) == 63, "");
+    static_assert(ArchCountTrailingZeros(8) == 3, "");
+    static_assert(ArchByteSwap(uint32_t(0x12345678)) == 0x78563412u, "");
+#endif
+
+    ASSERT_EQ(ArchPopCount(0), 0);
+    ASSERT_EQ(ArchPopCount(1), 1);
+    ASSERT_EQ(ArchPopCount(0x8000000000000001ull), 2);
+    ASSERT_EQ(ArchPopCount(~0ull), 64);
+
+    ASSERT_EQ(ArchCountLeadingZeros(1), 63);
+    ASSERT_EQ(ArchCountLeadingZeros(0xff), 56);
+    ASSERT_EQ(ArchCountLeadingZeros(1ull << 63), 0);
+    ASSERT_EQ(ArchCountLeadingZeros(~0ull), 0);
+
+    ASSERT_EQ(ArchByteSwap(uint16_t(0x1234)), 0x3412);
+    ASSERT_EQ(ArchByteSwap(uint32_t(0x12345678)), 0x78563412u);
+    ASSERT_EQ(ArchByteSwap(uint64_t(0x0123456789abcdefull)),
+              0xefcdab8967452301ull);
+
+    // Unsigned types that aren't one of the fixed width types.
+    const unsigned long long ull = 0x0123456789abcdefull;
+    ASSERT_EQ(ArchByteSwap(ull), 0xefcdab8967452301ull);
+    const unsigned long ul = 0x01234567ul;
+    ASSERT_EQ(ArchByteSwap(ArchByteSwap(ul)), ul);
+    ASSERT_EQ(ArchByteSwap(size_t(1)), size_t(1) << (8 * sizeof(size_t) - 8));
+
+    std::vector<int> bits;
+    ArchForEachSetBit(0x8000000000010005ull,
+                      [&bits](int bit) { bits.push_back(bit); });
+    ASSERT_EQ(bits, std::vector<int>({ 0, 2, 16, 63 }));
+    ArchForEachSetBit(0, [](int) { FAIL(); });
+
+    ASSERT_EQ(ArchDepositBits(0x5, 0xf0), 0x50u);
+    ASSERT_EQ(ArchDepositBits(0x3, 0x8001), 0x8001u);
+    ASSERT_EQ(ArchDepositBits(~0ull, 0), 0u);
+    ASSERT_EQ(ArchExtractBits(0x50, 0xf0), 0x5u);
+    ASSERT_EQ(ArchExtractBits(0x8001, 0x8001), 0x3u);
+    ASSERT_EQ(ArchExtractBits(0x1234, ~0ull), 0x1234u);
+
+    // Depositing then extracting with the same mask recovers the bits.
+    std::mt19937_64 generator(7);
+    for (int i = 0; i != 1000; ++i) {
+        const uint64_t x = generator(), mask = generator();
+        const uint64_t deposited = ArchDepositBits(x, mask);
+        ASSERT_EQ(deposited & ~mask, 0u);
+        const uint64_t low = ArchPopCount(mask) == 64 ?
+            ~0ull : (1ull << ArchPopCount(mask)) - 1;
+        ASSERT_EQ(ArchExtractBits(deposited, mask), x & low);
+    }
+}
+
+TEST(MathTest, PopCountArray)
+{
+    std::mt19937_64 generator(11);
+    std::vector<uint64_t> words(1027);
+    for (uint64_t& word : words) {
+        word = generator();
+    }
+
+    // Lengths around multiples of the vector size.
+    for (size_t count : { 0, 1, 3, 4, 5, 8, 31, 1024, 1027 }) {
+        size_t expected = 0;
+        for (size_t i = 0; i != count; ++i) {
+            expected += ArchPopCount(words[i]);
+        }
+        ASSERT_EQ(ArchPopCount(words.data(), count), expected) << count;
+    }
+}
@@ -0,0 +1,106 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/defines.h>
+#include <pxr/arch/hash.h>
+#include <pxr/arch/profiler.h>
+#include <gtest/gtest.h>
+
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pxr;
+
+// Burns about \p seconds of CPU time in the calling thread.
+static uint64_t
+_BurnCPU(double seconds)
+{
+    std::vector<char> data(4096, 'x');
+    uint64_t result = 0;
+    const std::clock_t start = std::clock();
+    while (double(std::clock() - start) / CLOCKS_PER_SEC < seconds) {
+        for (int i = 0; i != 100; ++i) {
+            result += ArchHash64(data.data(), data.size(), result);
+        }
+    }
+    return result;
+}
+
+#if defined(ARCH_OS_LINUX)
+
+TEST(ProfilerTest, SampleCurrentThread)
+{
+    ASSERT_FALSE(ArchIsProfilerRunning());
+    ASSERT_TRUE(ArchStartProfiler(1000));
+    ASSERT_TRUE(ArchIsProfilerRunning());
+    ASSERT_FALSE(ArchStartProfiler(1000));
+
+    _BurnCPU(0.3);
+
+    ArchStopProfiler();
+    ASSERT_FALSE(ArchIsProfilerRunning());
+    ASSERT_GT(ArchGetProfilerSampleCount(), 0u);
+    ASSERT_EQ(ArchGetProfilerDroppedSampleCount(), 0u);
+
+    std::ostringstream out;
+    ArchWriteProfileFolded(out);
+    const std::string profile = out.str();
+    ASSERT_NE(profile.find("ArchHash64"), std::string::npos) << profile;
+
+    // Every line is a stack followed by a space and a positive count.
+    size_t total = 0;
+    std::istringstream lines(profile);
+    for (std::string line; std::getline(lines, line); ) {
+        const std::string::size_type space = line.rfind(' ');
+        ASSERT_NE(space, std::string::npos);
+        const int count = std::stoi(line.substr(space + 1));
+        ASSERT_GT(count, 0);
+        total += count;
+    }
+    ASSERT_EQ(total, ArchGetProfilerSampleCount());
+}
+
+TEST(ProfilerTest, RegisterThread)
+{
+    ASSERT_FALSE(ArchProfilerRegisterThread());
+    ASSERT_TRUE(ArchStartProfiler(1000));
+
+    bool registered = false;
+    std::thread worker([&registered]() {
+        registered = ArchProfilerRegisterThread();
+        _BurnCPU(0.2);
+    });
+    worker.join();
+
+    ArchStopProfiler();
+    ASSERT_TRUE(registered);
+    ASSERT_GT(ArchGetProfilerSampleCount(), 0u);
+}
+
+TEST(ProfilerTest, DropSamples)
+{
+    ASSERT_TRUE(ArchStartProfiler(1000, 1));
+    _BurnCPU(0.1);
+    ArchStopProfiler();
+
+    ASSERT_EQ(ArchGetProfilerSampleCount(), 1u);
+    ASSERT_GT(ArchGetProfilerDroppedSampleCount(), 0u);
+}
+
+#else
+
+TEST(ProfilerTest, Unsupported)
+{
+    ASSERT_FALSE(ArchStartProfiler(1000));
+    ASSERT_FALSE(ArchIsProfilerRunning());
+    ASSERT_EQ(ArchGetProfilerSampleCount(), 0u);
+}
+
+#endif
@@ -0,0 +1,94 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+#include <pxr/arch/fileSystem.h>
+#include <pxr/arch/signalSafeWriter.h>
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(ARCH_OS_WINDOWS)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace pxr;
+
+// Returns the contents of the file at path.
+static std::string
+_ReadFile(const std::string& path)
+{
+    std::ifstream input(path, std::ios::binary);
+    std::stringstream contents;
+    contents << input.rdbuf();
+    return contents.str();
+}
+
+TEST(SignalSafeWriterTest, Write)
+{
+    std::string path;
+    const int fd = ArchMakeTmpFile("signalSafeWriter", &path);
+    ASSERT_NE(fd, -1);
+
+    const std::string longText(3000, 'x');
+    std::string expected;
+    {
+        ArchSignalSafeWriter writer(fd);
+        writer.Write("Thread ").WriteDecimal(1234).Write(':').Write('\n');
+        expected += "Thread 1234:\n";
+
+        writer.Write(" #").WriteDecimal(7, -3)
+              .Write(" 0x").WriteHex(0xbeef, 16).Write('\n');
+        expected += " #7   0x000000000000beef\n";
+
+        writer.Write(nullptr).WriteDecimal(-42, 5).WriteHex(0).Write('\n');
+        expected += "  -420\n";
+
+        // Long strings are written in place.
+        writer.Write(longText.c_str()).Write('\n');
+        expected += longText + "\n";
+
+        errno = EAGAIN;
+        ASSERT_TRUE(writer.Flush());
+        ASSERT_EQ(errno, EAGAIN);
+
+        // More pieces than the writer holds are flushed early.
+        for (int i = 0; i != 1000; ++i) {
+            writer.WriteDecimal(i).Write(',');
+            expected += std::to_string(i) + ",";
+        }
+        for (int i = 0; i != 100; ++i) {
+            writer.Write(longText.c_str(), 200);
+            expected += longText.substr(0, 200);
+        }
+
+        // The rest is flushed on destruction.
+        writer.Write("end\n");
+        expected += "end\n";
+    }
+    ArchCloseFile(fd);
+
+    ASSERT_EQ(_ReadFile(path), expected);
+    ArchUnlinkFile(path.c_str());
+}
+
+TEST(SignalSafeWriterTest, WriteError)
+{
+    ArchSignalSafeWriter writer(-1);
+    errno = 0;
+    writer.Write("lost\n");
+    ASSERT_FALSE(writer.Flush());
+    ASSERT_EQ(errno, 0);
+
+    // The failure is only reported once.
+    ASSERT_TRUE(writer.Flush());
+}
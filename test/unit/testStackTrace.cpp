@@ -10,8 +10,18 @@
 #include <archTest/util.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cerrno>
 #include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
+
+#if !defined(ARCH_OS_WINDOWS)
+#include <unistd.h>
+#endif
 
 using namespace pxr;
 
@@ -56,6 +66,92 @@ TEST(StackTraceTest, TestCrash)
     ASSERT_TRUE(found);
 }
 
+#if !defined(ARCH_OS_WINDOWS)
+
+TEST(StackTraceTest, CrashHandlerSystemv)
+{
+    // The exit status of the handler is returned.
+    const char* const exitArgv[] = { "/bin/sh", "-c", "exit 3", nullptr };
+    ASSERT_EQ(ArchCrashHandlerSystemv(exitArgv[0], (char *const*)exitArgv,
+                                      10, nullptr, nullptr), 3);
+
+    // A handler that can't be executed returns 127.
+    const char* const missingArgv[] = { "/nonexistent/handler", nullptr };
+    ASSERT_EQ(ArchCrashHandlerSystemv(missingArgv[0],
+                                      (char *const*)missingArgv,
+                                      10, nullptr, nullptr), 127);
+
+    // A handler that takes too long is killed.
+    int calls = 0;
+    const char* const sleepArgv[] = { "/bin/sh", "-c", "exec sleep 30", nullptr };
+    ASSERT_EQ(ArchCrashHandlerSystemv(sleepArgv[0], (char *const*)sleepArgv, 1,
+                                      [](void* calls) { ++*(int*)calls; },
+                                      &calls), -1);
+    ASSERT_EQ(errno, EBUSY);
+    ASSERT_EQ(calls, 1);
+}
+
+#endif
+
+#if defined(ARCH_OS_LINUX)
+
+TEST(StackTraceTest, InProcessCrashReport)
+{
+    ASSERT_FALSE(ArchGetInProcessCrashReporting());
+    ArchSetInProcessCrashReporting(true);
+    ASSERT_TRUE(ArchGetInProcessCrashReporting());
+
+    // Keep a few threads busy so they have to be interrupted.
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int i = 0; i != 3; ++i) {
+        threads.emplace_back([&done]() {
+            while (!done) {
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    const std::string logfile = std::string(ArchGetTmpDir()) + "/st_" +
+        ArchGetProgramNameForErrors() + "." + std::to_string(getpid());
+    ArchUnlinkFile(logfile.c_str());
+
+    ArchLogCurrentProcessState("Test In-Process");
+    ArchSetInProcessCrashReporting(false);
+    ASSERT_FALSE(ArchGetInProcessCrashReporting());
+
+    done = true;
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::ifstream input(logfile);
+    ASSERT_TRUE(input.good()) << logfile;
+    std::stringstream contents;
+    contents << input.rdbuf();
+    const std::string report = contents.str();
+    ArchUnlinkFile(logfile.c_str());
+    ArchUnlinkFile((logfile + ".crash").c_str());
+
+    // Every thread must have been unwound.
+    size_t numThreads = 0;
+    for (size_t pos = report.find("\nThread "); pos != std::string::npos;
+         pos = report.find("\nThread ", pos + 1)) {
+        ++numThreads;
+    }
+    ASSERT_GE(numThreads, 4u) << report;
+    ASSERT_EQ(report.find("<no response>"), std::string::npos) << report;
+    ASSERT_NE(report.find("(reporting):\n #0 0x"), std::string::npos)
+        << report;
+    ASSERT_NE(report.find("Executable mappings:\n"), std::string::npos)
+        << report;
+    ASSERT_NE(report.find("libPxrArch"), std::string::npos) << report;
+    ASSERT_NE(report.find("Crash record: " + logfile + ".crash"),
+              std::string::npos) << report;
+}
+
+#endif
+
 int main(int argc, char** argv)
 {
     ArchSetProgramNameForErrors("testArch ArchError");
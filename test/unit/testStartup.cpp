@@ -0,0 +1,118 @@
+// Copyright 2025 Pixar
+//
+// Licensed under the terms set forth in the LICENSE.txt file available at
+// https://openusd.org/license.
+//
+// Modified by Jeremy Retailleau.
+
+// Measures the time it takes to load the arch library, which is the
+// overhead arch adds between the start of a process and main().  This
+// executable deliberately does not link arch; it runs itself in child
+// processes that each load the library once with dlopen().
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+static std::string executablePath;
+
+#if !defined(_WIN32)
+
+// Loads the arch library, checks that the temporary directory resolves and
+// prints the load time in nanoseconds.
+static int
+LoadLibrary()
+{
+    const char* path = std::getenv("ARCH_LIBRARY");
+    if (!path) {
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    void* handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    const auto stop = std::chrono::steady_clock::now();
+    if (!handle) {
+        fprintf(stderr, "%s\n", dlerror());
+        return 1;
+    }
+
+    using GetTmpDir = const char* (*)();
+    auto getTmpDir =
+        reinterpret_cast<GetTmpDir>(dlsym(handle, "_ZN3pxr13ArchGetTmpDirEv"));
+    if (!getTmpDir || !getTmpDir() || !getTmpDir()[0]) {
+        return 1;
+    }
+
+    printf("%lld\n", static_cast<long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            stop - start).count()));
+    return 0;
+}
+
+// Returns the median load time over \p count child processes, or -1 on
+// failure.
+static long long
+MeasureLoadTime(const std::string& environment, int count)
+{
+    const std::string command =
+        environment + " \"" + executablePath + "\" --load-library";
+
+    std::vector<long long> times;
+    for (int i = 0; i != count; ++i) {
+        FILE* child = popen(command.c_str(), "r");
+        if (!child) {
+            return -1;
+        }
+        long long time = -1;
+        const int matched = fscanf(child, "%lld", &time);
+        if (pclose(child) != 0 || matched != 1) {
+            return -1;
+        }
+        times.push_back(time);
+    }
+
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+TEST(StartupTest, LoadTime)
+{
+    const int count = 15;
+    const long long lazy = MeasureLoadTime("ARCH_EAGER_INIT=0", count);
+    const long long eager = MeasureLoadTime("ARCH_EAGER_INIT=1", count);
+    ASSERT_GT(lazy, 0);
+    ASSERT_GT(eager, 0);
+
+    std::cout << "Median arch load time over " << count << " processes:\n"
+              << "  lazy:  " << lazy / 1000.0 << " us\n"
+              << "  eager: " << eager / 1000.0 << " us\n";
+    RecordProperty("LazyLoadNanoseconds", std::to_string(lazy));
+    RecordProperty("EagerLoadNanoseconds", std::to_string(eager));
+}
+
+#endif
+
+int main(int argc, char** argv)
+{
+    executablePath = argv[0];
+
+#if !defined(_WIN32)
+    if (argc == 2 && strcmp(argv[1], "--load-library") == 0) {
+        return LoadLibrary();
+    }
+#endif
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
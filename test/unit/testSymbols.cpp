@@ -67,3 +67,58 @@ TEST(SymbolsTest, GetAddressInfo)
     ASSERT_TRUE(_GetLibraryPath((void*)&exit, &path));
     ASSERT_NE(GetBasename(path), "testArchSymbols");
 }
+
+#if defined(ARCH_OS_LINUX)
+
+TEST(SymbolsTest, FindModule)
+{
+    ASSERT_EQ(ArchFindModule(nullptr), nullptr);
+    ASSERT_EQ(ArchFindModule(&bss), ArchFindModule((void*)&Code));
+
+    // The module containing this executable's code.
+    const ArchModuleInfo* module = ArchFindModule((void*)&Code);
+    ASSERT_NE(module, nullptr);
+    ASSERT_EQ(GetBasename(module->path), "testArchSymbols");
+    ASSERT_LE(module->baseAddress, reinterpret_cast<uintptr_t>(&Code));
+
+    bool found = false;
+    for (const ArchModuleInfo::Segment& segment : module->segments) {
+        if (segment.start <= reinterpret_cast<uintptr_t>(&Code) &&
+            reinterpret_cast<uintptr_t>(&Code) < segment.end) {
+            ASSERT_TRUE(segment.executable);
+            found = true;
+        }
+    }
+    ASSERT_TRUE(found);
+
+    // Another module gives the same answer as the dynamic loader.
+    const ArchModuleInfo* other = ArchFindModule((void*)&exit);
+    ASSERT_NE(other, nullptr);
+    ASSERT_NE(other, module);
+    void* baseAddress = nullptr;
+    std::string path;
+    ASSERT_TRUE(ArchGetAddressInfo((void*)&exit, &path, &baseAddress,
+                                   nullptr, nullptr));
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(baseAddress), other->baseAddress);
+
+    // The registry lists every module once, in address order.
+    const std::vector<ArchModuleInfo> modules = ArchGetLoadedModules();
+    ASSERT_GE(modules.size(), 2u);
+    for (size_t i = 1; i < modules.size(); ++i) {
+        ASSERT_LT(modules[i - 1].baseAddress, modules[i].baseAddress);
+    }
+    for (const ArchModuleInfo& info : modules) {
+        ASSERT_TRUE(info.buildId.size() % 2 == 0) << info.buildId;
+        ASSERT_EQ(info.buildId.find_first_not_of("0123456789abcdef"),
+                  std::string::npos) << info.buildId;
+    }
+
+    // Modules found before a refresh remain valid.
+    ArchRefreshModuleRegistry();
+    ASSERT_EQ(GetBasename(module->path), "testArchSymbols");
+    ASSERT_EQ(GetBasename(ArchFindModule((void*)&Code)->path),
+              "testArchSymbols");
+}
+
+#endif
+
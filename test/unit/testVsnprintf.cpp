@@ -9,6 +9,7 @@
 #include <gtest/gtest.h>
 
 #include <cstdlib>
+#include <limits>
 #include <string>
 
 using namespace pxr;
@@ -42,3 +43,73 @@ TEST(VsnprintfTest, Print)
 
     ASSERT_EQ(ArchStringPrintf("%s", long_fmt).size(), 8191);
 }
+
+TEST(VsnprintfTest, FormatBuffer)
+{
+    ArchFormatBuffer buffer;
+    buffer.Append(" #").AppendDecimal(7, -3)
+          .Append(" 0x").AppendHex(0xbeef, 16)
+          .Append(" in ").Append(std::string("main"));
+    ASSERT_EQ(buffer.GetString(),
+              ArchStringPrintf(" #%-3i 0x%016lx in %s", 7, 0xbeefUL, "main"));
+
+    // Integer conversions match printf().
+    const long long values[] = {
+        0, 1, -1, 9, 10, 99, 100, -12345, 1234567890123LL,
+        std::numeric_limits<long long>::min(),
+        std::numeric_limits<long long>::max()
+    };
+    for (long long value : values) {
+        for (int width : { 0, 5, -5, 25 }) {
+            buffer.Clear();
+            buffer.AppendDecimal(value, width);
+            ASSERT_EQ(buffer.GetString(),
+                      ArchStringPrintf("%*lld", width, value));
+        }
+        buffer.Clear();
+        buffer.AppendUnsigned(static_cast<unsigned long long>(value));
+        ASSERT_EQ(buffer.GetString(), ArchStringPrintf(
+            "%llu", static_cast<unsigned long long>(value)));
+        for (int digits : { 1, 8, 20 }) {
+            buffer.Clear();
+            buffer.AppendHex(static_cast<unsigned long long>(value), digits);
+            ASSERT_EQ(buffer.GetString(), ArchStringPrintf(
+                "%0*llx", digits, static_cast<unsigned long long>(value)));
+        }
+    }
+
+    // Growing past the inline storage.
+    buffer.Clear();
+    std::string expected;
+    for (int i = 0; i != 1000; ++i) {
+        buffer.AppendDecimal(i).AppendPrintf("%c", ',');
+        expected += std::to_string(i) + ",";
+    }
+    ASSERT_EQ(buffer.GetString(), expected);
+    ASSERT_EQ(buffer.GetSize(), expected.size());
+    ASSERT_FALSE(buffer.IsTruncated());
+
+    const std::string long_string(5000, 'x');
+    buffer.Clear();
+    buffer.AppendPrintf("<%s>", long_string.c_str());
+    ASSERT_EQ(buffer.GetString(), "<" + long_string + ">");
+}
+
+TEST(VsnprintfTest, FormatBufferCallerStorage)
+{
+    char storage[8];
+    ArchFormatBuffer buffer(storage, sizeof(storage));
+    buffer.Append("abc").AppendHex(0x12);
+    ASSERT_STREQ(storage, "abc12");
+    ASSERT_FALSE(buffer.IsTruncated());
+
+    buffer.AppendDecimal(12345);
+    ASSERT_STREQ(storage, "abc1212");
+    ASSERT_EQ(buffer.GetSize(), 7u);
+    ASSERT_TRUE(buffer.IsTruncated());
+
+    buffer.Clear();
+    buffer.AppendPrintf("%d-%d", 1234, 5678);
+    ASSERT_STREQ(storage, "1234-56");
+    ASSERT_TRUE(buffer.IsTruncated());
+}